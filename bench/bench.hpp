@@ -0,0 +1,69 @@
+#pragma once
+#include <krnl.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace krnl::bench {
+
+    using Clock = std::chrono::steady_clock;
+
+    inline double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct Context {
+        const Instance& instance;
+        // Run on the CPU fallback adapter (SwiftShader) so results are comparable on GPU-less machines
+        bool cpu = false;
+        // Benchmarks that profile write their Chrome trace here when set (--trace)
+        std::string tracePath;
+
+        DeviceOptions deviceOptions() const {
+            DeviceOptions options;
+            options.forceFallbackAdapter = cpu;
+            return options;
+        }
+    };
+
+    // Block until everything submitted to the device's queue has executed.
+    inline void WaitIdle(const Context& ctx, const Device& device) {
+        device.Flush();
+        wgpu::Future f = device.getQueue().OnSubmittedWorkDone(
+            wgpu::CallbackMode::WaitAnyOnly,
+            [](wgpu::QueueWorkDoneStatus, wgpu::StringView) {});
+        ctx.instance.WaitAny(f, UINT64_MAX);
+    }
+
+    using BenchmarkFn = void (*)(Context&);
+
+    struct Benchmark {
+        const char* name;
+        BenchmarkFn fn;
+    };
+
+    std::vector<Benchmark>& Registry();
+
+    struct Registrar {
+        Registrar(const char* name, BenchmarkFn fn) { Registry().push_back({ name, fn }); }
+    };
+
+    struct Result {
+        std::string benchmark;
+        std::string metric;
+        double value = 0.0;
+        std::string unit;
+    };
+
+    // Record one measurement of the running benchmark.
+    void Report(const std::string& benchmark, const std::string& metric, double value, const char* unit);
+    // Everything reported so far, in order
+    const std::vector<Result>& Results();
+
+} // namespace krnl::bench
+
+#define KRNL_BENCHMARK(name) \
+    static void name(krnl::bench::Context& ctx); \
+    static krnl::bench::Registrar name##_registrar(#name, name); \
+    static void name(krnl::bench::Context& ctx)
@@ -0,0 +1,67 @@
+#include "bench.hpp"
+
+#include <optional>
+#include <random>
+#include <vector>
+
+// Cost of creating many small tensors with dedicated CreateBuffer calls versus
+// Buffer::Suballocate, plus the allocator's fragmentation after a churn phase.
+
+namespace {
+
+    constexpr size_t kAllocations = 4096;
+
+    std::vector<size_t> makeSizes() {
+        std::mt19937 rng(42);
+        std::vector<size_t> sizes(kAllocations);
+        for (auto& s : sizes) {
+            // Mostly small tensors with a tail of larger ones (256 B .. 1 MB)
+            s = (rng() % 8 == 0) ? (64u << 10) + rng() % (960u << 10) : 256 + rng() % (16u << 10);
+        }
+        return sizes;
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(buffer_allocation)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopyDst | krnl::BufferUsageType::CopySrc;
+    const std::vector<size_t> sizes = makeSizes();
+
+    {
+        std::vector<krnl::Buffer> buffers;
+        buffers.reserve(kAllocations);
+        auto start = krnl::bench::Clock::now();
+        for (size_t s : sizes)
+            buffers.emplace_back(device, s, usage, "bench_dedicated");
+        double ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("buffer_allocation", "create_buffer.ns_per_alloc", ms * 1e6 / kAllocations, "ns");
+    }
+
+    // Buffer holds a Device reference and is not assignable; optional lets the churn phase replace entries.
+    std::vector<std::optional<krnl::Buffer>> buffers;
+    buffers.reserve(kAllocations);
+    auto start = krnl::bench::Clock::now();
+    for (size_t s : sizes)
+        buffers.emplace_back(krnl::Buffer::Suballocate(device, s, usage, "bench_suballocated"));
+    double ms = krnl::bench::ElapsedMs(start);
+    krnl::bench::Report("buffer_allocation", "suballocate.ns_per_alloc", ms * 1e6 / kAllocations, "ns");
+
+    // Churn: free every other buffer and refill with different sizes.
+    std::mt19937 rng(7);
+    start = krnl::bench::Clock::now();
+    size_t churned = 0;
+    for (size_t i = 0; i < buffers.size(); i += 2, ++churned)
+        buffers[i].emplace(krnl::Buffer::Suballocate(device, 256 + rng() % (32u << 10), usage, "bench_churn"));
+    ms = krnl::bench::ElapsedMs(start);
+    krnl::bench::Report("buffer_allocation", "churn.ns_per_free_alloc", ms * 1e6 / churned, "ns");
+
+    auto stats = device.GetAllocator().GetStats();
+    krnl::bench::Report("buffer_allocation", "live_allocations", static_cast<double>(stats.liveAllocations), "");
+    krnl::bench::Report("buffer_allocation", "heap_blocks", static_cast<double>(stats.heapBlocks), "");
+    krnl::bench::Report("buffer_allocation", "reserved_mb", stats.reservedBytes / 1048576.0, "MB");
+    krnl::bench::Report("buffer_allocation", "requested_mb", stats.requestedBytes / 1048576.0, "MB");
+    krnl::bench::Report("buffer_allocation", "internal_fragmentation", stats.internalFragmentation() * 100.0, "%");
+    krnl::bench::Report("buffer_allocation", "external_fragmentation", stats.externalFragmentation() * 100.0, "%");
+}
@@ -0,0 +1,166 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// krnl::Autotuner on c = a + b over f32 arrays, with variants over workgroup size (64, 128,
+// 256), elements per thread (1, 4) and scalar or vec4 access:
+// - tune_ms: first Select for the size bucket, which times every variant
+// - cached_select_ms: Select from a second tuner that loaded the results file (no tuning)
+// - chosen / baseline GB/s, against the one-thread-per-workgroup launch add.wgsl used to
+//   have and the 64-wide default it has now
+// - the chosen variant's workgroup size, elements per thread and vec4 flag
+// Results go to a private file under the cache root, removed before and after.
+
+namespace {
+
+    struct AddVariant {
+        uint32_t workgroupSize;
+        uint32_t elementsPerThread;
+        bool vec4;
+
+        std::string Name() const {
+            return "wg" + std::to_string(workgroupSize) + "_ept" + std::to_string(elementsPerThread) + (vec4 ? "_vec4" : "");
+        }
+        // Elements one workgroup covers
+        uint64_t Block() const { return uint64_t(workgroupSize) * elementsPerThread * (vec4 ? 4 : 1); }
+    };
+
+    // Workgroup size and elements per thread are override constants; only the element type
+    // needs a second shader
+    std::string addSource(bool vec4) {
+        return std::string("alias T = ") + (vec4 ? "vec4<f32>" : "f32") + ";\n" + R"(
+            override WORKGROUP_SIZE : u32 = 64;
+            override ELEMENTS_PER_THREAD : u32 = 1;
+
+            @group(0) @binding(0) var<storage, read> a : array<T>;
+            @group(0) @binding(1) var<storage, read> b : array<T>;
+            @group(0) @binding(2) var<storage, read_write> c : array<T>;
+
+            @compute @workgroup_size(WORKGROUP_SIZE)
+            fn main(@builtin(workgroup_id) wid : vec3<u32>,
+                    @builtin(num_workgroups) groups : vec3<u32>,
+                    @builtin(local_invocation_index) lid : u32) {
+                let base = (wid.y * groups.x + wid.x) * WORKGROUP_SIZE * ELEMENTS_PER_THREAD + lid;
+                let count = arrayLength(&c);
+                for (var j = 0u; j < ELEMENTS_PER_THREAD; j = j + 1u) {
+                    let i = base + j * WORKGROUP_SIZE;
+                    if (i < count) {
+                        c[i] = a[i] + b[i];
+                    }
+                }
+            }
+        )";
+    }
+
+    const auto kStorage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    // Pipelines and variants for one problem size; the variants point into pipelines
+    struct AddCandidates {
+        std::vector<AddVariant> configs;
+        std::vector<krnl::Pipeline> pipelines;
+        std::vector<krnl::Autotuner::Variant> variants;
+    };
+
+    void buildCandidates(krnl::Device& device, const krnl::ParameterSet& params, uint64_t count, AddCandidates& out) {
+        out.configs.push_back({ 1, 1, false });    // add.wgsl's old launch
+        for (uint32_t wg : { 64u, 128u, 256u })
+            for (uint32_t ept : { 1u, 4u })
+                for (bool vec4 : { false, true })
+                    out.configs.push_back({ wg, ept, vec4 });
+
+        const krnl::Shader scalar = krnl::Shader::loadWGSL(device, addSource(false));
+        const krnl::Shader vec4 = krnl::Shader::loadWGSL(device, addSource(true));
+        const uint32_t maxGroups = device.GetLimits().maxComputeWorkgroupsPerDimension;
+        out.pipelines.reserve(out.configs.size());
+        for (const AddVariant& config : out.configs) {
+            const std::string label = "bench_autotune_" + config.Name();
+            const krnl::PipelineConstants constants = {
+                { "WORKGROUP_SIZE", double(config.workgroupSize) },
+                { "ELEMENTS_PER_THREAD", double(config.elementsPerThread) },
+            };
+            const krnl::Pipeline* pipeline = &out.pipelines.emplace_back(krnl::Pipeline::CreateCompute(
+                device, config.vec4 ? vec4 : scalar, params, "main", label.c_str(), constants));
+            const uint64_t groups = (count + config.Block() - 1) / config.Block();
+            const uint32_t x = static_cast<uint32_t>(std::min<uint64_t>(groups, maxGroups));
+            const uint32_t y = static_cast<uint32_t>((groups + x - 1) / x);
+            out.variants.push_back({ config.Name(), [pipeline, x, y](krnl::CommandList& cmd) {
+                cmd.BeginComputePass();
+                pipeline->encodeDispatch(cmd, x, y);
+                cmd.EndComputePass();
+            } });
+        }
+    }
+
+    double gbps(uint64_t count, double ms) {
+        return 3.0 * count * sizeof(float) / 1e9 / (ms / 1e3);
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(autotune)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const std::filesystem::path file = krnl::DiskCache::DefaultRoot() / "bench_autotune.txt";
+    krnl::Autotuner tuner(file);
+    tuner.Clear();
+
+    for (uint64_t count : { uint64_t(1) << 16, uint64_t(1) << 20, uint64_t(1) << 22 }) {
+        const size_t bytes = count * sizeof(float);
+        krnl::Buffer a(device, bytes, kStorage, "bench_autotune_a");
+        krnl::Buffer b(device, bytes, kStorage, "bench_autotune_b");
+        krnl::Buffer c(device, bytes, kStorage, "bench_autotune_c");
+        std::vector<float> host(count, 1.0f);
+        a.WriteBuffer(host.data(), bytes);
+        b.WriteBuffer(host.data(), bytes);
+
+        std::vector<krnl::ParameterSet::Entry> entries;
+        entries.push_back({ a, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ b, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ c, krnl::BufferBindingType::Storage });
+        krnl::ParameterSet params(device, entries);
+        AddCandidates candidates;
+        buildCandidates(device, params, count, candidates);
+        krnl::bench::WaitIdle(ctx, device);
+
+        const std::string bucket = krnl::Autotuner::SizeBucket({ count });
+        const std::string suffix = "." + std::to_string(count);
+        auto start = krnl::bench::Clock::now();
+        const std::string chosen = tuner.Select(device, "bench_add", bucket, candidates.variants).value_or("");
+        krnl::bench::Report("autotune", "tune_ms" + suffix, krnl::bench::ElapsedMs(start), "ms");
+
+        // A later run: a fresh tuner reads the file and never times anything
+        krnl::Autotuner reloaded(file);
+        start = krnl::bench::Clock::now();
+        const std::string cached = reloaded.Select(device, "bench_add", bucket, candidates.variants).value_or("");
+        krnl::bench::Report("autotune", "cached_select_ms" + suffix, krnl::bench::ElapsedMs(start), "ms");
+        if (cached != chosen)
+            krnl::bench::Report("autotune", "cache_mismatch" + suffix, 1.0, "");
+
+        double chosenMs = 0.0, oldMs = 0.0, defaultMs = 0.0;
+        for (const krnl::Autotuner::Measurement& m : tuner.Measure(device, candidates.variants)) {
+            if (m.variant == chosen)
+                chosenMs = m.ms;
+            if (m.variant == "wg1_ept1")
+                oldMs = m.ms;
+            if (m.variant == "wg64_ept1")
+                defaultMs = m.ms;
+        }
+        krnl::bench::Report("autotune", "chosen_gbps" + suffix, gbps(count, chosenMs), "GB/s");
+        // The winner as numbers, so the metric names stay the same from run to run
+        for (const AddVariant& config : candidates.configs) {
+            if (config.Name() != chosen)
+                continue;
+            krnl::bench::Report("autotune", "chosen_workgroup_size" + suffix, config.workgroupSize, "");
+            krnl::bench::Report("autotune", "chosen_elements_per_thread" + suffix, config.elementsPerThread, "");
+            krnl::bench::Report("autotune", "chosen_vec4" + suffix, config.vec4 ? 1.0 : 0.0, "");
+        }
+        krnl::bench::Report("autotune", "wg1_gbps" + suffix, gbps(count, oldMs), "GB/s");
+        krnl::bench::Report("autotune", "wg64_gbps" + suffix, gbps(count, defaultMs), "GB/s");
+        krnl::bench::Report("autotune", "speedup_vs_wg1" + suffix, oldMs / chosenMs, "x");
+        krnl::bench::Report("autotune", "speedup_vs_wg64" + suffix, defaultMs / chosenMs, "x");
+    }
+    tuner.Clear();
+}
@@ -0,0 +1,138 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+// Host cost of waiting for the GPU: the caller spinning on ProcessEvents (what the
+// sandbox used to do) versus an Instance with the background event pump. Reports CPU
+// use while idle and the time from submit to the readback callback.
+
+namespace {
+
+    constexpr int kIdleMs = 500;
+    constexpr size_t kRounds = 200;
+
+    // Process CPU time (std::clock), as a percentage of one core over the wall time
+    double cpuPercent(std::clock_t cpuStart, krnl::bench::Clock::time_point wallStart) {
+        double cpuMs = 1000.0 * double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        return 100.0 * cpuMs / krnl::bench::ElapsedMs(wallStart);
+    }
+
+    double median(std::vector<double>& v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(event_pump)
+{
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+    std::vector<uint8_t> fill(256, 1);
+
+    // Polling: the caller drives ProcessEvents itself
+    {
+        krnl::Device device(ctx.instance, ctx.deviceOptions());
+        krnl::Buffer src(device, fill.size(), usage, "bench_events_src");
+        src.WriteBuffer(fill.data(), fill.size());
+
+        auto wall = krnl::bench::Clock::now();
+        std::clock_t cpu = std::clock();
+        while (krnl::bench::ElapsedMs(wall) < kIdleMs)
+            ctx.instance.ProcessEvents();
+        krnl::bench::Report("event_pump", "polling.idle_cpu", cpuPercent(cpu, wall), "%");
+
+        std::vector<double> latency;
+        for (size_t i = 0; i < kRounds; ++i) {
+            std::atomic<bool> fired{ false };
+            auto start = krnl::bench::Clock::now();
+            double us = 0;
+            src.ReadAsync([&](const void*, size_t) {
+                us = krnl::bench::ElapsedMs(start) * 1e3;
+                fired = true;
+            });
+            while (!fired)
+                ctx.instance.ProcessEvents();
+            latency.push_back(us);
+        }
+        krnl::bench::Report("event_pump", "polling.callback_latency_p50", median(latency), "us");
+    }
+
+    // Event pump: the caller sleeps in Instance::Wait
+    {
+        krnl::InstanceOptions options;
+        options.eventPump = true;
+        krnl::Instance pumped(options);
+        krnl::Device device(pumped, ctx.deviceOptions());
+        krnl::Buffer src(device, fill.size(), usage, "bench_events_src");
+        src.WriteBuffer(fill.data(), fill.size());
+
+        auto wall = krnl::bench::Clock::now();
+        std::clock_t cpu = std::clock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(kIdleMs));
+        krnl::bench::Report("event_pump", "pump.idle_cpu", cpuPercent(cpu, wall), "%");
+
+        std::vector<double> latency;
+        std::vector<double> wakeup;
+        for (size_t i = 0; i < kRounds; ++i) {
+            std::atomic<double> us{ 0 };
+            auto start = krnl::bench::Clock::now();
+            krnl::Future f = src.ReadAsync([&](const void*, size_t) {
+                us = krnl::bench::ElapsedMs(start) * 1e3;
+            });
+            pumped.Wait(f);
+            wakeup.push_back(krnl::bench::ElapsedMs(start) * 1e3);
+            latency.push_back(us);
+        }
+        krnl::bench::Report("event_pump", "pump.callback_latency_p50", median(latency), "us");
+        krnl::bench::Report("event_pump", "pump.wait_return_p50", median(wakeup), "us");
+    }
+}
+
+// Many independent upload -> readback requests: one blocking wait per request versus
+// chaining each with Future::Then and waiting once on WhenAll.
+KRNL_BENCHMARK(future_chain)
+{
+    constexpr size_t kRequests = 256;
+    constexpr size_t kBytes = 4096;
+
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    std::vector<krnl::Buffer> buffers;
+    buffers.reserve(kRequests);
+    for (size_t i = 0; i < kRequests; ++i)
+        buffers.push_back(krnl::Buffer::Suballocate(device, kBytes, usage, "bench_chain"));
+    std::vector<uint8_t> payload(kBytes, 0x42);
+
+    auto start = krnl::bench::Clock::now();
+    size_t ok = 0;
+    for (auto& b : buffers) {
+        b.WriteBuffer(payload.data(), payload.size());
+        auto f = b.ReadAsync();
+        ctx.instance.Wait(f);
+        ok += f.Get().size() == kBytes;
+    }
+    double ms = krnl::bench::ElapsedMs(start);
+    krnl::bench::Report("future_chain", "blocking_per_request", ms * 1e3 / kRequests, "us/request");
+
+    start = krnl::bench::Clock::now();
+    std::vector<krnl::Future<size_t>> chains;
+    chains.reserve(kRequests);
+    for (auto& b : buffers) {
+        b.WriteBuffer(payload.data(), payload.size());
+        chains.push_back(b.ReadAsync().Then([](const std::vector<std::byte>& bytes) { return bytes.size(); }));
+    }
+    auto all = krnl::WhenAll(chains);
+    ctx.instance.Wait(all);
+    ms = krnl::bench::ElapsedMs(start);
+    krnl::bench::Report("future_chain", "pipelined_then", ms * 1e3 / kRequests, "us/request");
+
+    for (size_t size : all.Get())
+        ok += size == kBytes;
+    if (ok != 2 * kRequests)
+        krnl::bench::Report("future_chain", "failed_requests", double(2 * kRequests - ok), "");
+}
@@ -0,0 +1,102 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Elementwise chains x = ((a * b) + c) * b ... of 2, 4 and 8 ops over f32 arrays, run
+// eagerly (TensorOps::Binary, one kernel and one full intermediate per op) and as one
+// krnl::Expr fused kernel:
+// - eager / fused ms per chain and the speedup
+// - traffic_ratio: bytes the eager chain moves per byte the fused kernel moves (3 per op
+//   against reading a, b, c and writing the result once), the speedup a memory-bound GPU
+//   should approach
+// - max_abs_error of the fused result against the eager one
+// The fused expression is rebuilt every iteration, so its cost includes the structure
+// lookup that finds the cached kernel.
+
+namespace {
+
+    constexpr int kIterations = 10;
+
+    krnl::Tensor eagerChain(krnl::CommandList& cmd, int ops, const krnl::Tensor& a, const krnl::Tensor& b, const krnl::Tensor& c) {
+        krnl::Tensor x = a;
+        for (int k = 0; k < ops; ++k)
+            x = krnl::TensorOps::Binary(cmd, k % 2 == 0 ? krnl::BinaryOp::Mul : krnl::BinaryOp::Add, x, k % 2 == 0 ? b : c);
+        return x;
+    }
+
+    krnl::Expr fusedChain(int ops, const krnl::Tensor& a, const krnl::Tensor& b, const krnl::Tensor& c) {
+        krnl::Expr x = a;
+        for (int k = 0; k < ops; ++k)
+            x = k % 2 == 0 ? x * b : x + c;
+        return x;
+    }
+
+    template<typename ChainFn>
+    double chainMs(krnl::bench::Context& ctx, krnl::Device& device, ChainFn chain) {
+        // Warm-up compiles the kernels
+        {
+            krnl::CommandList cmd(device);
+            chain(cmd);
+            cmd.Submit();
+        }
+        krnl::bench::WaitIdle(ctx, device);
+
+        // One list per chain: a list keeps its intermediates alive until it is destroyed
+        auto start = krnl::bench::Clock::now();
+        for (int i = 0; i < kIterations; ++i) {
+            krnl::CommandList cmd(device);
+            chain(cmd);
+            cmd.Submit();
+        }
+        krnl::bench::WaitIdle(ctx, device);
+        return krnl::bench::ElapsedMs(start) / kIterations;
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(fusion)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const size_t n = ctx.cpu ? size_t(1) << 20 : size_t(1) << 22;
+
+    std::vector<float> ha(n), hb(n), hc(n);
+    for (size_t i = 0; i < n; ++i) {
+        ha[i] = float(i % 1024) / 1024.0f;
+        hb[i] = 1.0f + float(i % 7) / 64.0f;
+        hc[i] = float(i % 5) * 0.25f - 0.5f;
+    }
+    krnl::Tensor a = krnl::Tensor::FromHost(device, ha, { n }, "bench_fusion_a");
+    krnl::Tensor b = krnl::Tensor::FromHost(device, hb, { n }, "bench_fusion_b");
+    krnl::Tensor c = krnl::Tensor::FromHost(device, hc, { n }, "bench_fusion_c");
+
+    for (int ops : { 2, 4, 8 }) {
+        const std::string suffix = "." + std::to_string(ops) + "ops";
+        const double eager = chainMs(ctx, device, [&](krnl::CommandList& cmd) { eagerChain(cmd, ops, a, b, c); });
+        const double fused = chainMs(ctx, device, [&](krnl::CommandList& cmd) { fusedChain(ops, a, b, c).Eval(cmd); });
+        krnl::bench::Report("fusion", "eager_ms" + suffix, eager, "ms");
+        krnl::bench::Report("fusion", "fused_ms" + suffix, fused, "ms");
+        krnl::bench::Report("fusion", "speedup" + suffix, eager / fused, "x");
+        krnl::bench::Report("fusion", "traffic_ratio" + suffix, 3.0 * ops / 4.0, "x");
+
+        const std::vector<float> expected = [&] {
+            krnl::CommandList cmd(device);
+            krnl::Tensor t = eagerChain(cmd, ops, a, b, c);
+            cmd.Submit();
+            return t.ToHost<float>();
+        }();
+        const std::vector<float> actual = fusedChain(ops, a, b, c).Eval().ToHost<float>();
+        if (expected.size() != n || actual.size() != n) {
+            krnl::bench::Report("fusion", "wrong_result" + suffix, 1.0, "");
+            continue;
+        }
+        double maxError = 0.0;
+        for (size_t i = 0; i < n; ++i)
+            maxError = std::max(maxError, double(std::abs(expected[i] - actual[i])));
+        krnl::bench::Report("fusion", "max_abs_error" + suffix, maxError, "");
+        if (maxError > 1e-3)
+            krnl::bench::Report("fusion", "wrong_result" + suffix, maxError, "");
+    }
+}
@@ -0,0 +1,177 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// TensorOps::MatMul against the naive kernel it replaces (one thread per output element,
+// every operand read straight from storage), on square f32 matrices:
+// - naive / tuned GFLOP/s and the speedup, tuned with a transposed A (Transpose view)
+// - every GemmConfig candidate at 512
+// - max relative error of the tuned result against a CPU reference on sampled rows
+// Tuning runs before the timed section.
+
+namespace {
+
+    const char* kNaive = R"(
+        struct Meta { M : u32, N : u32, K : u32 };
+
+        @group(0) @binding(0) var<storage, read> A : array<f32>;
+        @group(0) @binding(1) var<storage, read> B : array<f32>;
+        @group(0) @binding(2) var<storage, read_write> Out : array<f32>;
+        @group(0) @binding(3) var<uniform> dims : Meta;
+
+        @compute @workgroup_size(8, 8)
+        fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
+            let row = gid.y;
+            let col = gid.x;
+            if (row >= dims.M || col >= dims.N) {
+                return;
+            }
+            var sum = 0.0;
+            for (var k = 0u; k < dims.K; k = k + 1u) {
+                sum = sum + A[row * dims.K + k] * B[k * dims.N + col];
+            }
+            Out[row * dims.N + col] = sum;
+        }
+    )";
+
+    const auto kStorage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    int iterationsFor(uint32_t n) {
+        // Fewer repetitions for large sizes so the CPU adapter finishes in seconds
+        return std::max(1, int((256u * 256u * 256u * 8u) / (n * n * n)));
+    }
+
+    double gflops(uint32_t n, int iterations, double ms) {
+        return 2.0 * double(n) * n * n * iterations / 1e9 / (ms / 1e3);
+    }
+
+    double naiveGflops(krnl::bench::Context& ctx, krnl::Device& device, uint32_t n, const std::vector<float>& ha, const std::vector<float>& hb) {
+        const size_t bytes = size_t(n) * n * sizeof(float);
+        krnl::Buffer a(device, bytes, kStorage, "bench_naive_a");
+        krnl::Buffer b(device, bytes, kStorage, "bench_naive_b");
+        krnl::Buffer c(device, bytes, kStorage, "bench_naive_c");
+        krnl::Buffer dims(device, 16, krnl::BufferUsageType::Uniform | krnl::BufferUsageType::CopyDst, "bench_naive_dims");
+        a.WriteBuffer(ha.data(), bytes);
+        b.WriteBuffer(hb.data(), bytes);
+        uint32_t dimsData[4] = { n, n, n, 0 };
+        dims.WriteBuffer(dimsData, sizeof(dimsData));
+
+        std::vector<krnl::ParameterSet::Entry> entries;
+        entries.push_back({ a, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ b, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ c, krnl::BufferBindingType::Storage });
+        entries.push_back({ dims, krnl::BufferBindingType::Uniform });
+        krnl::ParameterSet params(device, entries);
+        krnl::Shader shader = krnl::Shader::loadWGSL(device, kNaive);
+        auto pipeline = krnl::Pipeline::CreateCompute(device, shader, params, "main", "bench_gemm_naive");
+
+        const uint32_t groups = (n + 7) / 8;
+        auto run = [&](int repeat) {
+            krnl::CommandList cmd(device);
+            cmd.BeginComputePass();
+            for (int i = 0; i < repeat; ++i)
+                pipeline.encodeDispatch(cmd, groups, groups);
+            cmd.EndComputePass();
+            cmd.Submit();
+            krnl::bench::WaitIdle(ctx, device);
+        };
+
+        run(1);
+        const int iterations = iterationsFor(n);
+        auto start = krnl::bench::Clock::now();
+        run(iterations);
+        return gflops(n, iterations, krnl::bench::ElapsedMs(start));
+    }
+
+    template<typename MatMulFn>
+    double tensorGflops(krnl::bench::Context& ctx, krnl::Device& device, uint32_t n, MatMulFn matmul) {
+        // Warm-up: compiles, and tunes on the first call for this problem class
+        {
+            krnl::CommandList cmd(device);
+            matmul(cmd);
+            cmd.Submit();
+        }
+        krnl::bench::WaitIdle(ctx, device);
+
+        const int iterations = iterationsFor(n);
+        auto start = krnl::bench::Clock::now();
+        {
+            krnl::CommandList cmd(device);
+            for (int i = 0; i < iterations; ++i)
+                matmul(cmd);
+            cmd.Submit();
+        }
+        krnl::bench::WaitIdle(ctx, device);
+        return gflops(n, iterations, krnl::bench::ElapsedMs(start));
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(gemm)
+{
+    // The larger tiles need more invocations and workgroup storage than the default limits
+    krnl::DeviceOptions options = ctx.deviceOptions();
+    options.requestAdapterLimits = true;
+    krnl::Device device(ctx.instance, options);
+
+    for (uint32_t n : { 256u, 512u, 1024u }) {
+        const size_t count = size_t(n) * n;
+        std::vector<float> ha(count), hb(count), haT(count);
+        for (size_t i = 0; i < count; ++i) {
+            ha[i] = float(i % 7) * 0.25f - 0.5f;
+            hb[i] = float(i % 5) * 0.5f - 1.0f;
+        }
+        for (uint32_t r = 0; r < n; ++r)
+            for (uint32_t k = 0; k < n; ++k)
+                haT[size_t(k) * n + r] = ha[size_t(r) * n + k];
+
+        krnl::Tensor a = krnl::Tensor::FromHost(device, ha, { n, n }, "bench_gemm_a");
+        krnl::Tensor b = krnl::Tensor::FromHost(device, hb, { n, n }, "bench_gemm_b");
+        // Same matrix as a, stored transposed: the view reads it column-major
+        krnl::Tensor aT = krnl::Tensor::FromHost(device, haT, { n, n }, "bench_gemm_at").Transpose(0, 1);
+
+        const std::string suffix = "." + std::to_string(n);
+        const double naive = naiveGflops(ctx, device, n, ha, hb);
+        const double tuned = tensorGflops(ctx, device, n, [&](krnl::CommandList& cmd) { krnl::TensorOps::MatMul(cmd, a, b); });
+        const double tunedT = tensorGflops(ctx, device, n, [&](krnl::CommandList& cmd) { krnl::TensorOps::MatMul(cmd, aT, b); });
+        krnl::bench::Report("gemm", "naive_gflops" + suffix, naive, "GFLOP/s");
+        krnl::bench::Report("gemm", "tuned_gflops" + suffix, tuned, "GFLOP/s");
+        krnl::bench::Report("gemm", "tuned_transposed_a_gflops" + suffix, tunedT, "GFLOP/s");
+        krnl::bench::Report("gemm", "speedup_vs_naive" + suffix, tuned / naive, "x");
+
+        if (n == 512) {
+            for (const krnl::GemmConfig& config : krnl::GemmTuner::Candidates()) {
+                if (!config.Fits(device.GetLimits()))
+                    continue;
+                double g = tensorGflops(ctx, device, n, [&](krnl::CommandList& cmd) { krnl::TensorOps::MatMul(cmd, a, b, config); });
+                krnl::bench::Report("gemm", "config_" + config.Name() + suffix, g, "GFLOP/s");
+            }
+        }
+
+        // CPU reference on every 32nd row, for both the plain and the transposed operand
+        const std::vector<float> c = krnl::TensorOps::MatMul(a, b).ToHost<float>();
+        const std::vector<float> cT = krnl::TensorOps::MatMul(aT, b).ToHost<float>();
+        if (c.size() != count || cT.size() != count) {
+            krnl::bench::Report("gemm", "wrong_result" + suffix, 1.0, "");
+            continue;
+        }
+        double maxError = 0.0;
+        for (uint32_t row = 0; row < n; row += 32) {
+            for (uint32_t col = 0; col < n; ++col) {
+                double expected = 0.0;
+                for (uint32_t k = 0; k < n; ++k)
+                    expected += double(ha[size_t(row) * n + k]) * double(hb[size_t(k) * n + col]);
+                const double scale = std::max(1.0, std::abs(expected));
+                const size_t at = size_t(row) * n + col;
+                maxError = std::max(maxError, std::abs(c[at] - expected) / scale);
+                maxError = std::max(maxError, std::abs(cT[at] - expected) / scale);
+            }
+        }
+        krnl::bench::Report("gemm", "max_rel_error" + suffix, maxError, "");
+        if (maxError > 1e-3)
+            krnl::bench::Report("gemm", "wrong_result" + suffix, maxError, "");
+    }
+}
@@ -0,0 +1,97 @@
+#include "bench.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Eight independent chains of four increment dispatches, each ending in a copy into its
+// slot of a result buffer, added to a ComputeGraph in chain order (as a multi-stage
+// pipeline would be written). Compared with encoding the same nodes in that order by hand,
+// one pass per dispatch and a copy after each chain, which is what the graph replaces.
+// Reports host encode+submit time, wall time to the readback and the pass count.
+
+namespace {
+
+    constexpr uint32_t kChains = 8;
+    constexpr uint32_t kStages = 4;
+    constexpr uint32_t kElements = 4096;
+    constexpr int kIterations = 50;
+
+    const char* kIncrement = R"(
+        @group(0) @binding(0) var<storage, read_write> data : array<u32>;
+
+        @compute @workgroup_size(64)
+        fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
+            if (gid.x < arrayLength(&data)) {
+                data[gid.x] = data[gid.x] + 1u;
+            }
+        }
+    )";
+
+} // namespace
+
+KRNL_BENCHMARK(compute_graph)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const size_t bytes = kElements * sizeof(uint32_t);
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    krnl::Shader shader = krnl::Shader::loadWGSL(device, kIncrement);
+    std::vector<std::unique_ptr<krnl::Buffer>> chains;
+    std::vector<std::vector<krnl::ParameterSet::Entry>> entries(kChains);
+    std::vector<std::unique_ptr<krnl::ParameterSet>> sets;
+    std::vector<krnl::Pipeline> pipelines;
+    std::vector<uint32_t> zeros(kElements, 0);
+    for (uint32_t c = 0; c < kChains; ++c) {
+        chains.push_back(std::make_unique<krnl::Buffer>(device, bytes, usage, "bench_graph_chain"));
+        chains.back()->WriteBuffer(zeros.data(), bytes);
+        entries[c].push_back({ *chains.back(), krnl::BufferBindingType::Storage });
+        sets.push_back(std::make_unique<krnl::ParameterSet>(device, entries[c]));
+        pipelines.push_back(krnl::Pipeline::CreateCompute(device, shader, *sets.back(), "main", "bench_graph_increment"));
+    }
+    krnl::Buffer result(device, bytes * kChains, usage, "bench_graph_result");
+
+    auto run = [&](const char* variant, auto&& encode) {
+        krnl::bench::WaitIdle(ctx, device);
+        uint32_t passes = 0;
+        auto start = krnl::bench::Clock::now();
+        for (int it = 0; it < kIterations; ++it)
+            passes = encode();
+        double encodeMs = krnl::bench::ElapsedMs(start);
+        krnl::Future<> f = result.ReadAsync([](const void*, size_t) {});
+        ctx.instance.Wait(f);
+        double totalMs = krnl::bench::ElapsedMs(start);
+
+        krnl::bench::Report("compute_graph", std::string("encode_submit.") + variant, encodeMs / kIterations, "ms");
+        krnl::bench::Report("compute_graph", std::string("end_to_end.") + variant, totalMs / kIterations, "ms");
+        krnl::bench::Report("compute_graph", std::string("compute_passes.") + variant, passes, "");
+    };
+
+    run("manual", [&] {
+        krnl::CommandList cmd(device);
+        uint32_t passes = 0;
+        for (uint32_t c = 0; c < kChains; ++c) {
+            for (uint32_t s = 0; s < kStages; ++s) {
+                cmd.BeginComputePass();
+                pipelines[c].encodeDispatch(cmd, kElements / 64);
+                cmd.EndComputePass();
+                passes++;
+            }
+            cmd.CopyBufferToBuffer(*chains[c], 0, result, c * bytes, bytes);
+        }
+        cmd.Submit();
+        return passes;
+    });
+
+    krnl::ComputeGraph graph(device);
+    for (uint32_t c = 0; c < kChains; ++c) {
+        for (uint32_t s = 0; s < kStages; ++s)
+            graph.AddDispatch(pipelines[c], kElements / 64);
+        graph.AddCopy(*chains[c], 0, result, c * bytes, bytes);
+    }
+    graph.MarkOutput(result);
+
+    run("graph", [&] {
+        return graph.Execute().computePasses;
+    });
+}
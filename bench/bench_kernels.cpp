@@ -0,0 +1,268 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Kernel-side throughput, sized to stay reasonable on the CPU fallback adapter:
+// - dispatch_latency: round trip of one empty dispatch (record, submit, wait for the queue)
+//   and the host cost of encoding and submitting one when many are in flight
+// - elementwise: c = a + b over f32 arrays of increasing size, in GB/s moved
+// - matmul: square f32 matrix multiply with 16x16 workgroup tiles, in GFLOP/s
+
+namespace {
+
+    const char* kEmpty = R"(
+        @group(0) @binding(0) var<storage, read_write> data : array<u32>;
+
+        @compute @workgroup_size(1)
+        fn main() {
+        }
+    )";
+
+    const char* kAdd = R"(
+        @group(0) @binding(0) var<storage, read> a : array<f32>;
+        @group(0) @binding(1) var<storage, read> b : array<f32>;
+        @group(0) @binding(2) var<storage, read_write> c : array<f32>;
+
+        @compute @workgroup_size(256)
+        fn main(@builtin(global_invocation_id) gid : vec3<u32>,
+                @builtin(num_workgroups) groups : vec3<u32>) {
+            let i = gid.y * groups.x * 256u + gid.x;
+            if (i < arrayLength(&c)) {
+                c[i] = a[i] + b[i];
+            }
+        }
+    )";
+
+    const char* kMatmul = R"(
+        struct Dims { n : u32 };
+
+        @group(0) @binding(0) var<storage, read> a : array<f32>;
+        @group(0) @binding(1) var<storage, read> b : array<f32>;
+        @group(0) @binding(2) var<storage, read_write> c : array<f32>;
+        @group(0) @binding(3) var<uniform> dims : Dims;
+
+        const TILE = 16u;
+        var<workgroup> tileA : array<f32, 256>;
+        var<workgroup> tileB : array<f32, 256>;
+
+        @compute @workgroup_size(16, 16)
+        fn main(@builtin(global_invocation_id) gid : vec3<u32>,
+                @builtin(local_invocation_id) lid : vec3<u32>) {
+            let n = dims.n;
+            let row = gid.y;
+            let col = gid.x;
+            var acc = 0.0;
+            for (var t = 0u; t < n; t = t + TILE) {
+                let ac = t + lid.x;
+                let br = t + lid.y;
+                tileA[lid.y * TILE + lid.x] = select(0.0, a[row * n + ac], row < n && ac < n);
+                tileB[lid.y * TILE + lid.x] = select(0.0, b[br * n + col], br < n && col < n);
+                workgroupBarrier();
+                for (var k = 0u; k < TILE; k = k + 1u) {
+                    acc = acc + tileA[lid.y * TILE + k] * tileB[k * TILE + lid.x];
+                }
+                workgroupBarrier();
+            }
+            if (row < n && col < n) {
+                c[row * n + col] = acc;
+            }
+        }
+    )";
+
+    const auto kStorage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    double median(std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    }
+
+    double percentile(std::vector<double> v, double p) {
+        std::sort(v.begin(), v.end());
+        return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))];
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(dispatch_latency)
+{
+    constexpr int kRoundTrips = 200;
+    constexpr int kBurst = 2000;
+
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    krnl::Buffer data(device, 256, kStorage, "bench_empty_data");
+    std::vector<krnl::ParameterSet::Entry> entries;
+    entries.push_back({ data, krnl::BufferBindingType::Storage });
+    krnl::ParameterSet params(device, entries);
+    krnl::Shader shader = krnl::Shader::loadWGSL(device, kEmpty);
+    auto pipeline = krnl::Pipeline::CreateCompute(device, shader, params, "main", "bench_empty");
+
+    auto dispatchOnce = [&] {
+        krnl::CommandList cmd(device);
+        cmd.BeginComputePass();
+        pipeline.encodeDispatch(cmd, 1);
+        cmd.EndComputePass();
+        cmd.Submit();
+    };
+
+    for (int i = 0; i < 10; ++i)
+        dispatchOnce();
+    krnl::bench::WaitIdle(ctx, device);
+
+    std::vector<double> latency;
+    latency.reserve(kRoundTrips);
+    for (int i = 0; i < kRoundTrips; ++i) {
+        auto start = krnl::bench::Clock::now();
+        dispatchOnce();
+        krnl::bench::WaitIdle(ctx, device);
+        latency.push_back(krnl::bench::ElapsedMs(start) * 1e3);
+    }
+    krnl::bench::Report("dispatch_latency", "round_trip_p50", median(latency), "us");
+    krnl::bench::Report("dispatch_latency", "round_trip_p90", percentile(latency, 0.9), "us");
+
+    auto start = krnl::bench::Clock::now();
+    for (int i = 0; i < kBurst; ++i)
+        dispatchOnce();
+    double hostMs = krnl::bench::ElapsedMs(start);
+    krnl::bench::WaitIdle(ctx, device);
+    double totalMs = krnl::bench::ElapsedMs(start);
+    krnl::bench::Report("dispatch_latency", "encode_submit_per_dispatch", hostMs * 1e3 / kBurst, "us");
+    krnl::bench::Report("dispatch_latency", "throughput", kBurst / (totalMs / 1e3), "dispatch/s");
+}
+
+KRNL_BENCHMARK(elementwise)
+{
+    constexpr int kIterations = 20;
+
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    krnl::Shader shader = krnl::Shader::loadWGSL(device, kAdd);
+
+    const uint32_t maxGroups = 65535;
+    std::vector<uint32_t> sizes = { 1u << 16, 1u << 20, 1u << 22 };
+    if (!ctx.cpu)
+        sizes.push_back(1u << 24);
+
+    for (uint32_t n : sizes) {
+        const size_t bytes = size_t(n) * sizeof(float);
+        krnl::Buffer a(device, bytes, kStorage, "bench_add_a");
+        krnl::Buffer b(device, bytes, kStorage, "bench_add_b");
+        krnl::Buffer c(device, bytes, kStorage, "bench_add_c");
+        std::vector<float> host(n);
+        for (uint32_t i = 0; i < n; ++i)
+            host[i] = float(i % 1024);
+        a.WriteBuffer(host.data(), bytes);
+        b.WriteBuffer(host.data(), bytes);
+
+        std::vector<krnl::ParameterSet::Entry> entries;
+        entries.push_back({ a, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ b, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ c, krnl::BufferBindingType::Storage });
+        krnl::ParameterSet params(device, entries);
+        auto pipeline = krnl::Pipeline::CreateCompute(device, shader, params, "main", "bench_add");
+
+        const uint32_t groups = (n + 255) / 256;
+        const uint32_t x = std::min(groups, maxGroups);
+        const uint32_t y = (groups + x - 1) / x;
+        auto run = [&](int iterations) {
+            krnl::CommandList cmd(device);
+            cmd.BeginComputePass();
+            for (int i = 0; i < iterations; ++i)
+                pipeline.encodeDispatch(cmd, x, y);
+            cmd.EndComputePass();
+            cmd.Submit();
+            krnl::bench::WaitIdle(ctx, device);
+        };
+
+        run(1);
+        auto start = krnl::bench::Clock::now();
+        run(kIterations);
+        double ms = krnl::bench::ElapsedMs(start);
+
+        float sample = 0.0f;
+        const uint32_t probe = n - 1;
+        ctx.instance.Wait(c.ReadAsync([&](const void* mapped, size_t) {
+            if (mapped)
+                sample = static_cast<const float*>(mapped)[probe];
+        }));
+
+        const std::string suffix = "." + std::to_string(n >> 10) + "K";
+        const double moved = 3.0 * double(bytes) * kIterations;
+        krnl::bench::Report("elementwise", "add_gbps" + suffix, moved / 1e9 / (ms / 1e3), "GB/s");
+        if (sample != 2.0f * host[probe])
+            krnl::bench::Report("elementwise", "wrong_result" + suffix, sample, "");
+    }
+}
+
+KRNL_BENCHMARK(matmul)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    krnl::Shader shader = krnl::Shader::loadWGSL(device, kMatmul);
+
+    std::vector<uint32_t> sizes = { 128, 256, 512 };
+    if (!ctx.cpu)
+        sizes.push_back(1024);
+
+    for (uint32_t n : sizes) {
+        const size_t count = size_t(n) * n;
+        const size_t bytes = count * sizeof(float);
+        krnl::Buffer a(device, bytes, kStorage, "bench_matmul_a");
+        krnl::Buffer b(device, bytes, kStorage, "bench_matmul_b");
+        krnl::Buffer c(device, bytes, kStorage, "bench_matmul_c");
+        krnl::Buffer dims(device, 16, krnl::BufferUsageType::Uniform | krnl::BufferUsageType::CopyDst, "bench_matmul_dims");
+
+        std::vector<float> ha(count), hb(count);
+        for (size_t i = 0; i < count; ++i) {
+            ha[i] = float(i % 7) * 0.25f;
+            hb[i] = float(i % 5) * 0.5f;
+        }
+        a.WriteBuffer(ha.data(), bytes);
+        b.WriteBuffer(hb.data(), bytes);
+        uint32_t dimsData[4] = { n, 0, 0, 0 };
+        dims.WriteBuffer(dimsData, sizeof(dimsData));
+
+        std::vector<krnl::ParameterSet::Entry> entries;
+        entries.push_back({ a, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ b, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ c, krnl::BufferBindingType::Storage });
+        entries.push_back({ dims, krnl::BufferBindingType::Uniform });
+        krnl::ParameterSet params(device, entries);
+        auto pipeline = krnl::Pipeline::CreateCompute(device, shader, params, "main", "bench_matmul");
+
+        const uint32_t groups = (n + 15) / 16;
+        // Fewer repetitions for large sizes so the CPU adapter finishes in seconds
+        const int iterations = std::max(1, int((256u * 256u * 256u * 8u) / (n * n * n)));
+        auto run = [&](int repeat) {
+            krnl::CommandList cmd(device);
+            cmd.BeginComputePass();
+            for (int i = 0; i < repeat; ++i)
+                pipeline.encodeDispatch(cmd, groups, groups);
+            cmd.EndComputePass();
+            cmd.Submit();
+            krnl::bench::WaitIdle(ctx, device);
+        };
+
+        run(1);
+        auto start = krnl::bench::Clock::now();
+        run(iterations);
+        double ms = krnl::bench::ElapsedMs(start);
+
+        // Spot-check one element against the host
+        const uint32_t row = n / 3, col = n / 2;
+        double expected = 0.0;
+        for (uint32_t k = 0; k < n; ++k)
+            expected += double(ha[size_t(row) * n + k]) * double(hb[size_t(k) * n + col]);
+        float sample = 0.0f;
+        ctx.instance.Wait(c.ReadAsync([&](const void* mapped, size_t) {
+            if (mapped)
+                sample = static_cast<const float*>(mapped)[size_t(row) * n + col];
+        }));
+
+        const std::string suffix = "." + std::to_string(n);
+        const double flops = 2.0 * double(n) * n * n * iterations;
+        krnl::bench::Report("matmul", "gflops" + suffix, flops / 1e9 / (ms / 1e3), "GFLOP/s");
+        if (std::abs(sample - expected) > 1e-3 * std::max(1.0, std::abs(expected)))
+            krnl::bench::Report("matmul", "wrong_result" + suffix, sample, "");
+    }
+}
@@ -0,0 +1,82 @@
+#include "bench.hpp"
+#include <core/log.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Cost of logging on the hot path. A loop of 256 small readbacks logs one message per
+// completion (plus one per issue). It runs with logging off, through the async ring
+// logger, and with the old behaviour of formatting and flushing on the calling thread.
+// All output goes to a temporary file, so terminal speed is not measured. Also reports the
+// per-call cost of a log statement in a tight loop.
+
+namespace {
+
+    constexpr int kReadbacks = 256;
+    constexpr int kCalls = 100000;
+    constexpr uint32_t kElements = 64;
+
+    // What log.h did before: format and flush on the calling thread
+    void logSync(FILE* out, int i, uint32_t value) {
+        std::fprintf(out, "[KRNL-WARN] %s:%d: readback %d complete, first=%u\n", __FILE__, __LINE__, i, value);
+        std::fflush(out);
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(logging)
+{
+    FILE* sink = std::tmpfile();
+    if (!sink) {
+        krnl::bench::Report("logging", "skipped_no_tmpfile", 1, "");
+        return;
+    }
+
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    krnl::Buffer data(device, kElements * sizeof(uint32_t),
+        krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst, "bench_log_data");
+    std::vector<uint32_t> values(kElements, 7);
+    data.WriteBuffer(values.data(), values.size() * sizeof(uint32_t));
+
+    const krnl::log::Level previous = krnl::log::GetLevel();
+    krnl::log::SetOutput(sink);
+
+    enum class Mode { Off, Async, Sync };
+    for (Mode mode : { Mode::Off, Mode::Async, Mode::Sync }) {
+        const char* name = mode == Mode::Off ? "off" : mode == Mode::Async ? "async" : "sync_flush";
+        krnl::log::SetLevel(mode == Mode::Async ? krnl::log::Level::Debug : krnl::log::Level::Off);
+        krnl::bench::WaitIdle(ctx, device);
+
+        auto start = krnl::bench::Clock::now();
+        std::vector<krnl::Future<>> pending;
+        for (int i = 0; i < kReadbacks; ++i) {
+            KRNL_LOG_AT(krnl::log::Level::Warn, "readback " << i << " issued, " << data.GetSize() << " bytes");
+            pending.push_back(data.ReadAsync([i, mode, sink](const void* mapped, size_t) {
+                uint32_t first = mapped ? *static_cast<const uint32_t*>(mapped) : 0;
+                if (mode == Mode::Sync)
+                    logSync(sink, i, first);
+                else
+                    KRNL_LOG_AT(krnl::log::Level::Warn, "readback " << i << " complete, first=" << first);
+            }));
+        }
+        ctx.instance.Wait(krnl::WhenAll(pending));
+        double ms = krnl::bench::ElapsedMs(start);
+        krnl::log::Flush();
+        krnl::bench::Report("logging", std::string("readback_loop.") + name, ms, "ms");
+
+        if (mode == Mode::Sync)
+            continue;
+        start = krnl::bench::Clock::now();
+        for (int i = 0; i < kCalls; ++i)
+            KRNL_LOG_AT(krnl::log::Level::Warn, "call " << i << " value=" << 0.5 * i);
+        double ns = krnl::bench::ElapsedMs(start) * 1e6 / kCalls;
+        krnl::log::Flush();
+        krnl::bench::Report("logging", std::string("per_call.") + name, ns, "ns");
+    }
+
+    krnl::bench::Report("logging", "dropped_total", double(krnl::log::DroppedCount()), "");
+    krnl::log::SetLevel(previous);
+    krnl::log::SetOutput(nullptr);
+    std::fclose(sink);
+}
@@ -0,0 +1,87 @@
+#include "bench.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// A step of three kernels (each in its own pass, 64 steps) run on a plain device and on one
+// with DeviceOptions::enableProfiling. Reports the host cost of profiling per step and the
+// per-kernel GPU times the profiler attributed to the pipeline labels (timestamp queries,
+// or host timing around submits on adapters without them). With --trace, the profiled
+// run is written out as a Chrome trace.
+
+namespace {
+
+    constexpr uint32_t kElements = 1 << 16;
+    constexpr int kSteps = 64;
+
+    const char* kKernels = R"(
+        @group(0) @binding(0) var<storage, read_write> data : array<f32>;
+
+        @compute @workgroup_size(64)
+        fn scale(@builtin(global_invocation_id) gid : vec3<u32>) {
+            if (gid.x < arrayLength(&data)) { data[gid.x] = data[gid.x] * 1.0001; }
+        }
+
+        @compute @workgroup_size(64)
+        fn offset(@builtin(global_invocation_id) gid : vec3<u32>) {
+            if (gid.x < arrayLength(&data)) { data[gid.x] = data[gid.x] + 0.5; }
+        }
+
+        @compute @workgroup_size(64)
+        fn heavy(@builtin(global_invocation_id) gid : vec3<u32>) {
+            if (gid.x >= arrayLength(&data)) { return; }
+            var x = data[gid.x];
+            for (var i = 0u; i < 256u; i = i + 1u) { x = sin(x) + 1.0; }
+            data[gid.x] = x;
+        }
+    )";
+
+} // namespace
+
+KRNL_BENCHMARK(profiler)
+{
+    for (bool profiling : { false, true }) {
+        krnl::DeviceOptions options = ctx.deviceOptions();
+        options.enableProfiling = profiling;
+        krnl::Device device(ctx.instance, options);
+
+        krnl::Buffer data(device, kElements * sizeof(float),
+            krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst, "bench_profiler_data");
+        std::vector<krnl::ParameterSet::Entry> entries;
+        entries.push_back({ data, krnl::BufferBindingType::Storage });
+        krnl::ParameterSet params(device, entries);
+        krnl::Shader shader = krnl::Shader::loadWGSL(device, kKernels);
+
+        std::vector<krnl::Pipeline> pipelines;
+        for (const char* entry : { "scale", "offset", "heavy" })
+            pipelines.push_back(krnl::Pipeline::CreateCompute(device, shader, params, entry, entry));
+        krnl::bench::WaitIdle(ctx, device);
+
+        auto start = krnl::bench::Clock::now();
+        for (int step = 0; step < kSteps; ++step) {
+            krnl::CommandList cmd(device);
+            for (const auto& p : pipelines) {
+                cmd.BeginComputePass();
+                p.encodeDispatch(cmd, kElements / 64);
+                cmd.EndComputePass();
+            }
+            cmd.Submit();
+        }
+        double hostMs = krnl::bench::ElapsedMs(start);
+        krnl::bench::WaitIdle(ctx, device);
+        // Let the timestamp readbacks land
+        ctx.instance.ProcessEvents();
+
+        krnl::bench::Report("profiler", profiling ? "host_per_step.profiled" : "host_per_step.plain", hostMs * 1e3 / kSteps, "us");
+
+        krnl::Profiler* profiler = device.GetProfiler();
+        if (!profiler)
+            continue;
+        const char* source = profiler->HasTimestamps() ? "gpu" : "host_timed";
+        for (const auto& k : profiler->GetKernelStats())
+            krnl::bench::Report("profiler", std::string(source) + "." + k.name, k.totalNs / 1e3 / k.count, "us");
+        if (!ctx.tracePath.empty() && profiler->WriteChromeTrace(ctx.tracePath))
+            krnl::bench::Report("profiler", "trace_events", double(profiler->GetEvents().size()), "");
+    }
+}
@@ -0,0 +1,127 @@
+#include "bench.hpp"
+
+#include <string>
+#include <vector>
+
+// Readback rate for small, medium and large buffers: Buffer::ReadAsync through the
+// pooled MapRead staging versus creating a fresh MapRead buffer for every read.
+
+namespace {
+
+    struct ReadCase {
+        size_t bytes;
+        size_t reads;
+        const char* name;
+    };
+
+    // Baseline: what ReadAsync did before the pool, one CreateBuffer per read.
+    void readUnpooled(krnl::bench::Context& ctx, const krnl::Device& device, const krnl::Buffer& src) {
+        wgpu::BufferDescriptor desc{};
+        desc.size = src.GetSize();
+        desc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+        desc.label = "bench_readback_fresh";
+        wgpu::Buffer staging = device.GetNative().CreateBuffer(&desc);
+
+        wgpu::CommandEncoder encoder = device.GetNative().CreateCommandEncoder();
+        encoder.CopyBufferToBuffer(src.GetNative(), src.GetOffset(), staging, 0, src.GetSize());
+        wgpu::CommandBuffer cmd = encoder.Finish();
+        device.getQueue().Submit(1, &cmd);
+
+        wgpu::Future f = staging.MapAsync(wgpu::MapMode::Read, 0, src.GetSize(), wgpu::CallbackMode::WaitAnyOnly,
+            [](wgpu::MapAsyncStatus, wgpu::StringView) {});
+        ctx.instance.WaitAny(f, UINT64_MAX);
+        staging.Unmap();
+        staging.Destroy();
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(readback)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    const ReadCase cases[] = {
+        { 256, 4000, "256B" },
+        { 64u << 10, 1000, "64KB" },
+        { 16u << 20, 32, "16MB" },
+    };
+
+    for (const ReadCase& c : cases) {
+        krnl::Buffer src(device, c.bytes, usage, "bench_readback_src");
+        std::vector<uint8_t> fill(c.bytes, 0x3c);
+        src.WriteBuffer(fill.data(), fill.size());
+
+        auto start = krnl::bench::Clock::now();
+        for (size_t i = 0; i < c.reads; ++i)
+            readUnpooled(ctx, device, src);
+        double ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("readback", std::string("fresh_buffer.") + c.name, c.reads / (ms / 1e3), "reads/s");
+
+        uint64_t checksum = 0;
+        start = krnl::bench::Clock::now();
+        for (size_t i = 0; i < c.reads; ++i) {
+            krnl::Future f = src.ReadAsync([&](const void* data, size_t) {
+                if (data)
+                    checksum += static_cast<const uint8_t*>(data)[0];
+            });
+            ctx.instance.WaitAny(f, UINT64_MAX);
+        }
+        ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("readback", std::string("pooled.") + c.name, c.reads / (ms / 1e3), "reads/s");
+        krnl::bench::Report("readback", std::string("pooled_gbps.") + c.name, c.reads * double(c.bytes) / 1e9 / (ms / 1e3), "GB/s");
+        if (checksum != 0x3cull * c.reads)
+            krnl::bench::Report("readback", std::string("checksum_mismatch.") + c.name, double(checksum), "");
+    }
+
+    auto stats = device.GetStagingPool().getStats();
+    krnl::bench::Report("readback", "readback_buffers_created", static_cast<double>(stats.readbackBuffersCreated), "");
+    krnl::bench::Report("readback", "readback_buffers_reused", static_cast<double>(stats.readbackBuffersReused), "");
+}
+
+// Latency of reading N small result buffers in one step: N independent ReadAsync calls
+// (each its own submit and map) versus one ReadbackBatch (one submit, one map).
+KRNL_BENCHMARK(readback_batch)
+{
+    constexpr size_t kSteps = 200;
+    constexpr size_t kResultBytes = 256;
+
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    std::vector<krnl::Buffer> results;
+    results.reserve(64);
+    std::vector<uint8_t> fill(kResultBytes, 0x11);
+    for (size_t i = 0; i < 64; ++i) {
+        results.push_back(krnl::Buffer::Suballocate(device, kResultBytes, usage, "bench_result"));
+        results.back().WriteBuffer(fill.data(), fill.size());
+    }
+
+    for (size_t n : { size_t(1), size_t(8), size_t(32), size_t(64) }) {
+        const std::string suffix = "." + std::to_string(n);
+
+        std::vector<krnl::Future<>> futures;
+        auto start = krnl::bench::Clock::now();
+        for (size_t step = 0; step < kSteps; ++step) {
+            futures.clear();
+            for (size_t i = 0; i < n; ++i)
+                futures.push_back(results[i].ReadAsync([](const void*, size_t) {}));
+            ctx.instance.WaitAll(futures, UINT64_MAX);
+        }
+        double ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("readback_batch", "read_async" + suffix, ms * 1e3 / kSteps, "us/step");
+
+        krnl::ReadbackBatch batch(device);
+        size_t bytesSeen = 0;
+        start = krnl::bench::Clock::now();
+        for (size_t step = 0; step < kSteps; ++step) {
+            for (size_t i = 0; i < n; ++i)
+                batch.Read(results[i], [&](const void*, size_t size) { bytesSeen += size; });
+            ctx.instance.WaitAny(batch.Submit(), UINT64_MAX);
+        }
+        ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("readback_batch", "batched" + suffix, ms * 1e3 / kSteps, "us/step");
+        if (bytesSeen != kSteps * n * kResultBytes)
+            krnl::bench::Report("readback_batch", "bytes_mismatch" + suffix, double(bytesSeen), "B");
+    }
+}
@@ -0,0 +1,92 @@
+#include "bench.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// An inference-style step of 200 dispatches cycling over 4 kernels/buffers, encoded 100
+// times: through Pipeline::encodeDispatch every step, by replaying a CommandCapture, and
+// by replaying with the first buffer swapped for a second one on alternate steps
+// (double-buffered input). Reports host encode time per step (CommandList creation to
+// Finish); submission and GPU time are excluded.
+
+namespace {
+
+    constexpr uint32_t kDispatchesPerStep = 200;
+    constexpr uint32_t kKernels = 4;
+    constexpr uint32_t kElements = 1024;
+    constexpr int kSteps = 100;
+
+    const char* kIncrement = R"(
+        @group(0) @binding(0) var<storage, read_write> data : array<u32>;
+
+        @compute @workgroup_size(64)
+        fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
+            if (gid.x < arrayLength(&data)) {
+                data[gid.x] = data[gid.x] + 1u;
+            }
+        }
+    )";
+
+} // namespace
+
+KRNL_BENCHMARK(capture_replay)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const size_t bytes = kElements * sizeof(uint32_t);
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst;
+
+    krnl::Shader shader = krnl::Shader::loadWGSL(device, kIncrement);
+    std::vector<std::unique_ptr<krnl::Buffer>> buffers;
+    std::vector<std::vector<krnl::ParameterSet::Entry>> entries(kKernels);
+    std::vector<std::unique_ptr<krnl::ParameterSet>> sets;
+    std::vector<krnl::Pipeline> pipelines;
+    for (uint32_t k = 0; k < kKernels; ++k) {
+        buffers.push_back(std::make_unique<krnl::Buffer>(device, bytes, usage, "bench_replay_data"));
+        entries[k].push_back({ *buffers.back(), krnl::BufferBindingType::Storage });
+        sets.push_back(std::make_unique<krnl::ParameterSet>(device, entries[k]));
+        pipelines.push_back(krnl::Pipeline::CreateCompute(device, shader, *sets.back(), "main", "bench_replay_increment"));
+    }
+    krnl::Buffer alternate(device, bytes, usage, "bench_replay_alternate");
+
+    auto encodeStep = [&](krnl::CommandList& cmd) {
+        cmd.BeginComputePass();
+        for (uint32_t i = 0; i < kDispatchesPerStep; ++i)
+            pipelines[i % kKernels].encodeDispatch(cmd, kElements / 64);
+        cmd.EndComputePass();
+    };
+
+    krnl::CommandCapture capture;
+    {
+        krnl::CommandList cmd(device);
+        cmd.BeginCapture(capture);
+        encodeStep(cmd);
+        cmd.EndCapture();
+    }
+    const std::vector<krnl::CommandCapture::Substitution> swap = { { buffers[0].get(), &alternate } };
+
+    auto run = [&](const char* variant, auto&& encode) {
+        krnl::bench::WaitIdle(ctx, device);
+        double encodeMs = 0;
+        for (int step = 0; step < kSteps; ++step) {
+            auto start = krnl::bench::Clock::now();
+            krnl::CommandList cmd(device);
+            encode(cmd, step);
+            wgpu::CommandBuffer cb = cmd.Finish();
+            encodeMs += krnl::bench::ElapsedMs(start);
+            device.GetSubmitQueue().Enqueue(cb);
+        }
+        krnl::bench::WaitIdle(ctx, device);
+        krnl::bench::Report("capture_replay", std::string("encode_per_step.") + variant, encodeMs * 1e3 / kSteps, "us");
+    };
+
+    run("record", [&](krnl::CommandList& cmd, int) { encodeStep(cmd); });
+    run("replay", [&](krnl::CommandList& cmd, int) { capture.Replay(cmd); });
+    run("replay_substituted", [&](krnl::CommandList& cmd, int step) {
+        if (step % 2)
+            capture.Replay(cmd, swap);
+        else
+            capture.Replay(cmd);
+    });
+    krnl::bench::Report("capture_replay", "captured_ops", double(capture.GetOpCount()), "");
+}
@@ -0,0 +1,94 @@
+#include "bench.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// First-dispatch latency of a fresh device with the on-disk blob cache disabled,
+// empty (cold) and populated by a previous device (warm).
+
+namespace {
+
+    constexpr uint32_t kKernelCount = 16;
+    constexpr uint32_t kElements = 1024;
+
+    std::string kernelSource(uint32_t variant) {
+        // Distinct constants per variant so every kernel is a separate compilation.
+        return R"(
+            @group(0) @binding(0) var<storage, read> src : array<f32>;
+            @group(0) @binding(1) var<storage, read_write> dst : array<f32>;
+
+            @compute @workgroup_size(64)
+            fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
+                let i = gid.x;
+                if (i >= arrayLength(&dst)) { return; }
+                var acc = src[i];
+                for (var k = 0u; k < 32u; k = k + 1u) {
+                    acc = fma(acc, 1.0001, f32(k) * )" + std::to_string(variant + 1) + R"(.0);
+                    acc = sin(acc) + cos(acc * 0.5);
+                }
+                dst[i] = acc;
+            }
+        )";
+    }
+
+    // Returns milliseconds from device creation to the readback of the last kernel's output.
+    double firstDispatch(krnl::bench::Context& ctx, const krnl::DeviceOptions& options, double& deviceMs) {
+        auto start = krnl::bench::Clock::now();
+        krnl::Device device(ctx.instance, options);
+        deviceMs = krnl::bench::ElapsedMs(start);
+
+        auto compileStart = krnl::bench::Clock::now();
+        size_t bytes = kElements * sizeof(float);
+        krnl::Buffer src(device, bytes, krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopyDst, "startup_src");
+        krnl::Buffer dst(device, bytes, krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc, "startup_dst");
+        krnl::Buffer map(device, bytes, krnl::BufferUsageType::CopyDst | krnl::BufferUsageType::MapRead, "startup_map");
+
+        std::vector<krnl::ParameterSet::Entry> entries;
+        entries.push_back({ src, krnl::BufferBindingType::ReadOnlyStorage });
+        entries.push_back({ dst, krnl::BufferBindingType::Storage });
+        krnl::ParameterSet params(device, entries);
+
+        krnl::CommandList cmd(device);
+        cmd.BeginComputePass();
+        for (uint32_t v = 0; v < kKernelCount; ++v) {
+            krnl::Shader shader = krnl::Shader::loadWGSL(device, kernelSource(v));
+            auto pipeline = krnl::Pipeline::CreateCompute(device, shader, params, "main", "startup_kernel");
+            pipeline.encodeDispatch(cmd, kElements / 64);
+        }
+        cmd.EndComputePass();
+        cmd.CopyBufferToBuffer(dst, map, bytes);
+        cmd.Submit();
+
+        std::vector<float> out(kElements);
+        krnl::Future f = map.MapAsync(krnl::MapMode::Read, 0, bytes, out.data());
+        ctx.instance.WaitAny(f, UINT64_MAX);
+        return krnl::bench::ElapsedMs(compileStart);
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(startup_first_dispatch)
+{
+    std::filesystem::path cacheRoot = std::filesystem::temp_directory_path() / "krnl_bench_startup_cache";
+    std::filesystem::remove_all(cacheRoot);
+
+    krnl::DeviceOptions noCache = ctx.deviceOptions();
+    noCache.enableDiskCache = false;
+
+    krnl::DeviceOptions withCache = ctx.deviceOptions();
+    withCache.cacheDirectory = cacheRoot;
+
+    double deviceMs = 0.0;
+    double ms = firstDispatch(ctx, noCache, deviceMs);
+    krnl::bench::Report("startup_first_dispatch", "no_cache.device_ms", deviceMs, "ms");
+    krnl::bench::Report("startup_first_dispatch", "no_cache.first_dispatch_ms", ms, "ms");
+
+    ms = firstDispatch(ctx, withCache, deviceMs);
+    krnl::bench::Report("startup_first_dispatch", "cold_cache.first_dispatch_ms", ms, "ms");
+
+    ms = firstDispatch(ctx, withCache, deviceMs);
+    krnl::bench::Report("startup_first_dispatch", "warm_cache.first_dispatch_ms", ms, "ms");
+
+    std::filesystem::remove_all(cacheRoot);
+}
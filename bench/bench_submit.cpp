@@ -0,0 +1,76 @@
+#include "bench.hpp"
+
+#include <string>
+#include <vector>
+
+// A chain of 1,000 small dependent dispatches, each recorded in its own CommandList and
+// submitted, with the device submission queue flushing every 1 (immediate), 16 or 64
+// command buffers. Reports host submit rate, end-to-end latency to the readback of the
+// result, and the number of Queue::Submit calls that reached the driver.
+
+namespace {
+
+    constexpr uint32_t kDispatches = 1000;
+    constexpr uint32_t kElements = 256;
+
+    const char* kIncrement = R"(
+        @group(0) @binding(0) var<storage, read_write> data : array<u32>;
+
+        @compute @workgroup_size(64)
+        fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
+            if (gid.x < arrayLength(&data)) {
+                data[gid.x] = data[gid.x] + 1u;
+            }
+        }
+    )";
+
+} // namespace
+
+KRNL_BENCHMARK(submit_batching)
+{
+    for (size_t maxPending : { size_t(1), size_t(16), size_t(64) }) {
+        krnl::DeviceOptions options = ctx.deviceOptions();
+        options.maxPendingSubmits = maxPending;
+        krnl::Device device(ctx.instance, options);
+
+        const size_t bytes = kElements * sizeof(uint32_t);
+        krnl::Buffer data(device, bytes,
+            krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst, "bench_submit_data");
+        std::vector<uint32_t> zeros(kElements, 0);
+        data.WriteBuffer(zeros.data(), bytes);
+
+        std::vector<krnl::ParameterSet::Entry> entries;
+        entries.push_back({ data, krnl::BufferBindingType::Storage });
+        krnl::ParameterSet params(device, entries);
+        krnl::Shader shader = krnl::Shader::loadWGSL(device, kIncrement);
+        auto pipeline = krnl::Pipeline::CreateCompute(device, shader, params, "main", "bench_increment");
+        krnl::bench::WaitIdle(ctx, device);
+
+        const auto before = device.GetSubmitQueue().GetStats();
+        auto start = krnl::bench::Clock::now();
+        for (uint32_t i = 0; i < kDispatches; ++i) {
+            krnl::CommandList cmd(device);
+            cmd.BeginComputePass();
+            pipeline.encodeDispatch(cmd, kElements / 64);
+            cmd.EndComputePass();
+            cmd.Submit();
+        }
+        double submitMs = krnl::bench::ElapsedMs(start);
+
+        uint32_t first = 0;
+        krnl::Future<> f = data.ReadAsync([&](const void* mapped, size_t) {
+            if (mapped)
+                first = *static_cast<const uint32_t*>(mapped);
+        });
+        ctx.instance.Wait(f);
+        double totalMs = krnl::bench::ElapsedMs(start);
+        const auto after = device.GetSubmitQueue().GetStats();
+
+        const std::string suffix = ".batch" + std::to_string(maxPending);
+        krnl::bench::Report("submit_batching", "submits_per_sec" + suffix, kDispatches / (submitMs / 1e3), "cmd/s");
+        krnl::bench::Report("submit_batching", "end_to_end" + suffix, totalMs, "ms");
+        krnl::bench::Report("submit_batching", "queue_submits" + suffix, double(after.submits - before.submits), "");
+        if (first != kDispatches)
+            krnl::bench::Report("submit_batching", "wrong_result" + suffix, first, "");
+    }
+}
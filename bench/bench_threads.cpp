@@ -0,0 +1,103 @@
+#include "bench.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// 1,024 independent dispatches recorded by 1-16 worker threads. Each thread owns a
+// CommandList per batch of 16 dispatches and submits it with a ticket reserved up front,
+// so the queue sees the batches in order whichever thread finishes first. Each thread also
+// stages a small parameter upload per batch through the shared upload batch. Reports
+// recording throughput and the wall time until the results are read back.
+
+namespace {
+
+    constexpr uint32_t kDispatches = 1024;
+    constexpr uint32_t kPerList = 16;
+    constexpr uint32_t kElements = 256;
+
+    const char* kIncrement = R"(
+        @group(0) @binding(0) var<storage, read_write> data : array<u32>;
+
+        @compute @workgroup_size(64)
+        fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
+            if (gid.x < arrayLength(&data)) {
+                data[gid.x] = data[gid.x] + 1u;
+            }
+        }
+    )";
+
+} // namespace
+
+KRNL_BENCHMARK(parallel_recording)
+{
+    krnl::DeviceOptions options = ctx.deviceOptions();
+    options.threadSafe = true;
+    krnl::Device device(ctx.instance, options);
+    if (!device.IsThreadSafe()) {
+        krnl::bench::Report("parallel_recording", "skipped_not_thread_safe", 1, "");
+        return;
+    }
+
+    const size_t bytes = kElements * sizeof(uint32_t);
+    krnl::Buffer data(device, bytes,
+        krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopySrc | krnl::BufferUsageType::CopyDst, "bench_threads_data");
+    krnl::Buffer params(device, kDispatches / kPerList * 16,
+        krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopyDst, "bench_threads_params");
+
+    std::vector<krnl::ParameterSet::Entry> entries;
+    entries.push_back({ data, krnl::BufferBindingType::Storage });
+    krnl::ParameterSet set(device, entries);
+    krnl::Shader shader = krnl::Shader::loadWGSL(device, kIncrement);
+    const auto pipeline = krnl::Pipeline::CreateCompute(device, shader, set, "main", "bench_threads_increment");
+
+    const uint32_t lists = kDispatches / kPerList;
+    uint32_t expected = 0;
+
+    for (uint32_t threads : { 1u, 2u, 4u, 8u, 16u }) {
+        krnl::bench::WaitIdle(ctx, device);
+        krnl::SubmitQueue& queue = device.GetSubmitQueue();
+
+        // Tickets in batch order, handed out round-robin
+        std::vector<krnl::SubmitQueue::Ticket> tickets(lists);
+        for (auto& t : tickets)
+            t = queue.Reserve();
+
+        auto start = krnl::bench::Clock::now();
+        std::vector<std::thread> workers;
+        for (uint32_t w = 0; w < threads; ++w) {
+            workers.emplace_back([&, w] {
+                for (uint32_t list = w; list < lists; list += threads) {
+                    const uint32_t tag[4] = { list, threads, 0, 0 };
+                    device.GetUploadBatch().Write(params, tag, sizeof(tag), list * sizeof(tag));
+
+                    krnl::CommandList cmd(device);
+                    cmd.BeginComputePass();
+                    for (uint32_t i = 0; i < kPerList; ++i)
+                        pipeline.encodeDispatch(cmd, kElements / 64);
+                    cmd.EndComputePass();
+                    cmd.Submit(tickets[list]);
+                }
+            });
+        }
+        for (auto& t : workers)
+            t.join();
+        double recordMs = krnl::bench::ElapsedMs(start);
+        expected += kDispatches;
+
+        uint32_t first = 0;
+        krnl::Future<> f = data.ReadAsync([&](const void* mapped, size_t) {
+            if (mapped)
+                first = *static_cast<const uint32_t*>(mapped);
+        });
+        ctx.instance.Wait(f);
+        double totalMs = krnl::bench::ElapsedMs(start);
+
+        const std::string suffix = ".threads" + std::to_string(threads);
+        krnl::bench::Report("parallel_recording", "dispatches_per_sec" + suffix, kDispatches / (recordMs / 1e3), "dispatch/s");
+        krnl::bench::Report("parallel_recording", "record_submit" + suffix, recordMs, "ms");
+        krnl::bench::Report("parallel_recording", "end_to_end" + suffix, totalMs, "ms");
+        if (first != expected)
+            krnl::bench::Report("parallel_recording", "wrong_result" + suffix, first, "");
+    }
+}
@@ -0,0 +1,168 @@
+#include "bench.hpp"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Host->device upload throughput: one Buffer::WriteBuffer (Queue::WriteBuffer) or
+// Buffer::WriteViaStaging per write versus batching a frame of writes into the staging
+// ring (enqueueUpload + one flush), against a plain memcpy of the same bytes as the ceiling.
+
+namespace {
+
+    constexpr size_t kFrames = 64;
+    constexpr size_t kFrameBytes = 8u << 20;
+
+} // namespace
+
+KRNL_BENCHMARK(staging_upload)
+{
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    const auto usage = krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopyDst;
+    krnl::Buffer dst(device, kFrameBytes, usage, "bench_upload_dst");
+    std::vector<uint8_t> src(kFrameBytes, 0x5a);
+    std::vector<uint8_t> host(kFrameBytes);
+    krnl::PersistentStagingPool& pool = device.GetStagingPool();
+
+    for (size_t writeBytes : { size_t(4) << 10, size_t(64) << 10, size_t(1) << 20 }) {
+        const size_t writesPerFrame = kFrameBytes / writeBytes;
+        const double totalGB = double(kFrames) * kFrameBytes / 1e9;
+        const std::string suffix = "." + std::to_string(writeBytes >> 10) + "KB";
+
+        auto start = krnl::bench::Clock::now();
+        for (size_t frame = 0; frame < kFrames; ++frame) {
+            for (size_t i = 0; i < writesPerFrame; ++i)
+                std::memcpy(host.data() + i * writeBytes, src.data() + i * writeBytes, writeBytes);
+        }
+        double ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("staging_upload", "memcpy" + suffix, totalGB / (ms / 1e3), "GB/s");
+
+        krnl::bench::WaitIdle(ctx, device);
+        start = krnl::bench::Clock::now();
+        for (size_t frame = 0; frame < kFrames; ++frame) {
+            for (size_t i = 0; i < writesPerFrame; ++i)
+                dst.WriteBuffer(src.data() + i * writeBytes, writeBytes, i * writeBytes);
+            ctx.instance.ProcessEvents();
+        }
+        krnl::bench::WaitIdle(ctx, device);
+        ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("staging_upload", "write_buffer" + suffix, totalGB / (ms / 1e3), "GB/s");
+
+        // WriteViaStaging always writes from the start of a buffer, so the per-write path
+        // uses one suballocated slot per write to cover the same bytes.
+        std::vector<krnl::Buffer> slots;
+        slots.reserve(writesPerFrame);
+        for (size_t i = 0; i < writesPerFrame; ++i)
+            slots.push_back(krnl::Buffer::Suballocate(device, writeBytes, usage, "bench_upload_slot"));
+
+        krnl::bench::WaitIdle(ctx, device);
+        krnl::PersistentStagingPool::Stats before = pool.getStats();
+        start = krnl::bench::Clock::now();
+        for (size_t frame = 0; frame < kFrames; ++frame) {
+            for (size_t i = 0; i < writesPerFrame; ++i)
+                slots[i].WriteViaStaging(src.data() + i * writeBytes, writeBytes);
+            ctx.instance.ProcessEvents();
+        }
+        krnl::bench::WaitIdle(ctx, device);
+        ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("staging_upload", "write_via_staging" + suffix, totalGB / (ms / 1e3), "GB/s");
+
+        // Small writes share the open chunk, so the ring should stay bounded over the loop
+        krnl::PersistentStagingPool::Stats after = pool.getStats();
+        krnl::bench::Report("staging_upload", "via_staging_chunks_created" + suffix,
+            static_cast<double>(after.chunksCreated - before.chunksCreated), "");
+        krnl::bench::Report("staging_upload", "via_staging_capped" + suffix,
+            static_cast<double>(after.allocationsCapped - before.allocationsCapped), "");
+
+        // Batched: every write of a frame goes into the ring, one submit per frame.
+        auto uploadFrame = [&] {
+            for (size_t i = 0; i < writesPerFrame; ++i) {
+                krnl::StagingHandlePtr staging = pool.allocate(writeBytes);
+                std::memcpy(staging->mappedPtr, src.data() + i * writeBytes, writeBytes);
+                pool.enqueueUpload(staging, dst.GetNative(), writeBytes, i * writeBytes);
+            }
+            pool.flush(device.getQueue());
+            // End of frame: push the copies out so the chunks start remapping
+            device.GetSubmitQueue().Flush();
+            ctx.instance.ProcessEvents();
+        };
+
+        // Warm the ring up so the measured frames show steady-state chunk reuse.
+        for (size_t frame = 0; frame < 4; ++frame)
+            uploadFrame();
+        krnl::bench::WaitIdle(ctx, device);
+        const uint64_t createdBefore = pool.getStats().chunksCreated;
+
+        start = krnl::bench::Clock::now();
+        for (size_t frame = 0; frame < kFrames; ++frame)
+            uploadFrame();
+        krnl::bench::WaitIdle(ctx, device);
+        ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("staging_upload", "ring_batched" + suffix, totalGB / (ms / 1e3), "GB/s");
+
+        auto stats = pool.getStats();
+        krnl::bench::Report("staging_upload", "ring_chunks_created_steady" + suffix,
+            static_cast<double>(stats.chunksCreated - createdBefore), "");
+        krnl::bench::Report("staging_upload", "ring_chunks_recycled" + suffix, static_cast<double>(stats.chunksRecycled), "");
+    }
+}
+
+// Many tiny writes per step (parameter updates): one Buffer::WriteBuffer per write versus
+// UploadBatch, for sequential destinations (merged into a few copies) and scattered ones.
+KRNL_BENCHMARK(upload_batch)
+{
+    constexpr size_t kWrites = 16384;
+    constexpr size_t kSteps = 8;
+    constexpr size_t kParamBytes = 16u << 20;
+
+    krnl::Device device(ctx.instance, ctx.deviceOptions());
+    krnl::Buffer params(device, kParamBytes, krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopyDst, "bench_params");
+
+    std::mt19937 rng(11);
+    std::vector<size_t> sizes(kWrites);
+    for (auto& s : sizes)
+        s = 16 + 4 * (rng() % 61);      // 16 .. 256 bytes, multiples of 4
+    std::vector<uint8_t> src(256, 0x7e);
+
+    std::vector<size_t> sequential(kWrites);
+    size_t offset = 0;
+    for (size_t i = 0; i < kWrites; ++i) {
+        sequential[i] = offset;
+        offset += sizes[i];
+    }
+    std::vector<size_t> scattered(kWrites);
+    for (size_t i = 0; i < kWrites; ++i)
+        scattered[i] = (rng() % ((kParamBytes - 256) / 4)) * 4;
+
+    const std::pair<const char*, const std::vector<size_t>*> patterns[] = {
+        { "sequential", &sequential },
+        { "scattered", &scattered },
+    };
+
+    for (const auto& [pattern, offsets] : patterns) {
+        krnl::bench::WaitIdle(ctx, device);
+        auto start = krnl::bench::Clock::now();
+        for (size_t step = 0; step < kSteps; ++step) {
+            for (size_t i = 0; i < kWrites; ++i)
+                params.WriteBuffer(src.data(), sizes[i], (*offsets)[i]);
+            krnl::bench::WaitIdle(ctx, device);
+        }
+        double ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("upload_batch", std::string("write_buffer.") + pattern, ms * 1e6 / (kSteps * kWrites), "ns/write");
+
+        krnl::UploadBatch batch(device);
+        start = krnl::bench::Clock::now();
+        for (size_t step = 0; step < kSteps; ++step) {
+            for (size_t i = 0; i < kWrites; ++i)
+                batch.Write(params, src.data(), sizes[i], (*offsets)[i]);
+            batch.Flush();
+            krnl::bench::WaitIdle(ctx, device);
+        }
+        ms = krnl::bench::ElapsedMs(start);
+        krnl::bench::Report("upload_batch", std::string("batched.") + pattern, ms * 1e6 / (kSteps * kWrites), "ns/write");
+
+        auto stats = batch.GetStats();
+        krnl::bench::Report("upload_batch", std::string("copies_per_step.") + pattern, double(stats.copies) / kSteps, "");
+    }
+}
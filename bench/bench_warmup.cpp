@@ -0,0 +1,86 @@
+#include "bench.hpp"
+
+#include <string>
+#include <vector>
+
+// Wall time to compile a manifest of kernels serially (CreateCompute) versus concurrently
+// (Pipeline::WarmUp + Instance::WaitAll).
+
+namespace {
+
+    constexpr uint32_t kKernelCount = 64;
+
+    // 'salt' keeps the serial and async runs from sharing Dawn's in-memory caches.
+    std::string kernelSource(uint32_t variant, uint32_t salt) {
+        return R"(
+            @group(0) @binding(0) var<storage, read> src : array<f32>;
+            @group(0) @binding(1) var<storage, read_write> dst : array<f32>;
+
+            @compute @workgroup_size(64)
+            fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
+                let i = gid.x;
+                if (i >= arrayLength(&dst)) { return; }
+                var acc = src[i] + )" + std::to_string(salt) + R"(.0;
+                for (var k = 0u; k < 16u; k = k + 1u) {
+                    acc = fma(acc, 0.999, f32(k) * )" + std::to_string(variant + 1) + R"(.0);
+                    acc = exp2(sin(acc)) - log2(abs(acc) + 1.0);
+                }
+                dst[i] = acc;
+            }
+        )";
+    }
+
+} // namespace
+
+KRNL_BENCHMARK(pipeline_warmup)
+{
+    krnl::DeviceOptions options = ctx.deviceOptions();
+    options.enableDiskCache = false;
+    krnl::Device device(ctx.instance, options);
+
+    const std::vector<krnl::BufferBindingType> bindings = {
+        krnl::BufferBindingType::ReadOnlyStorage,
+        krnl::BufferBindingType::Storage,
+    };
+
+    krnl::Buffer src(device, 256, krnl::BufferUsageType::Storage, "warmup_src");
+    krnl::Buffer dst(device, 256, krnl::BufferUsageType::Storage, "warmup_dst");
+    std::vector<krnl::ParameterSet::Entry> entries;
+    entries.push_back({ src, bindings[0] });
+    entries.push_back({ dst, bindings[1] });
+    krnl::ParameterSet params(device, entries);
+
+    // Serial: one blocking compile after another.
+    auto start = krnl::bench::Clock::now();
+    for (uint32_t v = 0; v < kKernelCount; ++v) {
+        krnl::Shader shader = krnl::Shader::loadWGSL(device, kernelSource(v, 1));
+        krnl::Pipeline::CreateCompute(device, shader, params, "main", "warmup_serial");
+    }
+    double serialMs = krnl::bench::ElapsedMs(start);
+
+    // Concurrent: submit the whole manifest, then wait for all of it.
+    start = krnl::bench::Clock::now();
+    std::vector<krnl::PipelineWarmupEntry> manifest;
+    manifest.reserve(kKernelCount);
+    for (uint32_t v = 0; v < kKernelCount; ++v) {
+        manifest.push_back({ krnl::Shader::loadWGSL(device, kernelSource(v, 2)), bindings, "main", "warmup_async" });
+    }
+    std::vector<krnl::Future<>> futures = krnl::Pipeline::WarmUp(device, manifest);
+    double submitMs = krnl::bench::ElapsedMs(start);
+    ctx.instance.WaitAll(futures, UINT64_MAX);
+    double asyncMs = krnl::bench::ElapsedMs(start);
+
+    // Every manifest kernel must now be a cache hit.
+    device.GetPipelineCache().ResetStats();
+    for (const auto& entry : manifest) {
+        krnl::Pipeline::CreateCompute(device, entry.shader, params, entry.entryPoint);
+    }
+    auto stats = device.GetPipelineCache().GetStats();
+
+    krnl::bench::Report("pipeline_warmup", "kernels", kKernelCount, "");
+    krnl::bench::Report("pipeline_warmup", "serial_ms", serialMs, "ms");
+    krnl::bench::Report("pipeline_warmup", "async_submit_ms", submitMs, "ms");
+    krnl::bench::Report("pipeline_warmup", "async_total_ms", asyncMs, "ms");
+    krnl::bench::Report("pipeline_warmup", "speedup", serialMs / asyncMs, "x");
+    krnl::bench::Report("pipeline_warmup", "post_warmup_hit_rate", stats.hitRate() * 100.0, "%");
+}
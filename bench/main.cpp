@@ -0,0 +1,165 @@
+#include "bench.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+namespace krnl::bench {
+
+    std::vector<Benchmark>& Registry() {
+        static std::vector<Benchmark> registry;
+        return registry;
+    }
+
+    static std::vector<Result>& mutableResults() {
+        static std::vector<Result> results;
+        return results;
+    }
+
+    const std::vector<Result>& Results() {
+        return mutableResults();
+    }
+
+    void Report(const std::string& benchmark, const std::string& metric, double value, const char* unit) {
+        mutableResults().push_back({ benchmark, metric, value, unit });
+        std::printf("%-28s %-36s %14.3f %s\n", benchmark.c_str(), metric.c_str(), value, unit);
+        std::fflush(stdout);
+    }
+
+} // namespace krnl::bench
+
+namespace {
+
+    std::string jsonString(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else {
+                    out += c;
+                }
+            }
+        }
+        return out + "\"";
+    }
+
+    std::string jsonNumber(double v) {
+        if (!std::isfinite(v))
+            return "null";
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.6g", v);
+        return buf;
+    }
+
+#ifdef NDEBUG
+    constexpr const char* kBuild = "release";
+#else
+    constexpr const char* kBuild = "debug";
+#endif
+
+    // One object per run: the context it ran in, then every Report in order. Stable keys
+    // so results from different releases can be diffed.
+    bool writeJson(const std::string& path, bool cpu, const std::string& filter) {
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "krnl_bench: cannot write " << path << "\n";
+            return false;
+        }
+
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        out << "{\n  \"context\": {\n";
+        out << "    \"date\": " << jsonString(date) << ",\n";
+        out << "    \"adapter\": " << jsonString(cpu ? "fallback" : "default") << ",\n";
+        out << "    \"build\": " << jsonString(kBuild) << ",\n";
+        out << "    \"filter\": " << jsonString(filter) << "\n";
+        out << "  },\n  \"results\": [";
+        const auto& results = krnl::bench::Results();
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            out << (i ? ",\n    " : "\n    ");
+            out << "{ \"benchmark\": " << jsonString(r.benchmark)
+                << ", \"metric\": " << jsonString(r.metric)
+                << ", \"value\": " << jsonNumber(r.value)
+                << ", \"unit\": " << jsonString(r.unit) << " }";
+        }
+        out << "\n  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+} // namespace
+
+static void usage() {
+    std::cout << "usage: krnl_bench [--cpu] [--list] [--filter <substring>] [--trace <file.json>] [--json <file.json>]\n";
+}
+
+int main(int argc, char** argv)
+{
+    bool cpu = false;
+    bool list = false;
+    std::string filter;
+    std::string trace;
+    std::string json;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cpu") == 0) {
+            cpu = true;
+        }
+        else if (std::strcmp(argv[i], "--list") == 0) {
+            list = true;
+        }
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json = argv[++i];
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (list) {
+        for (const auto& b : krnl::bench::Registry())
+            std::cout << b.name << "\n";
+        return 0;
+    }
+
+    krnl::Instance instance;
+    krnl::bench::Context ctx{ instance, cpu, trace };
+    {
+        krnl::Device probe(instance, ctx.deviceOptions());
+        if (!probe.IsValid()) {
+            std::cerr << "krnl_bench: no usable device\n";
+            return 1;
+        }
+    }
+
+    for (const auto& b : krnl::bench::Registry()) {
+        if (!filter.empty() && std::string(b.name).find(filter) == std::string::npos)
+            continue;
+        b.fn(ctx);
+    }
+
+    if (!json.empty() && !writeJson(json, cpu, filter))
+        return 1;
+    return 0;
+}
@@ -8,18 +8,82 @@
 
 namespace py = pybind11;
 
-//TEST
-PYBIND11_MODULE(krnl_python, m) {
+// The module name must match the pybind11_add_module target (krnl_py)
+PYBIND11_MODULE(krnl_py, m) {
 	m.doc() = "Python bindings for krnl library";
 	py::enum_<krnl::BufferUsageType>(m, "BufferUsageType")
-		.value("None", krnl::BufferUsageType::None)
+		.value("Storage", krnl::BufferUsageType::Storage)
+		.value("Uniform", krnl::BufferUsageType::Uniform)
 		.value("CopySrc", krnl::BufferUsageType::CopySrc)
 		.value("CopyDst", krnl::BufferUsageType::CopyDst)
-		.value("Index", krnl::BufferUsageType::Index)
-		.value("Vertex", krnl::BufferUsageType::Vertex)
-		.value("Uniform", krnl::BufferUsageType::Uniform)
-		.value("Storage", krnl::BufferUsageType::Storage)
-		.value("Indirect", krnl::BufferUsageType::Indirect)
-		.value("QueryResolve", krnl::BufferUsageType::QueryResolve)
+		.value("MapRead", krnl::BufferUsageType::MapRead)
+		.value("MapWrite", krnl::BufferUsageType::MapWrite)
 		.export_values();
-}
\ No newline at end of file
+
+	py::class_<krnl::Instance>(m, "Instance")
+		.def(py::init<>())
+		.def("process_events", &krnl::Instance::ProcessEvents);
+
+	py::class_<krnl::DeviceOptions>(m, "DeviceOptions")
+		.def(py::init<>())
+		.def_readwrite("enable_disk_cache", &krnl::DeviceOptions::enableDiskCache)
+		.def_readwrite("force_fallback_adapter", &krnl::DeviceOptions::forceFallbackAdapter)
+		.def_readwrite("request_adapter_limits", &krnl::DeviceOptions::requestAdapterLimits)
+		.def_readwrite("max_pending_submits", &krnl::DeviceOptions::maxPendingSubmits)
+		.def_readwrite("thread_safe", &krnl::DeviceOptions::threadSafe)
+		.def_readwrite("enable_profiling", &krnl::DeviceOptions::enableProfiling);
+
+	using Metrics = krnl::Metrics;
+
+	py::class_<Metrics::Histogram>(m, "Histogram")
+		.def_readonly("bounds_us", &Metrics::Histogram::boundsUs)
+		.def_readonly("counts", &Metrics::Histogram::counts)
+		.def_readonly("count", &Metrics::Histogram::count)
+		.def_readonly("sum_us", &Metrics::Histogram::sumUs)
+		.def_readonly("max_us", &Metrics::Histogram::maxUs)
+		.def("mean_us", &Metrics::Histogram::MeanUs)
+		.def("percentile_us", &Metrics::Histogram::PercentileUs, py::arg("p"));
+
+	py::class_<Metrics::LabelStats>(m, "LabelStats")
+		.def_readonly("label", &Metrics::LabelStats::label)
+		.def_readonly("count", &Metrics::LabelStats::count)
+		.def_readonly("bytes", &Metrics::LabelStats::bytes);
+
+	py::class_<Metrics::Snapshot>(m, "MetricsSnapshot")
+		.def_readonly("uptime_seconds", &Metrics::Snapshot::uptimeSeconds)
+		.def_readonly("live_buffers", &Metrics::Snapshot::liveBuffers)
+		.def_readonly("live_buffer_bytes", &Metrics::Snapshot::liveBufferBytes)
+		.def_readonly("buffers_by_label", &Metrics::Snapshot::buffersByLabel)
+		.def_readonly("gpu_memory_bytes", &Metrics::Snapshot::gpuMemoryBytes)
+		.def_readonly("gpu_memory_high_water", &Metrics::Snapshot::gpuMemoryHighWater)
+		.def_readonly("allocator_reserved_bytes", &Metrics::Snapshot::allocatorReservedBytes)
+		.def_readonly("allocator_used_bytes", &Metrics::Snapshot::allocatorUsedBytes)
+		.def_readonly("allocator_live_allocations", &Metrics::Snapshot::allocatorLiveAllocations)
+		.def_readonly("staging_ready_chunks", &Metrics::Snapshot::stagingReadyChunks)
+		.def_readonly("staging_inflight_chunks", &Metrics::Snapshot::stagingInflightChunks)
+		.def_readonly("staging_ready_bytes", &Metrics::Snapshot::stagingReadyBytes)
+		.def_readonly("staging_inflight_bytes", &Metrics::Snapshot::stagingInflightBytes)
+		.def_readonly("staging_uploads", &Metrics::Snapshot::stagingUploads)
+		.def_readonly("staging_upload_bytes", &Metrics::Snapshot::stagingUploadBytes)
+		.def_readonly("staging_readbacks", &Metrics::Snapshot::stagingReadbacks)
+		.def_readonly("staging_chunk_hit_rate", &Metrics::Snapshot::stagingChunkHitRate)
+		.def_readonly("staging_readback_hit_rate", &Metrics::Snapshot::stagingReadbackHitRate)
+		.def_readonly("pipeline_cache_hits", &Metrics::Snapshot::pipelineCacheHits)
+		.def_readonly("pipeline_cache_misses", &Metrics::Snapshot::pipelineCacheMisses)
+		.def_readonly("pipeline_cache_entries", &Metrics::Snapshot::pipelineCacheEntries)
+		.def_readonly("pipeline_cache_hit_rate", &Metrics::Snapshot::pipelineCacheHitRate)
+		.def_readonly("command_buffers_submitted", &Metrics::Snapshot::commandBuffersSubmitted)
+		.def_readonly("queue_submits", &Metrics::Snapshot::queueSubmits)
+		.def_readonly("submits_per_second", &Metrics::Snapshot::submitsPerSecond)
+		.def_readonly("map_wait", &Metrics::Snapshot::mapWait);
+
+	py::class_<krnl::Device>(m, "Device")
+		.def(py::init<const krnl::Instance&, const krnl::DeviceOptions&>(),
+			py::arg("instance"), py::arg("options") = krnl::DeviceOptions{},
+			py::keep_alive<1, 2>())
+		.def("is_valid", &krnl::Device::IsValid)
+		.def("flush", &krnl::Device::Flush)
+		// A fresh snapshot per call; submits_per_second covers the time since the previous one
+		.def("metrics", &krnl::Device::GetMetricsSnapshot)
+		.def("reset_map_wait", [](const krnl::Device& device) { device.GetMetrics().ResetMapWait(); });
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "core/metrics.hpp"
+
+namespace krnl {
+
+    class BufferAllocator;
+
+    /**
+     * A range carved out of one of the allocator's heap buffers (or a dedicated buffer
+     * for very large requests). Shared by every krnl::Buffer copy that views it and
+     * handed back to the allocator when the last one goes away.
+     */
+    class BufferAllocation {
+    public:
+        BufferAllocation() = default;
+        ~BufferAllocation();
+
+        BufferAllocation(const BufferAllocation&) = delete;
+        BufferAllocation& operator=(const BufferAllocation&) = delete;
+
+        const wgpu::Buffer& GetBuffer() const { return m_Buffer; }
+        uint64_t GetOffset() const { return m_Offset; }
+        uint64_t GetSize() const { return m_Size; }   // reserved bytes (rounded up)
+
+    private:
+        friend class BufferAllocator;
+        enum class Kind : uint8_t { Slab, Buddy, Dedicated };
+
+        wgpu::Buffer m_Buffer;
+        uint64_t m_Offset = 0;
+        uint64_t m_Size = 0;
+        uint64_t m_Requested = 0;
+
+        Kind m_Kind = Kind::Dedicated;
+        void* m_Home = nullptr;     // SlabPage* or Block* inside the allocator
+        uint32_t m_Slot = 0;        // slab slot index or buddy order
+        std::weak_ptr<BufferAllocator> m_Owner;
+        Metrics::GpuMemory m_Memory;    // dedicated buffers only; heap blocks count their own
+    };
+    using BufferAllocationPtr = std::shared_ptr<BufferAllocation>;
+
+    /**
+     * Device-memory sub-allocator. Requests are served from a few large wgpu::Buffers per
+     * usage combination:
+     * - small sizes (<= maxSlabSize) come from size-classed slabs (power-of-two slots)
+     * - larger sizes come from a buddy allocator over blockSize heap buffers
+     * - anything above blockSize gets a dedicated buffer
+     * All offsets are aligned to 256 bytes so views can be bound as storage or uniform.
+     * Sub-allocated memory is recycled, so unlike CreateBuffer its contents start undefined.
+     */
+    class BufferAllocator : public std::enable_shared_from_this<BufferAllocator> {
+    public:
+        struct Config {
+            uint64_t blockSize = 64ull << 20;       // bytes per heap buffer
+            uint64_t minBuddySize = 64ull << 10;    // smallest buddy range, also the slab page unit
+            uint64_t maxSlabSize = 64ull << 10;     // largest request served by slabs
+            uint64_t alignment = 256;               // smallest slab slot and offset alignment
+        };
+
+        struct Stats {
+            uint64_t liveAllocations = 0;
+            uint64_t requestedBytes = 0;    // sum of live request sizes
+            uint64_t usedBytes = 0;         // sum of live reserved (rounded) sizes
+            uint64_t reservedBytes = 0;     // heap blocks + dedicated buffers
+            uint64_t freeBytes = 0;         // heap bytes not reserved by a live allocation
+            uint64_t largestFreeRange = 0;  // largest buddy range that can still be handed out
+            uint64_t heapBlocks = 0;
+            uint64_t dedicatedAllocations = 0;
+            uint64_t totalAllocations = 0;  // since creation
+
+            // Bytes lost to size rounding, as a fraction of used bytes
+            double internalFragmentation() const {
+                return usedBytes ? 1.0 - static_cast<double>(requestedBytes) / static_cast<double>(usedBytes) : 0.0;
+            }
+            // 0 when all free heap memory is one contiguous range, approaching 1 when it is scattered
+            double externalFragmentation() const {
+                return freeBytes ? 1.0 - static_cast<double>(largestFreeRange) / static_cast<double>(freeBytes) : 0.0;
+            }
+        };
+
+        static std::shared_ptr<BufferAllocator> Create(wgpu::Device device);
+        static std::shared_ptr<BufferAllocator> Create(wgpu::Device device, const Config& cfg);
+        ~BufferAllocator();
+
+        BufferAllocator(const BufferAllocator&) = delete;
+        BufferAllocator& operator=(const BufferAllocator&) = delete;
+
+        BufferAllocationPtr Allocate(uint64_t size, wgpu::BufferUsage usage, const char* label = nullptr);
+
+        Stats GetStats() const;
+
+        // Count heap blocks and dedicated buffers as GPU memory
+        void SetMetrics(std::shared_ptr<Metrics> metrics) { m_Metrics = std::move(metrics); }
+
+        // Release heap blocks that hold no live allocations.
+        void Trim();
+
+    private:
+        struct Block;
+        struct SlabPage;
+        struct SlabClass;
+        struct Heap;
+
+        BufferAllocator(wgpu::Device device, const Config& cfg);
+
+        friend class BufferAllocation;
+        void release(BufferAllocation& allocation);
+
+        Heap& heapFor(wgpu::BufferUsage usage);
+        Block* createBlock(Heap& heap);
+        bool buddyAllocate(Heap& heap, uint32_t order, Block*& block, uint64_t& offset);
+        void buddyFree(Block* block, uint64_t offset, uint32_t order);
+        void releaseBlockIfEmpty(Block* block);
+        uint32_t orderFor(uint64_t size) const;
+        uint64_t orderSize(uint32_t order) const { return m_Cfg.minBuddySize << order; }
+
+        wgpu::Device m_Device;
+        Config m_Cfg;
+        uint32_t m_MaxOrder = 0;
+        std::shared_ptr<Metrics> m_Metrics;
+
+        mutable std::mutex m_Mutex;
+        std::unordered_map<uint64_t, std::unique_ptr<Heap>> m_Heaps;
+        Stats m_Stats;
+    };
+
+} // namespace krnl
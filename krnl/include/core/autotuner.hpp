@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace krnl {
+
+    class CommandList;
+    class Device;
+
+    /**
+     * Picks the fastest of several interchangeable variants of a kernel (workgroup size,
+     * elements per thread, vectorized or not, tile shape) by timing them on the device, and
+     * remembers the choice per (adapter, kernel, size bucket). Choices are written to a text
+     * file so later runs on the same adapter skip tuning; the adapter key
+     * (Device::GetAdapterKey) changes with the driver and Dawn version, so an upgrade retunes.
+     *
+     * Timing is on the host around submits: a variant is launched until a trial lasts
+     * Options::minTrialMs, and the best of Options::trials trials counts. Tuning blocks until
+     * the queue is idle, once per key.
+     *
+     * Thread-safe.
+     */
+    class Autotuner {
+    public:
+        struct Variant {
+            // Stored in the results file; must not contain tabs or newlines
+            std::string name;
+            // Record one launch of the variant into cmd
+            std::function<void(CommandList& cmd)> encode;
+        };
+
+        struct Measurement {
+            std::string variant;
+            double ms = 0.0;    // per launch; infinity if it could not be timed
+        };
+
+        struct Options {
+            uint32_t trials = 3;
+            // Launches per trial grow until one trial takes at least this long
+            double minTrialMs = 2.0;
+            uint32_t maxLaunchesPerTrial = 256;
+        };
+
+        // Results live only in memory when file is empty; otherwise it is loaded now and
+        // rewritten after every new choice.
+        explicit Autotuner(std::filesystem::path file = {});
+        Autotuner(std::filesystem::path file, const Options& options);
+
+        Autotuner(const Autotuner&) = delete;
+        Autotuner& operator=(const Autotuner&) = delete;
+
+        // Process-wide tuner persisted to $KRNL_AUTOTUNE_FILE, or autotune.txt under
+        // DiskCache::DefaultRoot()
+        static Autotuner& Default();
+
+        // Each size rounded up to a power of two: { 1000, 64 } -> "1024x64"
+        static std::string SizeBucket(std::initializer_list<uint64_t> sizes);
+        // "<adapter key>|<kernel>|<bucket>"
+        static std::string Key(const Device& device, const std::string& kernel, const std::string& bucket);
+
+        // Name of the fastest variant for this key. On a miss every variant is measured and the
+        // winner stored; a stored name no longer among the variants counts as a miss. With
+        // tuning off a miss returns nullopt and the caller falls back to its own default.
+        std::optional<std::string> Select(const Device& device, const std::string& kernel,
+            const std::string& bucket, const std::vector<Variant>& variants);
+
+        // Time every variant now, without consulting or updating the stored choices
+        std::vector<Measurement> Measure(const Device& device, const std::vector<Variant>& variants) const;
+
+        // On by default
+        void SetTuning(bool enabled) { m_Tuning = enabled; }
+        bool IsTuning() const { return m_Tuning; }
+
+        std::optional<std::string> Find(const std::string& key) const;
+        void Set(const std::string& key, const std::string& variant, double ms = 0.0);
+        // Forget every choice, in memory and in the file
+        void Clear();
+        size_t Size() const;
+
+        // Merge the file's choices into memory; false if it exists but can't be read
+        bool Load();
+        // Write every choice to the file (temp file + rename); false on failure
+        bool Save() const;
+        const std::filesystem::path& GetFile() const { return m_File; }
+
+    private:
+        struct Choice {
+            std::string variant;
+            double ms = 0.0;
+        };
+
+        double timeLaunches(const Device& device, const Variant& variant, uint32_t launches) const;
+
+        std::filesystem::path m_File;
+        Options m_Options;
+        std::atomic<bool> m_Tuning{ true };
+
+        mutable std::mutex m_Mutex;
+        std::unordered_map<std::string, Choice> m_Choices;
+        mutable uint64_t m_SaveCounter = 0;
+    };
+
+} // namespace krnl
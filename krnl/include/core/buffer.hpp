@@ -8,6 +8,7 @@
 
 #include "core/device.hpp"
 #include "core/future.hpp"
+#include "core/mappedview.hpp"
 
 namespace krnl {
 
@@ -45,22 +46,44 @@ namespace krnl {
 
     class Buffer {
     public:
+        // data is nullptr (and size 0) when the readback's map failed
         using ReadCallback = std::function<void(const void* data, size_t size)>;
+        using MappedCallback = std::function<void(MappedView view)>;
 
         Buffer() = default;
 		Buffer(const Device& device, size_t sizeBytes, BufferUsageType usage, std::string label , bool mappedAtCreation = false);
 
-		Future MapAsync(MapMode mode, size_t offset, size_t size ,void* data);
+        // View into one of the device allocator's shared heap buffers: no CreateBuffer call for
+        // small and medium sizes. Contents start undefined (memory is recycled). Map usages can't
+        // share a heap and fall back to a dedicated buffer.
+        static Buffer Suballocate(const Device& device, size_t sizeBytes, BufferUsageType usage, std::string label);
+
+		// Map [offset, offset + size) and copy it into data (Read) or data into it (Write), then unmap.
+		Future<> MapAsync(MapMode mode, size_t offset, size_t size ,void* data);
+		// Zero-copy map: cb gets a view over the mapped range (invalid if mapping failed). The
+		// buffer stays mapped for as long as the view lives; move it out of cb to keep it.
+		// offset must be a multiple of 8 and size a multiple of 4.
+		Future<> MapAsync(MapMode mode, size_t offset, size_t size, MappedCallback cb);
+		// View of a range that is already mapped (mappedAtCreation, or after MapAsync completed).
+		MappedView GetMappedView(MapMode mode, size_t offset, size_t size) const;
 		void WriteBuffer(const void* src, size_t bytes, size_t dstOffset = 0);
 
         const wgpu::Buffer GetNative() const { return m_Buffer; }
         size_t GetSize() const { return m_size; }
+        // Byte offset of this buffer's range inside GetNative() (non-zero for sub-allocated views)
+        size_t GetOffset() const { return m_Offset; }
 
-        //// High-performance write using mapped staging (create MapWrite staging, copy, submit)
+        //// High-performance write through the device's staging ring. The copy is submitted with
+        //// the next Device::Flush or CommandList::Submit; falls back to Queue::WriteBuffer when
+        //// the ring is at its in-flight chunk limit.
         void WriteViaStaging(const void* src, size_t bytes);
 
-        //// Async readback: copies into MapRead staging, maps it and calls cb with mapped data.
-        void ReadAsync(ReadCallback cb);
+        //// Async readback: copies into pooled MapRead staging, maps it and calls cb with mapped data.
+        //// cb runs when the returned future is waited on, from ProcessEvents, or spontaneously;
+        //// with (nullptr, 0) if the map failed.
+        Future<> ReadAsync(ReadCallback cb);
+        //// Same, with the bytes delivered as the future's value (empty if the map failed).
+        Future<std::vector<std::byte>> ReadAsync();
 
         //// Utility
         uint64_t sizeAlignedToUniform() const {
@@ -70,6 +93,8 @@ namespace krnl {
         }
 
     private:
+        Buffer(const Device& device, BufferAllocationPtr allocation, size_t sizeBytes, BufferUsageType usage, std::string label);
+
          wgpu::BufferDescriptor makeDesc(size_t size, wgpu::BufferUsage usage, const char* label, bool mappedAtCreation = false);
 
     private:
@@ -77,7 +102,10 @@ namespace krnl {
 		std::string m_Label;
         const Device& m_Device;
         size_t m_size = 0;
+        size_t m_Offset = 0;
         wgpu::Buffer m_Buffer;
+        BufferAllocationPtr m_Allocation;   // set for sub-allocated views
+        std::shared_ptr<Metrics::LiveBuffer> m_Tracking;
     };
 
 } // namespace krnl
@@ -0,0 +1,109 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace krnl {
+
+    class Buffer;
+    class CommandList;
+    class ParameterSet;
+
+    /**
+     * A recorded command sequence for replay, in the spirit of CUDA graphs. Between
+     * CommandList::BeginCapture and EndCapture, passes, Pipeline::encodeDispatch and buffer
+     * copies are appended here instead of being encoded. Replay() then encodes the whole
+     * sequence from a flat op list. It makes no ParameterSet or pipeline lookups, takes no
+     * locks, and skips SetPipeline/SetBindGroup calls that would not change state.
+     *
+     * WebGPU cannot reuse a compute command buffer, so each replay still encodes the
+     * commands. The saving is the host work around them.
+     *
+     * Replay can substitute buffers: bind groups that reference a substituted buffer are
+     * recreated (and cached per substitution), and copies are redirected, so one capture
+     * can serve e.g. double-buffered inputs. Captured pipelines, bind groups and buffers are
+     * held by handle; a capture is not thread-safe.
+     */
+    class CommandCapture {
+    public:
+        // 'to' must be at least as large as 'from'; bindings and copies keep their captured sizes
+        struct Substitution {
+            const Buffer* from = nullptr;
+            const Buffer* to = nullptr;
+        };
+
+        CommandCapture() = default;
+
+        CommandCapture(const CommandCapture&) = delete;
+        CommandCapture& operator=(const CommandCapture&) = delete;
+        CommandCapture(CommandCapture&&) = default;
+        CommandCapture& operator=(CommandCapture&&) = default;
+
+        // Encode the captured commands into cmd (which must not be capturing itself)
+        void Replay(CommandList& cmd);
+        void Replay(CommandList& cmd, const std::vector<Substitution>& substitutions);
+
+        size_t GetOpCount() const { return m_Ops.size(); }
+        size_t GetDispatchCount() const { return m_Dispatches; }
+        bool Empty() const { return m_Ops.empty(); }
+        void Reset();
+
+        // Recording, called by CommandList and Pipeline while capturing
+        void RecordBeginPass();
+        void RecordEndPass();
+        void RecordDispatch(const wgpu::ComputePipeline& pipeline, const ParameterSet& params, uint32_t x, uint32_t y, uint32_t z);
+        void RecordCopy(const wgpu::Buffer& src, uint64_t srcOffset, const wgpu::Buffer& dst, uint64_t dstOffset, uint64_t size);
+
+    private:
+        enum class OpType : uint8_t { BeginPass, EndPass, SetPipeline, SetBindGroup, Dispatch, Copy };
+
+        // Pipelines, bind groups and copies live in side tables; an op is 16 bytes
+        struct Op {
+            OpType type;
+            uint32_t args[3];
+        };
+
+        struct Binding {
+            wgpu::Buffer buffer;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+
+        struct Group {
+            wgpu::BindGroup group;
+            wgpu::BindGroupLayout layout;
+            std::vector<Binding> bindings;
+        };
+
+        struct Copy {
+            Binding src;
+            Binding dst;
+        };
+
+        struct Resolved {
+            wgpu::Buffer buffer;
+            uint64_t offset = 0;
+            bool substituted = false;
+        };
+
+        Resolved resolve(const wgpu::Buffer& buffer, uint64_t offset, const std::vector<Substitution>& substitutions) const;
+        wgpu::BindGroup groupFor(const wgpu::Device& device, uint32_t index, const std::vector<Substitution>& substitutions);
+
+        std::vector<Op> m_Ops;
+        std::vector<wgpu::ComputePipeline> m_Pipelines;
+        std::vector<Group> m_Groups;
+        std::vector<Copy> m_Copies;
+        size_t m_Dispatches = 0;
+
+        // Capture-time state, to drop redundant binds
+        bool m_InPass = false;
+        int64_t m_CurrentPipeline = -1;
+        int64_t m_CurrentGroup = -1;
+
+        // Bind groups rebuilt for substitutions, keyed by group index + replacement buffers
+        std::unordered_map<uint64_t, wgpu::BindGroup> m_SubstitutedGroups;
+    };
+
+} // namespace krnl
@@ -1,16 +1,23 @@
 #pragma once
 
 #include <webgpu/webgpu_cpp.h>
+#include <memory>
+#include <string>
+#include <vector>
 #include "core/device.hpp"
 #include "core/buffer.hpp"
+#include "core/capture.hpp"
 
 namespace krnl {
 
+    // Records into its own encoder: separate CommandLists on the same device may be recorded
+    // concurrently from different threads (see DeviceOptions::threadSafe). A single
+    // CommandList must not be shared between threads while recording.
     class CommandList {
     public:
-        CommandList(const Device& device)
-            : m_Device(device), m_Encoder(device.GetNative().CreateCommandEncoder()) {
-        }
+        // On an invalid device the error is logged and the list stays empty: passes, copies,
+        // Finish and Submit do nothing
+        CommandList(const Device& device);
 
         ~CommandList() = default;
 
@@ -22,17 +29,43 @@ namespace krnl {
         void EndComputePass();
 
         void CopyBufferToBuffer(const Buffer& src, const Buffer& dst, size_t size);
+        // Offsets are relative to each Buffer's own range (sub-allocated views included)
+        void CopyBufferToBuffer(const Buffer& src, size_t srcOffset, const Buffer& dst, size_t dstOffset, size_t size);
+
+        // Until EndCapture, passes, dispatches and copies are recorded into capture instead of
+        // being encoded; encode them later with capture.Replay (see CommandCapture)
+        void BeginCapture(CommandCapture& capture);
+        void EndCapture();
+        bool IsCapturing() const { return m_Capture != nullptr; }
+        CommandCapture* GetCapture() const { return m_Capture; }
+
+        // Keep a resource alive until the list is destroyed. Kernels that allocate temporaries
+        // while recording (tensor ops) park them here, so a sub-allocated range can't be
+        // handed out again and rewritten before the commands using it are submitted.
+        void Retain(std::shared_ptr<const void> resource) { m_Retained.push_back(std::move(resource)); }
+
+        // Called by Pipeline::encodeDispatch; names the current pass for the device profiler
+        void NoteDispatch(const std::string& label) const;
 
         wgpu::CommandBuffer Finish();
         void Submit();
+        // Submit in the position reserved with device.GetSubmitQueue().Reserve(), after every
+        // earlier ticket regardless of which thread finishes recording first
+        void Submit(SubmitQueue::Ticket ticket);
 
+		const Device& GetDevice() const { return m_Device; }
 		const wgpu::CommandEncoder& GetEncoder() const { return m_Encoder; }
+		// Null while no compute pass is open
 		const wgpu::ComputePassEncoder& GetComputePass() const { return m_ComputePass; }
 
     private:
         const Device& m_Device;
         wgpu::CommandEncoder m_Encoder;
         wgpu::ComputePassEncoder m_ComputePass;
+        CommandCapture* m_Capture = nullptr;
+        // Set when the device has a profiler
+        std::shared_ptr<Profiler::ListRecord> m_Profile;
+        std::vector<std::shared_ptr<const void>> m_Retained;
     };
 
 } // namespace krnl
@@ -1,14 +1,76 @@
 #pragma once
 #include <webgpu/webgpu_cpp.h>
+#include <cassert>
+#include <memory>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
 #include "core/instance.hpp"
+#include "core/pipelinecache.hpp"
+#include "core/diskcache.hpp"
+#include "core/allocator.hpp"
+#include "core/metrics.hpp"
+#include "core/stagingpool.hpp"
+#include "core/profiler.hpp"
+#include "core/submitqueue.hpp"
+#include "core/uploadbatch.hpp"
 
 namespace krnl
 {
 
+	struct DeviceOptions
+	{
+		// Persist compiled shader/pipeline blobs across runs (native builds only)
+		bool enableDiskCache = true;
+		// Cache root; empty means DiskCache::DefaultRoot()
+		std::filesystem::path cacheDirectory;
+		// Use the CPU fallback adapter (SwiftShader) instead of a hardware GPU
+		bool forceFallbackAdapter = false;
+		// Adapter selection. The preference picks between GPUs; backendType (Undefined = any)
+		// and adapterType (empty = any, CPU = the fallback adapter) filter the candidates.
+		wgpu::PowerPreference powerPreference = wgpu::PowerPreference::HighPerformance;
+		wgpu::BackendType backendType = wgpu::BackendType::Undefined;
+		std::optional<wgpu::AdapterType> adapterType;
+		// Request everything the adapter supports instead of the WebGPU default limits (128 MB
+		// storage bindings, 16 KB workgroup storage, 256 invocations per workgroup). Opt-in:
+		// code written against such a device may not run on one with the defaults.
+		bool requestAdapterLimits = false;
+		// Enabled when the adapter has them (e.g. ShaderF16, Subgroups, TimestampQuery);
+		// check Device::HasFeature before relying on one
+		std::vector<wgpu::FeatureName> optionalFeatures;
+		// Device creation fails if the adapter lacks any of these
+		std::vector<wgpu::FeatureName> requiredFeatures;
+		// Command buffers the submission queue collects before submitting on its own; 1 = submit immediately
+		size_t maxPendingSubmits = 16;
+		// Let several threads record CommandLists and create resources concurrently (Dawn's
+		// ImplicitDeviceSynchronization; native builds, when the adapter supports it). Off by
+		// default: the implicit device lock costs every single-threaded call.
+		bool threadSafe = false;
+		// Time compute passes (TimestampQuery when available, host timing around submits
+		// otherwise) and record host spans; see Device::GetProfiler
+		bool enableProfiling = false;
+	};
+
+	// The adapter a device was created on
+	struct AdapterDescription
+	{
+		std::string vendor;
+		std::string architecture;
+		std::string device;
+		std::string description;
+		wgpu::BackendType backendType = wgpu::BackendType::Undefined;
+		wgpu::AdapterType adapterType = wgpu::AdapterType::Unknown;
+		uint32_t vendorID = 0;
+		uint32_t deviceID = 0;
+	};
+
     class Device
     {
     public:
-        explicit Device(const Instance& instance);
+        // On failure (no matching adapter, missing required feature, device request rejected)
+        // the device is left invalid: check IsValid() before using it.
+        explicit Device(const Instance& instance, const DeviceOptions& options = {});
 
         Device(Device&&) = default;
         Device& operator=(Device&&) = default;
@@ -19,14 +81,74 @@ namespace krnl
 
 		~Device() = default;
         const wgpu::Device GetNative() const { return m_Device; }
+		// Instance the device was created from; it must outlive the device
+		const Instance& GetInstance() const { return *m_Instance; }
 		const wgpu::Queue getQueue() const { return m_Queue; }
 
+		// The members below only exist on a valid device (see IsValid)
+
+		// Compiled compute pipelines shared by every Pipeline created on this device
+		PipelineCache& GetPipelineCache() const { assert(m_PipelineCache && "invalid Device"); return *m_PipelineCache; }
+		// Sub-allocator behind Buffer::Suballocate
+		BufferAllocator& GetAllocator() const { assert(m_Allocator && "invalid Device"); return *m_Allocator; }
+		// Upload ring shared by Buffer::WriteViaStaging and batched uploads
+		PersistentStagingPool& GetStagingPool() const { assert(m_StagingPool && "invalid Device"); return *m_StagingPool; }
+		// Batches command buffers into fewer Queue::Submit calls
+		SubmitQueue& GetSubmitQueue() const { assert(m_SubmitQueue && "invalid Device"); return *m_SubmitQueue; }
+		// Small-write batcher flushed by CommandList::Submit
+		UploadBatch& GetUploadBatch() const { assert(m_UploadBatch && "invalid Device"); return *m_UploadBatch; }
+		// Null unless DeviceOptions::enableProfiling
+		Profiler* GetProfiler() const { return m_Profiler.get(); }
+		// Runtime counters: live buffers, GPU memory, map waits
+		Metrics& GetMetrics() const { assert(m_Metrics && "invalid Device"); return *m_Metrics; }
+		// Metrics plus the pipeline cache, staging pool, allocator and submit queue stats.
+		// submitsPerSecond covers the time since the previous call.
+		Metrics::Snapshot GetMetricsSnapshot() const;
+		// Null when the on-disk blob cache is disabled
+		const DiskCache* GetDiskCache() const { return m_DiskCache.get(); }
+
         bool IsValid() const { return m_Device != nullptr; }
 
+		// Limits the device was created with (the adapter's with DeviceOptions::requestAdapterLimits)
+		const wgpu::Limits& GetLimits() const { return m_Limits; }
+		// Features enabled on the device
+		const std::vector<wgpu::FeatureName>& GetFeatures() const { return m_Features; }
+		bool HasFeature(wgpu::FeatureName feature) const;
+		const AdapterDescription& GetAdapter() const { return m_Adapter; }
+		// Identifies the adapter, its driver and the Dawn version; keys per-adapter caches
+		// (the on-disk blob cache, Autotuner results)
+		const std::string& GetAdapterKey() const { return m_AdapterKey; }
+		// True if the device was created with implicit synchronization (see DeviceOptions::threadSafe)
+		bool IsThreadSafe() const { return m_ThreadSafe; }
+
+		// Submit everything recorded so far: batched uploads, then pending command buffers.
+		// Both are no-ops on an invalid device.
+		void Flush() const;
+		// Flush, then block until the queue has executed everything submitted
+		void WaitIdle() const;
+
     private:
         Device() = default;
+		const Instance* m_Instance = nullptr;
+		// Declared first so it outlives m_Device: Dawn calls into it until the device is released
+		std::unique_ptr<DiskCache> m_DiskCache;
         wgpu::Device m_Device;
 		wgpu::Queue m_Queue;
+		bool m_ThreadSafe = false;
+		wgpu::Limits m_Limits{};
+		std::vector<wgpu::FeatureName> m_Features;
+		AdapterDescription m_Adapter;
+		std::string m_AdapterKey;
+		std::shared_ptr<Metrics> m_Metrics;
+		std::unique_ptr<PipelineCache> m_PipelineCache;
+		std::shared_ptr<BufferAllocator> m_Allocator;
+		// Before the submit queue, which records into it until it is destroyed
+		std::unique_ptr<Profiler> m_Profiler;
+		// Before the pool and upload batch, which submit through it until they are destroyed
+		std::unique_ptr<SubmitQueue> m_SubmitQueue;
+		std::unique_ptr<PersistentStagingPool> m_StagingPool;
+		// After the pool: its destructor flushes into it
+		std::unique_ptr<UploadBatch> m_UploadBatch;
     };
 
 } // namespace krnl
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+namespace krnl {
+
+    /**
+     * On-disk key/value store backing Dawn's blob cache (DawnCacheDeviceDescriptor).
+     * Dawn hands us opaque keys for compiled shaders and pipelines; each entry is a
+     * file named after the key hash, inside a directory versioned by isolation key
+     * (adapter + Dawn version), so a driver or Dawn upgrade never reads stale blobs.
+     */
+    class DiskCache {
+    public:
+        struct Stats {
+            uint64_t loads = 0;     // lookups that found a blob
+            uint64_t misses = 0;    // lookups that found nothing
+            uint64_t stores = 0;
+            uint64_t bytesLoaded = 0;
+            uint64_t bytesStored = 0;
+        };
+
+        DiskCache(const std::filesystem::path& root, std::string isolationKey);
+
+        DiskCache(const DiskCache&) = delete;
+        DiskCache& operator=(const DiskCache&) = delete;
+
+        // Dawn protocol: returns the stored size; copies the blob only when valueSize is large enough.
+        size_t Load(const void* key, size_t keySize, void* value, size_t valueSize);
+        void Store(const void* key, size_t keySize, const void* value, size_t valueSize);
+
+        // C callbacks matching DawnLoadCacheDataFunction / DawnStoreCacheDataFunction.
+        static size_t LoadCallback(const void* key, size_t keySize, void* value, size_t valueSize, void* userdata);
+        static void StoreCallback(const void* key, size_t keySize, const void* value, size_t valueSize, void* userdata);
+
+        const std::filesystem::path& GetDirectory() const { return m_Directory; }
+        const std::string& GetIsolationKey() const { return m_IsolationKey; }
+        Stats GetStats() const;
+
+        // $KRNL_CACHE_DIR if set, otherwise <system temp>/krnl_cache
+        static std::filesystem::path DefaultRoot();
+
+    private:
+        std::filesystem::path entryPath(const void* key, size_t keySize) const;
+
+        std::filesystem::path m_Directory;
+        std::string m_IsolationKey;
+        bool m_Usable = false;
+
+        mutable std::mutex m_Mutex;
+        Stats m_Stats;
+        uint64_t m_TempCounter = 0;
+    };
+
+} // namespace krnl
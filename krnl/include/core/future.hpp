@@ -1,14 +1,392 @@
 #pragma once
 #include <webgpu/webgpu_cpp.h>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
 
 namespace krnl {
+
+	class Instance;
+
+	template<typename T = void>
+	class Future;
+
+	namespace detail {
+
+		/**
+		 * Shared completion state behind a Future. A leaf state completes when its native
+		 * wgpu::Future does; a derived state (Then, WhenAll, coroutines) completes from a
+		 * continuation, and lists the states it is waiting on in deps so that a blocking
+		 * wait can find the native futures to WaitAny on.
+		 */
+		struct FutureStateBase {
+			const Instance* instance = nullptr;
+			wgpu::Future native{};
+			std::atomic<bool> registered{ false };  // native handed to the instance's tracking
+
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool ready = false;
+			std::vector<std::shared_ptr<FutureStateBase>> deps;
+			std::vector<std::function<void()>> continuations;
+
+			bool IsReady() {
+				std::lock_guard<std::mutex> l(mutex);
+				return ready;
+			}
+
+			// Idempotent. Continuations run on the calling thread.
+			void SetReady() {
+				std::vector<std::function<void()>> run;
+				{
+					std::lock_guard<std::mutex> l(mutex);
+					if (ready)
+						return;
+					ready = true;
+					deps.clear();
+					run = std::move(continuations);
+				}
+				cv.notify_all();
+				for (auto& fn : run)
+					fn();
+			}
+
+			// False (and fn not stored) if the state is already ready.
+			bool AddContinuation(std::function<void()> fn) {
+				std::lock_guard<std::mutex> l(mutex);
+				if (ready)
+					return false;
+				continuations.push_back(std::move(fn));
+				return true;
+			}
+
+			// Run fn once ready; immediately if it already is.
+			void OnReady(std::function<void()> fn) {
+				if (!AddContinuation(fn))
+					fn();
+			}
+
+			void SetDeps(std::vector<std::shared_ptr<FutureStateBase>> d) {
+				std::lock_guard<std::mutex> l(mutex);
+				if (!ready)
+					deps = std::move(d);
+			}
+		};
+
+		template<typename T>
+		struct FutureState : FutureStateBase {
+			T value{};
+
+			void SetValue(T v) {
+				{
+					std::lock_guard<std::mutex> l(mutex);
+					value = std::move(v);
+				}
+				SetReady();
+			}
+		};
+
+		template<>
+		struct FutureState<void> : FutureStateBase {};
+
+		// Defined with Instance: hook a leaf's native future into the instance's completion
+		// tracking, and block on a state (driving WaitAny when there is no event pump).
+		void RegisterNative(const Instance& instance, const std::shared_ptr<FutureStateBase>& state);
+		bool WaitState(const Instance& instance, const std::shared_ptr<FutureStateBase>& state, uint64_t timeoutMs);
+
+		// The instance that can drive state: its own, or the first one found under its deps
+		inline const Instance* FindInstance(const std::shared_ptr<FutureStateBase>& state) {
+			std::vector<std::shared_ptr<FutureStateBase>> deps;
+			{
+				std::lock_guard<std::mutex> l(state->mutex);
+				if (state->instance)
+					return state->instance;
+				deps = state->deps;
+			}
+			for (const auto& d : deps) {
+				if (const Instance* instance = FindInstance(d))
+					return instance;
+			}
+			return nullptr;
+		}
+
+		template<typename R>
+		struct UnwrapFuture { using type = R; static constexpr bool isFuture = false; };
+		template<typename U>
+		struct UnwrapFuture<Future<U>> { using type = U; static constexpr bool isFuture = true; };
+
+		template<typename T, typename F>
+		struct ThenResult { using type = std::invoke_result_t<F, const T&>; };
+		template<typename F>
+		struct ThenResult<void, F> { using type = std::invoke_result_t<F>; };
+
+	} // namespace detail
+
+	/**
+	 * Completion handle for asynchronous GPU work, optionally carrying a value (Future<T>).
+	 * Futures returned by krnl complete through the owning Instance: its event pump, or
+	 * Instance::Wait / ProcessEvents on a caller thread. Then() continuations run on
+	 * whichever thread observes the completion (or the instance executor), so chains of
+	 * upload -> dispatch -> readback make progress without a host thread blocked per chain.
+	 *
+	 * A default-constructed future stands for work that already completed.
+	 */
+	template<typename T>
 	class Future {
 	public:
+		using State = detail::FutureState<T>;
+
 		Future() = default;
-		Future(const wgpu::Future& f): m_Future(f) {}
-		const wgpu::Future& GetNative() const { return m_Future;}
+		// Untracked native future; only completes through Instance::Wait
+		Future(const wgpu::Future& f) requires std::is_void_v<T>
+			: Future(std::make_shared<State>(), nullptr, f) {}
+		Future(const Instance& instance, const wgpu::Future& f)
+			: Future(std::make_shared<State>(), &instance, f) {}
+		// Leaf with an externally filled value: write state->value before the native completes
+		Future(std::shared_ptr<State> state, const Instance* instance, const wgpu::Future& f)
+			: m_State(std::move(state))
+		{
+			m_State->instance = instance;
+			m_State->native = f;
+			if (f.id == 0)
+				m_State->SetReady();
+			else if (instance)
+				detail::RegisterNative(*instance, m_State);
+		}
+		explicit Future(std::shared_ptr<State> state) : m_State(std::move(state)) {}
+
+		const wgpu::Future& GetNative() const {
+			static const wgpu::Future none{};
+			return m_State ? m_State->native : none;
+		}
+		bool IsValid() const { return m_State != nullptr; }
+		bool IsReady() const { return !m_State || m_State->IsReady(); }
+		const std::shared_ptr<State>& GetState() const { return m_State; }
+
+		// Value once ready; blocks through the owning instance (or the one of a future it
+		// waits on) if it is not yet. Without any instance it sleeps until a continuation on
+		// another thread completes the state; an untracked native future can only be waited
+		// on through Instance::Wait.
+		template<typename U = T>
+		const U& Get() const requires (!std::is_void_v<U>) {
+			if (!IsReady()) {
+				if (const Instance* instance = detail::FindInstance(m_State)) {
+					detail::WaitState(*instance, m_State, UINT64_MAX);
+				}
+				else {
+					assert(m_State->native.id == 0 && "Future::Get on an untracked native future; use Instance::Wait");
+					std::unique_lock<std::mutex> l(m_State->mutex);
+					m_State->cv.wait(l, [this] { return m_State->ready; });
+				}
+			}
+			return m_State->value;
+		}
+
+		// Chain fn (taking const T&, or nothing for Future<void>) after this future. If fn
+		// returns a Future, the result completes when that one does.
+		template<typename F>
+		auto Then(F&& fn) const;
+
+#if defined(__cpp_impl_coroutine)
+		struct Awaiter;
+		Awaiter operator co_await() const;
+		struct promise_type;
+#endif
 
 	private:
-		wgpu::Future m_Future;
+		std::shared_ptr<State> m_State;
 	};
+
+	namespace detail {
+		template<typename T>
+		std::shared_ptr<FutureState<T>> StateOf(const Future<T>& f) {
+			if (f.GetState())
+				return f.GetState();
+			// Default futures are complete
+			auto s = std::make_shared<FutureState<T>>();
+			s->SetReady();
+			return s;
+		}
+	}
+
+	template<typename T>
+	template<typename F>
+	auto Future<T>::Then(F&& fn) const {
+		using R = typename detail::ThenResult<T, std::decay_t<F>>::type;
+		using Unwrap = detail::UnwrapFuture<R>;
+		using U = typename Unwrap::type;
+
+		std::shared_ptr<State> src = detail::StateOf(*this);
+		auto next = std::make_shared<detail::FutureState<U>>();
+		next->instance = src->instance;
+		next->SetDeps({ src });
+
+		src->OnReady([src, next, fn = std::forward<F>(fn)]() mutable {
+			auto call = [&]() -> decltype(auto) {
+				if constexpr (std::is_void_v<T>)
+					return fn();
+				else
+					return fn(static_cast<const T&>(src->value));
+			};
+
+			if constexpr (Unwrap::isFuture) {
+				auto inner = detail::StateOf(call());
+				next->SetDeps({ inner });
+				inner->OnReady([inner, next] {
+					if constexpr (std::is_void_v<U>)
+						next->SetReady();
+					else
+						next->SetValue(inner->value);
+				});
+			}
+			else if constexpr (std::is_void_v<R>) {
+				call();
+				next->SetReady();
+			}
+			else {
+				next->SetValue(call());
+			}
+		});
+		return Future<U>(next);
+	}
+
+	// Completes once every future has; carries their values in order for non-void T.
+	template<typename T>
+	auto WhenAll(const std::vector<Future<T>>& futures) {
+		using R = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+		auto next = std::make_shared<detail::FutureState<R>>();
+
+		std::vector<std::shared_ptr<detail::FutureStateBase>> deps;
+		std::vector<std::shared_ptr<detail::FutureState<T>>> states;
+		for (const auto& f : futures) {
+			states.push_back(detail::StateOf(f));
+			deps.push_back(states.back());
+			if (!next->instance)
+				next->instance = states.back()->instance;
+		}
+		next->SetDeps(deps);
+
+		auto remaining = std::make_shared<std::atomic<size_t>>(states.size() + 1);
+		auto finish = [next, states, remaining] {
+			if (remaining->fetch_sub(1) != 1)
+				return;
+			if constexpr (std::is_void_v<T>) {
+				next->SetReady();
+			}
+			else {
+				std::vector<T> values;
+				values.reserve(states.size());
+				for (const auto& s : states)
+					values.push_back(s->value);
+				next->SetValue(std::move(values));
+			}
+		};
+		for (const auto& s : states)
+			s->OnReady(finish);
+		finish();   // the extra count keeps an empty or already-complete set from finishing early
+		return Future<R>(next);
+	}
+
+	// Completes with the index of the first future to complete.
+	template<typename T>
+	Future<size_t> WhenAny(const std::vector<Future<T>>& futures) {
+		auto next = std::make_shared<detail::FutureState<size_t>>();
+		if (futures.empty()) {
+			next->SetReady();
+			return Future<size_t>(next);
+		}
+
+		std::vector<std::shared_ptr<detail::FutureStateBase>> deps;
+		for (const auto& f : futures) {
+			deps.push_back(detail::StateOf(f));
+			if (!next->instance)
+				next->instance = deps.back()->instance;
+		}
+		next->SetDeps(deps);
+
+		auto claimed = std::make_shared<std::atomic<bool>>(false);
+		for (size_t i = 0; i < deps.size(); ++i) {
+			deps[i]->OnReady([next, claimed, i] {
+				if (!claimed->exchange(true))
+					next->SetValue(i);
+			});
+		}
+		return Future<size_t>(next);
+	}
+
+#if defined(__cpp_impl_coroutine)
+	// co_await a Future inside a coroutine; the coroutine resumes on the thread that
+	// completes the future.
+	template<typename T>
+	struct Future<T>::Awaiter {
+		std::shared_ptr<State> state;
+
+		bool await_ready() const { return state->IsReady(); }
+		bool await_suspend(std::coroutine_handle<> h) const {
+			return state->AddContinuation([h] { h.resume(); });
+		}
+		decltype(auto) await_resume() const {
+			if constexpr (!std::is_void_v<T>)
+				return static_cast<const T&>(state->value);
+		}
+	};
+
+	template<typename T>
+	typename Future<T>::Awaiter Future<T>::operator co_await() const {
+		return Awaiter{ detail::StateOf(*this) };
+	}
+
+	namespace detail {
+		template<typename T>
+		struct FuturePromiseBase {
+			std::shared_ptr<FutureState<T>> state = std::make_shared<FutureState<T>>();
+
+			Future<T> get_return_object() { return Future<T>(state); }
+
+			// Record what the coroutine is suspended on, so a blocking wait on its future
+			// knows which native futures to drive
+			template<typename U>
+			typename Future<U>::Awaiter await_transform(const Future<U>& f) {
+				auto s = StateOf(f);
+				// Lets Get() on the coroutine's future drive the instance of what it awaits
+				if (!state->instance)
+					state->instance = s->instance;
+				state->SetDeps({ s });
+				return typename Future<U>::Awaiter{ s };
+			}
+			template<typename A>
+			A&& await_transform(A&& awaitable) { return std::forward<A>(awaitable); }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		template<typename T>
+		struct FuturePromise : FuturePromiseBase<T> {
+			void return_value(T v) { this->state->SetValue(std::move(v)); }
+		};
+
+		template<>
+		struct FuturePromise<void> : FuturePromiseBase<void> {
+			void return_void() { this->state->SetReady(); }
+		};
+	}
+
+	// Lets a coroutine return krnl::Future<T>
+	template<typename T>
+	struct Future<T>::promise_type : detail::FuturePromise<T> {};
+#endif
+
 } // namespace krnl
@@ -0,0 +1,126 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace krnl {
+
+    class Device;
+    class Buffer;
+    class Pipeline;
+
+    /**
+     * A DAG of dispatches and buffer copies, ordered by the buffers each node reads and
+     * writes. Edges come from hazards in insertion order: read-after-write,
+     * write-after-write and write-after-read on overlapping buffer ranges, so nodes that
+     * touch unrelated data are independent. Sub-allocated views of one heap buffer only
+     * conflict where their ranges overlap.
+     *
+     * Execute() orders the nodes topologically and prefers whichever kind of node the
+     * encoder is already in. Dispatches therefore share one compute pass until a copy
+     * actually has to run (WebGPU synchronizes dispatches inside a pass). Work is split into
+     * command buffers of at most nodesPerCommandBuffer nodes, each handed to the device's
+     * SubmitQueue as soon as it is recorded so the GPU can start on the front of the graph
+     * while the rest is encoded.
+     *
+     * Before encoding, the executor drops work that cannot matter: if outputs were declared,
+     * it skips nodes that do not feed one of them, and it skips a copy that repeats an
+     * earlier copy when neither range was written in between.
+     *
+     * Buffers and pipelines are referenced, not owned, and must outlive the graph.
+     */
+    class ComputeGraph {
+    public:
+        using NodeId = uint32_t;
+
+        struct Options {
+            // Upper bound on nodes per command buffer; 0 records the whole graph into one
+            uint32_t nodesPerCommandBuffer = 64;
+            // Flush the submit queue after each command buffer instead of leaving it to batch
+            bool submitEarly = true;
+        };
+
+        struct Stats {
+            uint32_t nodes = 0;
+            uint32_t executed = 0;
+            uint32_t culledNodes = 0;       // not contributing to a declared output
+            uint32_t redundantCopies = 0;
+            uint32_t edges = 0;
+            uint32_t computePasses = 0;
+            uint32_t commandBuffers = 0;
+        };
+
+        explicit ComputeGraph(const Device& device);
+        ComputeGraph(const Device& device, const Options& options);
+
+        ComputeGraph(const ComputeGraph&) = delete;
+        ComputeGraph& operator=(const ComputeGraph&) = delete;
+
+        // Reads and writes are the buffers the kernel accesses; a buffer may appear in both.
+        NodeId AddDispatch(const Pipeline& pipeline, uint32_t x, uint32_t y, uint32_t z,
+            const std::vector<const Buffer*>& reads, const std::vector<const Buffer*>& writes);
+        // Accesses taken from the pipeline's ParameterSet: Storage bindings count as read and
+        // written, ReadOnlyStorage and Uniform as read
+        NodeId AddDispatch(const Pipeline& pipeline, uint32_t x, uint32_t y = 1, uint32_t z = 1);
+
+        NodeId AddCopy(const Buffer& src, const Buffer& dst, size_t size);
+        NodeId AddCopy(const Buffer& src, size_t srcOffset, const Buffer& dst, size_t dstOffset, size_t size);
+
+        // Extra ordering the buffers do not express
+        void AddDependency(NodeId before, NodeId after);
+
+        // Mark a buffer whose final contents are wanted. Once any output is declared, nodes
+        // that do not lead to one are skipped.
+        void MarkOutput(const Buffer& buffer);
+
+        // Encode and submit the graph. It can be executed again; the schedule is only rebuilt
+        // after the graph changes.
+        Stats Execute();
+
+        // Execution order of the last schedule (culled and redundant nodes omitted)
+        const std::vector<NodeId>& GetOrder() const { return m_Order; }
+        size_t GetNodeCount() const { return m_Nodes.size(); }
+
+        void Clear();
+
+    private:
+        struct Range {
+            wgpu::Buffer buffer;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+
+            bool Overlaps(const Range& o) const;
+            bool operator==(const Range& o) const;
+        };
+
+        enum class Kind { Dispatch, Copy };
+
+        struct Node {
+            Kind kind = Kind::Dispatch;
+            const Pipeline* pipeline = nullptr;
+            uint32_t groups[3] = { 1, 1, 1 };
+            std::vector<Range> reads;
+            std::vector<Range> writes;
+            std::vector<NodeId> successors;
+            std::vector<NodeId> predecessors;
+            std::vector<NodeId> explicitPredecessors;   // from AddDependency
+        };
+
+        static Range rangeOf(const Buffer& buffer, size_t offset, size_t size);
+        NodeId addNode(Node node);
+        void addEdge(NodeId before, NodeId after);
+        void schedule();
+
+        const Device& m_Device;
+        Options m_Options;
+
+        std::vector<Node> m_Nodes;
+        std::vector<Range> m_Outputs;
+
+        bool m_Dirty = true;
+        std::vector<NodeId> m_Order;
+        Stats m_Scheduled;
+    };
+
+} // namespace krnl
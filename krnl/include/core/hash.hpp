@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace krnl {
+
+    // 64-bit FNV-1a. Stable across runs and platforms, so it is safe to use for cache keys.
+    constexpr uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+    inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = kHashSeed) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        uint64_t h = seed;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= bytes[i];
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    inline uint64_t HashString(std::string_view s, uint64_t seed = kHashSeed) {
+        return HashBytes(s.data(), s.size(), seed);
+    }
+
+    inline uint64_t HashCombine(uint64_t seed, uint64_t value) {
+        return HashBytes(&value, sizeof(value), seed);
+    }
+
+} // namespace krnl
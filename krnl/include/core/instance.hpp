@@ -1,26 +1,81 @@
 #pragma once
 #include <webgpu/webgpu_cpp.h>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 #include "core/future.hpp"
 
 namespace krnl
 {
 	struct InstanceImpl;
 
+	// Runs a completion task; lets callers move OnCompleted work onto their own thread pool
+	using Executor = std::function<void(std::function<void()> task)>;
+
+	struct InstanceOptions
+	{
+		// Background thread that drives WaitAny/ProcessEvents so callbacks fire without the
+		// caller polling, and Wait() sleeps on a condition variable
+		bool eventPump = false;
+		// How often the idle pump calls ProcessEvents for untracked work; 0 = only when woken
+		uint32_t pollIntervalMs = 10;
+		// Longest single WaitAny of the pump; bounds how late a newly tracked future is picked up
+		uint32_t waitSliceMs = 2;
+		// Runs completion tasks (OnCompleted, and Future readiness); empty runs them inline on
+		// the thread that saw the completion
+		Executor executor;
+	};
+
 	class Instance
 	{
 	public:
-		Instance();
+		explicit Instance(const InstanceOptions& options = {});
 		~Instance();
 
-		void ProcessEvents() const { m_Instance.ProcessEvents(); }
-		inline void WaitAny(const krnl::Future& future, uint64_t timeoutMs) const
+		// Also completes tracked futures that have finished
+		void ProcessEvents() const;
+
+		template<typename T>
+		void WaitAny(const Future<T>& future, uint64_t timeoutMs) const { Wait(future, timeoutMs); }
+		void WaitAny(const wgpu::Future& future, uint64_t timeoutMs) const { Wait(future, timeoutMs); }
+		// Block until every future has completed or timeoutMs elapses
+		void WaitAll(const std::vector<Future<>>& futures, uint64_t timeoutMs) const { Wait(WhenAll(futures), timeoutMs); }
+
+		// Block until the future completes or timeoutMs elapses; true if it completed. With the
+		// event pump the caller sleeps on a condition variable while the pump waits on the GPU.
+		template<typename T>
+		bool Wait(const Future<T>& future, uint64_t timeoutMs = UINT64_MAX) const
+		{
+			if (future.IsReady())
+				return true;
+			return detail::WaitState(*this, future.GetState(), timeoutMs);
+		}
+		bool Wait(const wgpu::Future& future, uint64_t timeoutMs = UINT64_MAX) const
+		{
+			return Wait(Future<>(*this, future), timeoutMs);
+		}
+
+		// Run task on the executor once future has completed: from the pump thread, or from
+		// ProcessEvents/Wait when there is no pump
+		template<typename T>
+		void OnCompleted(const Future<T>& future, std::function<void()> task) const
 		{
-			m_Instance.WaitAny(future.GetNative(), timeoutMs);
+			auto state = detail::StateOf(future);
+			if (state->native.id != 0)
+				detail::RegisterNative(*this, state);
+			state->OnReady([this, task = std::move(task)]() mutable { post(std::move(task)); });
 		}
 
+		bool HasEventPump() const;
+
 		const wgpu::Instance& GetNative() const { return m_Instance; }
 	private:
+		friend void detail::RegisterNative(const Instance&, const std::shared_ptr<detail::FutureStateBase>&);
+		friend bool detail::WaitState(const Instance&, const std::shared_ptr<detail::FutureStateBase>&, uint64_t);
+
+		void post(std::function<void()> task) const;
+
 		std::unique_ptr <InstanceImpl> m_Impl;
 		wgpu::Instance m_Instance;
 	};
@@ -1,7 +1,13 @@
 #pragma once
 
-#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 #include <dawn/webgpu_cpp_print.h>
 
@@ -12,6 +18,16 @@
 #define KRNL_DEBUG 0
 #endif
 
+// Lowest level compiled in: 0 = everything, 1 = warnings and errors, 2 = errors only, 3 = nothing.
+// Release builds keep errors.
+#ifndef KRNL_LOG_LEVEL
+#if KRNL_DEBUG
+#define KRNL_LOG_LEVEL 0
+#else
+#define KRNL_LOG_LEVEL 2
+#endif
+#endif
+
 // Platform-specific color support
 #if defined(__EMSCRIPTEN__)
 #define KRNL_COLOR_RESET   ""
@@ -27,36 +43,161 @@
 #define KRNL_COLOR_RED     "\033[31m"
 #endif
 
-#if KRNL_DEBUG
+/**
+ * Asynchronous logging. A KRNL_* statement packs its arguments into a fixed-size record
+ * on the calling thread: numbers are stored in binary and strings are copied, with no
+ * allocation. It then pushes the record into a lock-free ring. A background thread
+ * formats the records and writes them out in batches. Types with only an operator<<
+ * (wgpu enums, ...) are formatted on the caller.
+ *
+ * If the ring is full, warnings and debug messages are dropped and counted, while
+ * errors are written synchronously. Everything still in the ring is written at exit,
+ * and Flush() waits for it explicitly.
+ */
+namespace krnl::log {
 
-#define KRNL_LOG(msg) \
-        do { \
-            std::cout << KRNL_COLOR_GREEN \
-                      << "[KRNL] " << __FILE__ << ":" << __LINE__ << ": " \
-                      << msg \
-                      << KRNL_COLOR_RESET << std::endl; \
-        } while (0)
+    enum class Level : uint8_t { Debug = 0, Warn = 1, Error = 2, Off = 3 };
 
-#define KRNL_WARN(msg) \
-        do { \
-            std::cout << KRNL_COLOR_YELLOW \
-                      << "[KRNL-WARN] " << __FILE__ << ":" << __LINE__ << ": " \
-                      << msg \
-                      << KRNL_COLOR_RESET << std::endl; \
-        } while (0)
+    // Runtime threshold on top of KRNL_LOG_LEVEL (default Debug: everything compiled in)
+    void SetLevel(Level level);
+    Level GetLevel();
+    // Destination for every level; nullptr restores stdout (debug) / stderr (warnings, errors)
+    void SetOutput(FILE* file);
+    // Block until everything logged so far has been written
+    void Flush();
+    // Messages lost to a full ring
+    uint64_t DroppedCount();
+
+    namespace detail {
+
+        extern std::atomic<uint8_t> g_Level;
+
+        inline bool Enabled(Level level) {
+            return static_cast<uint8_t>(level) >= g_Level.load(std::memory_order_relaxed);
+        }
+
+        enum class Arg : uint8_t { Str, I64, U64, F64, Char, Bool, Ptr };
+
+        constexpr size_t kPayloadBytes = 224;
+
+        struct Record {
+            const char* file = nullptr;
+            int line = 0;
+            Level level = Level::Debug;
+            bool truncated = false;
+            uint16_t size = 0;
+            unsigned char payload[kPayloadBytes];
+        };
 
-#define KRNL_ERROR(msg) \
+        void Submit(const Record& record);
+
+        // One log statement; submits on destruction
+        class Line {
+        public:
+            Line(Level level, const char* file, int line) {
+                m_Record.level = level;
+                m_Record.file = file;
+                m_Record.line = line;
+            }
+            ~Line() { Submit(m_Record); }
+
+            Line(const Line&) = delete;
+            Line& operator=(const Line&) = delete;
+
+            template<typename T>
+            Line& operator<<(const T& value) {
+                if constexpr (std::is_same_v<T, bool>) {
+                    put(Arg::Bool, &value, 1);
+                }
+                else if constexpr (std::is_same_v<T, char>) {
+                    put(Arg::Char, &value, 1);
+                }
+                else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                    int64_t v = value;
+                    put(Arg::I64, &v, sizeof(v));
+                }
+                else if constexpr (std::is_integral_v<T>) {
+                    uint64_t v = value;
+                    put(Arg::U64, &v, sizeof(v));
+                }
+                else if constexpr (std::is_floating_point_v<T>) {
+                    double v = value;
+                    put(Arg::F64, &v, sizeof(v));
+                }
+                else if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+                    putString(value ? std::string_view(value) : std::string_view("(null)"));
+                }
+                else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+                    putString(std::string_view(value));
+                }
+                else if constexpr (std::is_pointer_v<T>) {
+                    uint64_t v = reinterpret_cast<uintptr_t>(value);
+                    put(Arg::Ptr, &v, sizeof(v));
+                }
+                else {
+                    std::ostringstream os;
+                    os << value;
+                    putString(os.str());
+                }
+                return *this;
+            }
+
+        private:
+            void put(Arg tag, const void* data, size_t bytes) {
+                if (m_Record.size + 1 + bytes > kPayloadBytes) {
+                    m_Record.truncated = true;
+                    return;
+                }
+                m_Record.payload[m_Record.size++] = static_cast<unsigned char>(tag);
+                std::memcpy(m_Record.payload + m_Record.size, data, bytes);
+                m_Record.size += static_cast<uint16_t>(bytes);
+            }
+
+            void putString(std::string_view s) {
+                const size_t header = 1 + sizeof(uint16_t);
+                if (m_Record.size + header >= kPayloadBytes) {
+                    m_Record.truncated = true;
+                    return;
+                }
+                size_t room = kPayloadBytes - m_Record.size - header;
+                uint16_t n = static_cast<uint16_t>(s.size() < room ? s.size() : room);
+                if (n < s.size()) {
+                    m_Record.truncated = true;
+                }
+                m_Record.payload[m_Record.size++] = static_cast<unsigned char>(Arg::Str);
+                std::memcpy(m_Record.payload + m_Record.size, &n, sizeof(n));
+                m_Record.size += sizeof(n);
+                std::memcpy(m_Record.payload + m_Record.size, s.data(), n);
+                m_Record.size += n;
+            }
+
+            Record m_Record;
+        };
+
+    } // namespace detail
+} // namespace krnl::log
+
+#define KRNL_LOG_AT(level, msg) \
         do { \
-            std::cout << KRNL_COLOR_RED \
-                      << "[KRNL-ERROR] " << __FILE__ << ":" << __LINE__ << ": " \
-                      << msg \
-                      << KRNL_COLOR_RESET << std::endl; \
+            if (::krnl::log::detail::Enabled(level)) { \
+                ::krnl::log::detail::Line(level, __FILE__, __LINE__) << msg; \
+            } \
         } while (0)
 
+#if KRNL_LOG_LEVEL <= 0
+#define KRNL_LOG(msg)   KRNL_LOG_AT(::krnl::log::Level::Debug, msg)
 #else
-
 #define KRNL_LOG(msg)   do {} while (0)
+#endif
+
+#if KRNL_LOG_LEVEL <= 1
+#define KRNL_WARN(msg)  KRNL_LOG_AT(::krnl::log::Level::Warn, msg)
+#else
 #define KRNL_WARN(msg)  do {} while (0)
-#define KRNL_ERROR(msg) do {} while (0)
+#endif
 
+#if KRNL_LOG_LEVEL <= 2
+#define KRNL_ERROR(msg) KRNL_LOG_AT(::krnl::log::Level::Error, msg)
+#else
+#define KRNL_ERROR(msg) do {} while (0)
 #endif
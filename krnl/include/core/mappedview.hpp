@@ -0,0 +1,69 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace krnl {
+
+    /**
+     * Window onto a mapped range of a buffer. Reads (and writes, for ranges mapped with
+     * MapMode::Write) go straight to the mapping without an intermediate copy. The buffer
+     * is unmapped when the view is destroyed or Unmap() is called; spans taken from the
+     * view must not outlive it. Move-only.
+     */
+    class MappedView {
+    public:
+        MappedView() = default;
+        MappedView(wgpu::Buffer buffer, void* data, size_t size, bool writable);
+        ~MappedView();
+
+        MappedView(MappedView&& other) noexcept;
+        MappedView& operator=(MappedView&& other) noexcept;
+
+        MappedView(const MappedView&) = delete;
+        MappedView& operator=(const MappedView&) = delete;
+
+        bool IsValid() const { return m_Data != nullptr; }
+        bool IsWritable() const { return m_Writable; }
+        size_t GetSize() const { return m_Size; }
+
+        std::span<const std::byte> Bytes() const {
+            return { static_cast<const std::byte*>(m_Data), m_Size };
+        }
+
+        // Empty unless the range was mapped for writing
+        std::span<std::byte> MutableBytes() const {
+            if (!m_Writable) return {};
+            return { static_cast<std::byte*>(m_Data), m_Size };
+        }
+
+        // Typed views; a trailing partial element is not included.
+        template<typename T>
+        std::span<const T> As() const {
+            static_assert(std::is_trivially_copyable_v<T>, "MappedView::As requires a trivially copyable type");
+            assert(reinterpret_cast<uintptr_t>(m_Data) % alignof(T) == 0);
+            return { static_cast<const T*>(m_Data), m_Size / sizeof(T) };
+        }
+
+        template<typename T>
+        std::span<T> AsMutable() const {
+            static_assert(std::is_trivially_copyable_v<T>, "MappedView::AsMutable requires a trivially copyable type");
+            if (!m_Writable) return {};
+            assert(reinterpret_cast<uintptr_t>(m_Data) % alignof(T) == 0);
+            return { static_cast<T*>(m_Data), m_Size / sizeof(T) };
+        }
+
+        // Unmap now instead of at destruction. The view is empty afterwards.
+        void Unmap();
+
+    private:
+        wgpu::Buffer m_Buffer;
+        void* m_Data = nullptr;
+        size_t m_Size = 0;
+        bool m_Writable = false;
+    };
+
+} // namespace krnl
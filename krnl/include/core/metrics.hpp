@@ -0,0 +1,181 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace krnl {
+
+    /**
+     * Per-device runtime counters (Device::GetMetrics), always on and cheap enough to leave
+     * that way. It tracks:
+     * - live krnl::Buffers, by label
+     * - GPU memory held by krnl: dedicated buffers, allocator heaps and staging, with its
+     *   high-water mark
+     * - time from MapAsync to its callback (Buffer::MapAsync, ReadAsync, ReadbackBatch)
+     *
+     * Device::GetMetricsSnapshot() adds the stats of the pipeline cache, staging pool,
+     * allocator and submit queue to these, for exporters to scrape. Tokens handed out below
+     * keep the registry alive, so allocations may outlive the device.
+     */
+    class Metrics : public std::enable_shared_from_this<Metrics> {
+    public:
+        // Upper bucket bounds in microseconds; one more bucket catches everything above
+        static constexpr std::array<uint64_t, 14> kMapWaitBoundsUs = {
+            10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 1000000
+        };
+
+        struct Histogram {
+            std::vector<uint64_t> boundsUs;     // upper bound of each bucket but the last
+            std::vector<uint64_t> counts;       // boundsUs.size() + 1 buckets, not cumulative
+            uint64_t count = 0;
+            uint64_t sumUs = 0;
+            uint64_t maxUs = 0;
+
+            double MeanUs() const { return count ? static_cast<double>(sumUs) / static_cast<double>(count) : 0.0; }
+            // Upper bound of the bucket holding the p-th fraction (0..1); maxUs for the last bucket
+            uint64_t PercentileUs(double p) const;
+        };
+
+        struct LabelStats {
+            std::string label;
+            uint64_t count = 0;
+            uint64_t bytes = 0;
+        };
+
+        struct Snapshot {
+            double uptimeSeconds = 0.0;
+
+            // krnl::Buffer objects (copies count once), including sub-allocated views
+            uint64_t liveBuffers = 0;
+            uint64_t liveBufferBytes = 0;
+            std::vector<LabelStats> buffersByLabel;     // largest first
+
+            // GPU memory held by krnl buffers, allocator heaps and staging
+            uint64_t gpuMemoryBytes = 0;
+            uint64_t gpuMemoryHighWater = 0;
+
+            // Allocator
+            uint64_t allocatorReservedBytes = 0;
+            uint64_t allocatorUsedBytes = 0;
+            uint64_t allocatorLiveAllocations = 0;
+
+            // Staging pool: ready = mapped and free, in flight = submitted, waiting for the remap
+            size_t stagingReadyChunks = 0;
+            size_t stagingInflightChunks = 0;
+            uint64_t stagingReadyBytes = 0;
+            uint64_t stagingInflightBytes = 0;
+            uint64_t stagingUploads = 0;
+            uint64_t stagingUploadBytes = 0;
+            uint64_t stagingReadbacks = 0;
+            double stagingChunkHitRate = 0.0;           // chunk requests served by a recycled chunk
+            double stagingReadbackHitRate = 0.0;        // readback buffers reused from the pool
+
+            // Pipeline cache
+            uint64_t pipelineCacheHits = 0;
+            uint64_t pipelineCacheMisses = 0;
+            size_t pipelineCacheEntries = 0;
+            double pipelineCacheHitRate = 0.0;
+
+            // Submission
+            uint64_t commandBuffersSubmitted = 0;
+            uint64_t queueSubmits = 0;
+            double submitsPerSecond = 0.0;              // Queue::Submit calls since the previous snapshot
+
+            Histogram mapWait;
+        };
+
+        // Counts 'bytes' as live GPU memory until destroyed
+        class GpuMemory {
+        public:
+            GpuMemory() = default;
+            GpuMemory(std::shared_ptr<Metrics> metrics, uint64_t bytes);
+            ~GpuMemory();
+
+            GpuMemory(GpuMemory&& other) noexcept;
+            GpuMemory& operator=(GpuMemory&& other) noexcept;
+            GpuMemory(const GpuMemory&) = delete;
+            GpuMemory& operator=(const GpuMemory&) = delete;
+
+        private:
+            void reset();
+
+            std::shared_ptr<Metrics> m_Metrics;
+            uint64_t m_Bytes = 0;
+        };
+
+        // One live krnl::Buffer, shared by its copies
+        class LiveBuffer {
+        public:
+            LiveBuffer(std::shared_ptr<Metrics> metrics, const std::string& label, uint64_t bytes, bool ownsMemory);
+            ~LiveBuffer();
+
+            LiveBuffer(const LiveBuffer&) = delete;
+            LiveBuffer& operator=(const LiveBuffer&) = delete;
+
+        private:
+            std::shared_ptr<Metrics> m_Metrics;
+            LabelStats* m_Entry;
+            uint64_t m_Bytes;
+            GpuMemory m_Memory;
+        };
+
+        // Times one map; copyable so it can ride along in a map callback
+        class MapTimer {
+        public:
+            explicit MapTimer(std::shared_ptr<Metrics> metrics)
+                : m_Metrics(std::move(metrics)), m_Start(std::chrono::steady_clock::now()) {}
+            void Stop() const;
+
+        private:
+            std::shared_ptr<Metrics> m_Metrics;
+            std::chrono::steady_clock::time_point m_Start;
+        };
+
+        // Use std::make_shared: tokens hold a reference to the registry
+        Metrics();
+
+        Metrics(const Metrics&) = delete;
+        Metrics& operator=(const Metrics&) = delete;
+
+        GpuMemory TrackGpuMemory(uint64_t bytes);
+        // ownsMemory: the buffer has its own wgpu::Buffer (not an allocator view)
+        std::shared_ptr<LiveBuffer> TrackBuffer(const std::string& label, uint64_t bytes, bool ownsMemory);
+        MapTimer StartMapWait() { return MapTimer(shared_from_this()); }
+        void RecordMapWait(uint64_t us);
+
+        // Fill the registry's own part of a snapshot; queueSubmits (the submit queue's running
+        // count) gives submitsPerSecond. Device::GetMetricsSnapshot adds the rest.
+        Snapshot Collect(uint64_t queueSubmits);
+
+        void ResetMapWait();
+
+    private:
+        std::chrono::steady_clock::time_point m_Created;
+
+        std::atomic<uint64_t> m_GpuBytes{ 0 };
+        std::atomic<uint64_t> m_GpuHighWater{ 0 };
+
+        std::atomic<uint64_t> m_MapWaitCounts[kMapWaitBoundsUs.size() + 1] = {};
+        std::atomic<uint64_t> m_MapWaitCount{ 0 };
+        std::atomic<uint64_t> m_MapWaitSumUs{ 0 };
+        std::atomic<uint64_t> m_MapWaitMaxUs{ 0 };
+
+        std::mutex m_Mutex;
+        // Entries are erased when their last buffer goes; node addresses are stable
+        std::unordered_map<std::string, LabelStats> m_Buffers;
+        uint64_t m_LiveBuffers = 0;
+        uint64_t m_LiveBufferBytes = 0;
+
+        // Previous Collect, for submitsPerSecond
+        std::chrono::steady_clock::time_point m_LastCollect;
+        uint64_t m_LastSubmits = 0;
+    };
+
+} // namespace krnl
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <webgpu/webgpu_cpp.h>
 #include "core/buffer.hpp"
 #include "core/device.hpp"
@@ -14,6 +15,7 @@ namespace krnl {
         Uniform = wgpu::BufferBindingType::Uniform,
 	};
 
+    // Thread-safe: update() may run while other threads encode dispatches with the set.
     class ParameterSet {
     public:
         struct Entry {
@@ -22,23 +24,37 @@ namespace krnl {
         };
 
         ParameterSet() = delete;
+        // The entry list is copied; the buffers must outlive the set
         ParameterSet(const Device& device, const std::vector<Entry>& entries);
 
+        ParameterSet(const ParameterSet&) = delete;
+        ParameterSet& operator=(const ParameterSet&) = delete;
+
+        // Layout for the given binding types (binding i = bindings[i]), usable without any buffers
+        static wgpu::BindGroupLayout CreateLayout(const Device& device, const std::vector<BufferBindingType>& bindings);
+        static uint64_t LayoutHash(const std::vector<BufferBindingType>& bindings);
+
         // Rebuild bind group if buffers/entries changed
         void update();
 
-        const wgpu::BindGroup& bindGroup() const { return m_BindGroup; }
+        // By value: a concurrent update() may replace the group
+        wgpu::BindGroup bindGroup() const;
+        const std::vector<Entry>& entries() const { return m_Entries; }
         const wgpu::BindGroupLayout& layout() const { return m_BindGroupLayout; }
+        // Signature of the layout (binding types in order); equal hashes mean interchangeable layouts
+        uint64_t layoutHash() const { return m_LayoutHash; }
 
     private:
         void buildLayout();
         void buildBindGroup();
 
         const Device& m_Device;
-        const std::vector<Entry>& m_Entries;
+        const std::vector<Entry> m_Entries;
 
         wgpu::BindGroupLayout m_BindGroupLayout;
+        mutable std::mutex m_Mutex;
         wgpu::BindGroup m_BindGroup;
+        uint64_t m_LayoutHash = 0;
     };
 
 } // namespace krnl
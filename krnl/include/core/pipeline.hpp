@@ -2,6 +2,8 @@
 #include <webgpu/webgpu_cpp.h>
 #include <string>
 #include <memory>
+#include <vector>
+#include <functional>
 #include "core/parameterset.hpp" 
 #include "core/buffer.hpp"   
 #include "core/device.hpp"
@@ -10,22 +12,55 @@
 
 namespace krnl {
 
+    // One kernel to precompile: the binding types describe the ParameterSet it will be used with.
+    struct PipelineWarmupEntry {
+        Shader shader;
+        std::vector<BufferBindingType> bindings;
+        std::string entryPoint = "main";
+        std::string label;
+        PipelineConstants constants;
+    };
+
     class Pipeline {
     public:
+        // constants specialize the shader's `override` declarations at compile time (workgroup
+        // size, tile dims, unroll factors, fixed problem sizes), so the compiler can fold them;
+        // each distinct set is its own cached pipeline.
         static Pipeline CreateCompute(
             const Device& device,
             const Shader& module,
             const ParameterSet& params,
             const std::string& entryPoint = "main",
-            const char* label = nullptr
+            const char* label = nullptr,
+            const PipelineConstants& constants = {}
         );
 
+        // Compile on Dawn's worker threads. onReady receives the pipeline once compiled (on an
+        // arbitrary thread); device and params must stay alive until then.
+        static Future<> CreateComputeAsync(
+            const Device& device,
+            const Shader& module,
+            const ParameterSet& params,
+            std::function<void(Pipeline)> onReady,
+            const std::string& entryPoint = "main",
+            const char* label = nullptr,
+            const PipelineConstants& constants = {}
+        );
+
+        // Start compiling every manifest entry concurrently into the device pipeline cache and
+        // return immediately; once the futures complete, CreateCompute for those kernels is a cache hit.
+        static std::vector<Future<>> WarmUp(const Device& device, const std::vector<PipelineWarmupEntry>& manifest);
+
         ~Pipeline() = default;
 
-        void encodeDispatch(const CommandList& cmd, uint32_t x, uint32_t y = 1, uint32_t z = 1);
+        // Safe to call for different CommandLists from several threads at once
+        void encodeDispatch(const CommandList& cmd, uint32_t x, uint32_t y = 1, uint32_t z = 1) const;
 
         const wgpu::ComputePipeline& getNative() const { return m_Pipeline; }
         const wgpu::PipelineLayout& getLayout() const { return m_PipelineLayout; }
+        const ParameterSet& getParams() const { return m_Params; }
+        // Label given at creation (entry point if none); names the kernel in profiles
+        const std::string& getLabel() const { return m_Label; }
 
     private:
         Pipeline() = default;
@@ -34,7 +69,8 @@ namespace krnl {
         {
 		}
 
-        void buildPipeline(const wgpu::ShaderModule& module, const std::string& entryPoint, const char* label);
+        void buildPipeline(const Shader& module, const std::string& entryPoint, const char* label, const PipelineConstants& constants);
+        static PipelineKey makeKey(const Shader& module, const std::string& entryPoint, uint64_t layoutHash, const PipelineConstants& constants);
 
     private:
         const Device& m_Device;
@@ -43,5 +79,6 @@ namespace krnl {
         wgpu::PipelineLayout m_PipelineLayout;
         wgpu::ComputePipeline m_Pipeline;
         wgpu::ShaderModule m_ShaderModule;
+        std::string m_Label;
     };
 } // namespace krnl
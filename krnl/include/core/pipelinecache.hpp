@@ -0,0 +1,121 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace krnl {
+
+    // Value for one of the shader's `override` declarations, by name (or by its @id as a
+    // decimal string). WGSL converts the double to the declared type (bool, i32, u32, f32).
+    struct PipelineConstant {
+        std::string name;
+        double value = 0.0;
+
+        bool operator==(const PipelineConstant& other) const = default;
+    };
+
+    using PipelineConstants = std::vector<PipelineConstant>;
+
+    /**
+     * Identity of a compute pipeline: everything that affects the compiled result.
+     * - shaderHash: hash of the WGSL source (see Shader::GetHash)
+     * - layoutHash: signature of the bind group layout (see ParameterSet::layoutHash)
+     * - constants: override values, sorted by name so the order they were given in doesn't matter
+     */
+    struct PipelineKey {
+        uint64_t shaderHash = 0;
+        std::string entryPoint;
+        uint64_t layoutHash = 0;
+        PipelineConstants constants;
+
+        bool operator==(const PipelineKey& other) const = default;
+    };
+
+    struct PipelineKeyHash {
+        size_t operator()(const PipelineKey& key) const;
+    };
+
+    struct CachedPipeline {
+        wgpu::PipelineLayout layout;
+        wgpu::ComputePipeline pipeline;
+    };
+
+    // Per-device cache of compiled compute pipelines, so repeated launches of the
+    // same kernel skip layout and pipeline creation.
+    class PipelineCache {
+    public:
+        struct Stats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            size_t entries = 0;
+
+            double hitRate() const {
+                uint64_t total = hits + misses;
+                return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+            }
+        };
+
+        using ReadyCallback = std::function<void(const CachedPipeline& entry)>;
+
+        explicit PipelineCache(wgpu::Device device);
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        // Return the pipeline for 'key', compiling it from module/bindGroupLayout with
+        // key.constants on a miss.
+        CachedPipeline GetOrCreate(
+            const PipelineKey& key,
+            const wgpu::ShaderModule& module,
+            const wgpu::BindGroupLayout& bindGroupLayout,
+            const char* label = nullptr
+        );
+
+        // Compile on Dawn's worker threads and insert into the cache when done. onReady (optional)
+        // runs on whichever thread completes the compile, or immediately on a cache hit, in which
+        // case the returned future is invalid (already complete).
+        wgpu::Future GetOrCreateAsync(
+            const PipelineKey& key,
+            const wgpu::ShaderModule& module,
+            const wgpu::BindGroupLayout& bindGroupLayout,
+            const char* label = nullptr,
+            ReadyCallback onReady = nullptr
+        );
+
+        bool Contains(const PipelineKey& key) const;
+
+        // Shader module for a source hash, created on first use. Lets kernels generated at
+        // run time (e.g. per dtype) skip WGSL parsing after the first launch.
+        wgpu::ShaderModule GetOrCreateModule(uint64_t shaderHash, const std::function<wgpu::ShaderModule()>& create);
+
+        Stats GetStats() const;
+        void ResetStats();
+        void Clear();
+
+    private:
+        // Shared with in-flight async compiles, which may complete after the cache is gone.
+        struct State {
+            std::mutex mutex;
+            std::unordered_map<PipelineKey, CachedPipeline, PipelineKeyHash> entries;
+            std::unordered_map<uint64_t, wgpu::ShaderModule> modules;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+        };
+
+        // Counts a hit or a miss; returns true and fills 'out' on a hit.
+        bool lookup(const PipelineKey& key, CachedPipeline& out);
+        wgpu::PipelineLayout createLayout(const wgpu::BindGroupLayout& bindGroupLayout) const;
+        // Entries point into key.constants, which must outlive their use
+        static std::vector<wgpu::ConstantEntry> constantEntries(const PipelineKey& key);
+        static CachedPipeline insert(State& state, const PipelineKey& key, const CachedPipeline& entry);
+
+        wgpu::Device m_Device;
+        std::shared_ptr<State> m_State;
+    };
+
+} // namespace krnl
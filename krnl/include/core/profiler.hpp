@@ -0,0 +1,121 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace krnl {
+
+    /**
+     * Opt-in GPU/host profiler (DeviceOptions::enableProfiling), one per device.
+     *
+     * With the TimestampQuery feature, every compute pass recorded through a CommandList
+     * writes begin/end timestamps into a pooled QuerySet. The list resolves them into a
+     * readback buffer at Finish, which is mapped asynchronously once the command buffer is
+     * submitted. The pass time is attributed to the labels of the pipelines dispatched in it
+     * (put one dispatch per pass for per-kernel numbers). Without timestamps, each submitted
+     * list is timed on the host from its Queue::Submit to OnSubmittedWorkDone instead.
+     *
+     * Host spans (command list encode, Queue::Submit, map waits) are recorded alongside, and
+     * everything can be exported as a Chrome / Perfetto trace (chrome://tracing, ui.perfetto.dev).
+     * GPU timestamps are placed on the host clock by anchoring them no earlier than the
+     * submit that produced them, so their durations are exact but their start times only
+     * approximate.
+     */
+    class Profiler {
+    public:
+        struct Options {
+            uint32_t maxPassesPerList = 64;     // passes past this in one CommandList are not timed
+            size_t maxEvents = 1u << 20;        // older events are kept, newer ones dropped
+        };
+
+        enum class Track : uint32_t { Host = 0, Gpu = 1 };
+
+        struct Event {
+            std::string name;
+            std::string category;
+            Track track = Track::Host;
+            uint64_t startNs = 0;               // since the profiler was created
+            uint64_t durationNs = 0;
+        };
+
+        struct KernelStats {
+            std::string name;
+            uint64_t count = 0;
+            uint64_t totalNs = 0;
+            uint64_t minNs = 0;
+            uint64_t maxNs = 0;
+        };
+
+        // Recording state of one CommandList
+        struct ListRecord;
+
+        Profiler(wgpu::Device device, wgpu::Queue queue, bool timestamps);
+        Profiler(wgpu::Device device, wgpu::Queue queue, bool timestamps, const Options& options);
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        // True when passes are timed on the GPU rather than around submits
+        bool HasTimestamps() const { return m_Timestamps; }
+
+        // Nanoseconds since the profiler was created
+        uint64_t Now() const;
+
+        void AddHostSpan(const char* category, std::string name, uint64_t startNs, uint64_t endNs);
+        // Start a span now; calling the returned function ends it. Safe to call after the
+        // profiler is gone (e.g. from a late map callback).
+        std::function<void()> BeginAsyncSpan(const char* category, std::string name);
+
+        // RAII host span
+        class Scope {
+        public:
+            Scope(Profiler* profiler, const char* category, std::string name);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Profiler* m_Profiler;
+            const char* m_Category;
+            std::string m_Name;
+            uint64_t m_Start = 0;
+        };
+
+        // CommandList hooks
+        std::shared_ptr<ListRecord> BeginList();
+        // Fills writes for the next pass; false when the pass is not GPU-timed
+        bool BeginPass(ListRecord& list, wgpu::PassTimestampWrites& writes);
+        void AddDispatch(ListRecord& list, const std::string& label);
+        // At Finish: resolve the list's queries into its readback buffer
+        void ResolveList(ListRecord& list, const wgpu::CommandEncoder& encoder);
+        // After-submit hook for the list's command buffer (see SubmitQueue::Enqueue)
+        std::function<void()> OnSubmitted(std::shared_ptr<ListRecord> list);
+
+        std::vector<Event> GetEvents() const;
+        // GPU events aggregated by name, slowest total first
+        std::vector<KernelStats> GetKernelStats() const;
+
+        std::string ToChromeTrace() const;
+        bool WriteChromeTrace(const std::filesystem::path& path) const;
+
+        void Clear();
+
+    private:
+        struct State;
+
+        wgpu::Device m_Device;
+        wgpu::Queue m_Queue;
+        bool m_Timestamps = false;
+        Options m_Options;
+        std::shared_ptr<State> m_State;
+    };
+
+} // namespace krnl
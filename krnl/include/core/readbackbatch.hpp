@@ -0,0 +1,81 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "core/future.hpp"
+
+namespace krnl {
+
+    class Device;
+    class Buffer;
+
+    /**
+     * Gathers many small reads into one packed MapRead staging buffer: every source is
+     * copied in a single submit and the staging is mapped once, after which the per-source
+     * callbacks run in the order the reads were added. Staging comes from the device's
+     * readback pool. Sizes and source offsets must be multiples of 4.
+     */
+    class ReadbackBatch {
+    public:
+        // data is nullptr (and size 0) when the map failed
+        using ReadCallback = std::function<void(const void* data, size_t size)>;
+
+        // Spans into the mapped staging, one per Read in order. Valid only inside the callback.
+        // Empty (not IsValid, Count 0) when the map failed.
+        class Result {
+        public:
+            bool IsValid() const { return m_Data != nullptr; }
+            size_t Count() const { return m_Ranges.size(); }
+            std::span<const std::byte> Get(size_t index) const {
+                return { m_Data + m_Ranges[index].first, m_Ranges[index].second };
+            }
+            template<typename T>
+            std::span<const T> As(size_t index) const {
+                auto bytes = Get(index);
+                return { reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T) };
+            }
+
+        private:
+            friend class ReadbackBatch;
+            const std::byte* m_Data = nullptr;
+            std::vector<std::pair<size_t, size_t>> m_Ranges;   // (offset, size) in the staging
+        };
+        using CompleteCallback = std::function<void(const Result& result)>;
+
+        explicit ReadbackBatch(const Device& device);
+
+        ReadbackBatch(const ReadbackBatch&) = delete;
+        ReadbackBatch& operator=(const ReadbackBatch&) = delete;
+
+        // Queue a read of [offset, offset + size) of src (relative to the Buffer's own range).
+        // Returns the index of the read in Result.
+        size_t Read(const Buffer& src, size_t offset, size_t size, ReadCallback cb = {});
+        size_t Read(const Buffer& src, ReadCallback cb = {});
+
+        // Copy every queued source, submit once and map once. Callbacks (then onComplete) run
+        // when the returned future completes, with (nullptr, 0) and an empty Result if the map
+        // failed. The batch is empty again afterwards.
+        Future<> Submit(CompleteCallback onComplete = {});
+
+        size_t Count() const { return m_Entries.size(); }
+        size_t GetPackedSize() const { return m_PackedSize; }
+
+    private:
+        struct Entry {
+            wgpu::Buffer src;
+            size_t srcOffset = 0;
+            size_t offset = 0;      // within the packed staging
+            size_t size = 0;
+            ReadCallback cb;
+        };
+
+        const Device& m_Device;
+        std::vector<Entry> m_Entries;
+        size_t m_PackedSize = 0;
+    };
+
+} // namespace krnl
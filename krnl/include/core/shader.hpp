@@ -2,6 +2,7 @@
 #include <webgpu/webgpu_cpp.h>
 #include "core/device.hpp"
 #include <string>
+#include <cstdint>
 #include <filesystem>
 
 namespace krnl
@@ -10,19 +11,28 @@ namespace krnl
 	public:
 
 		Shader() = delete;
-		Shader(wgpu::ShaderModule shaderModule)
-			: m_ShaderModule(shaderModule)
+		// Modules created outside krnl have no source to hash: each wrap gets a fresh id, so a
+		// module allocated at a released one's address never hits its cached pipelines
+		Shader(wgpu::ShaderModule shaderModule);
+		Shader(wgpu::ShaderModule shaderModule, uint64_t hash)
+			: m_ShaderModule(shaderModule), m_Hash(hash)
 		{
 		}
 
 		// Load WGSL source code into a shader module
 		static Shader loadWGSL(const Device& device, const std::string& source);
+		// Same, but the module is kept in the device pipeline cache and reused for identical source
+		static Shader loadCachedWGSL(const Device& device, const std::string& source);
 		// Read WGSL source code from a file and load into a shader module
 		static Shader readWGSL(const Device& device, std::filesystem::path path);
 
 		const wgpu::ShaderModule& GetNative() const { return m_ShaderModule; }
+		// Content hash of the WGSL source (a per-process id for wrapped modules), used as the
+		// shader part of pipeline cache keys
+		uint64_t GetHash() const { return m_Hash; }
 
 	private:
 		wgpu::ShaderModule m_ShaderModule;
+		uint64_t m_Hash = 0;
 	};
 } // namespace krnl
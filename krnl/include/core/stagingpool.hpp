@@ -1,46 +1,127 @@
 #pragma once
 #include <webgpu/webgpu_cpp.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <mutex>
 #include <functional>
 #include <cstddef>
 
+#include "core/metrics.hpp"
+
 namespace krnl {
 
+    class SubmitQueue;
+
     /**
-     * A single staging buffer owned by the pool.
-     * - For uploads (MapWrite | CopySrc) we create it with mappedAtCreation = true
-     *   so callers can write to ->mappedPtr immediately.
+     * A large MapWrite | CopySrc buffer of the upload ring. Regions are handed out linearly
+     * while it is mapped; once its copies are submitted it is unmapped, and MapAsync(Write)
+     * brings it back: the map callback is the proof the GPU finished reading it.
+     */
+    struct StagingChunk {
+        enum class State : int { Mapped, InFlight, Remapped, Failed };
+
+        struct Copy {
+            size_t srcOffset = 0;
+            wgpu::Buffer dst;
+            size_t dstOffset = 0;
+            size_t size = 0;
+        };
+
+        wgpu::Buffer buffer;
+        uint8_t* mapped = nullptr;
+        size_t size = 0;
+        size_t head = 0;                // next free byte while mapped
+        uint32_t outstanding = 0;       // regions handed out but not yet enqueued
+        std::vector<Copy> copies;       // enqueued, not yet submitted
+        std::atomic<State> state{ State::Mapped };
+        Metrics::GpuMemory memory;
+    };
+    using StagingChunkPtr = std::shared_ptr<StagingChunk>;
+
+    /**
+     * A single staging region owned by the pool.
+     * - Upload regions (forWrite == true) live inside a ring chunk and are mapped, so callers
+     *   can write to ->mappedPtr immediately.
+     * - Readback buffers (forWrite == false) are standalone MapRead buffers from a power-of-two
+     *   size class (min 256 B); size is the class size, not the requested one.
      */
     struct StagingHandle {
         wgpu::Buffer buffer;
-        void* mappedPtr = nullptr;     // valid only when buffer is mapped (forWrite==true)
+        void* mappedPtr = nullptr;     // valid only while the region is mapped (forWrite==true)
         size_t size = 0;
+        size_t offset = 0;             // byte offset of the region inside buffer
         bool forWrite = true;
         bool inUse = false;
+        StagingChunkPtr chunk;         // upload regions: the chunk they were carved from
+        Metrics::GpuMemory memory;     // readback buffers: their own allocation
     };
     using StagingHandlePtr = std::shared_ptr<StagingHandle>;
 
     class PersistentStagingPool {
     public:
         struct Config {
-            size_t maxPoolSize = 4;
+            size_t maxPoolSize = 4;             // readback buffers kept per size class
+            size_t chunkSize = 4u << 20;        // bytes per upload ring chunk
+            size_t maxChunks = 16;              // recycled chunks kept; extra ones are released after use
+            size_t maxInflightChunks = 16;      // retired chunks not yet remapped; allocate fails past this
             bool threadSafe = true;
             const char* labelPrefix = "krnl_staging";
         };
 
-        PersistentStagingPool(wgpu::Device device, const Config& cfg = {});
+        struct Stats {
+            size_t freeChunks = 0;              // mapped and empty, ready for the next upload
+            size_t activeChunks = 0;            // currently receiving regions / holding unsubmitted copies
+            size_t inflightChunks = 0;          // submitted, waiting for their remap
+            uint64_t freeBytes = 0;
+            uint64_t inflightBytes = 0;
+            uint64_t chunksCreated = 0;
+            uint64_t chunksRecycled = 0;
+            uint64_t uploads = 0;
+            uint64_t uploadBytes = 0;
+            uint64_t flushes = 0;
+            uint64_t allocationsCapped = 0;     // allocate calls refused by maxInflightChunks
+            size_t freeReadbackBuffers = 0;
+            uint64_t readbacks = 0;
+            uint64_t readbackBuffersCreated = 0;
+            uint64_t readbackBuffersReused = 0;
+        };
+
+        explicit PersistentStagingPool(wgpu::Device device);
+        PersistentStagingPool(wgpu::Device device, const Config& cfg);
         ~PersistentStagingPool();
 
-        // Acquire a staging buffer with at least 'size' bytes. The returned handle is mapped and ready to write
-        // if forWrite is true.
+        PersistentStagingPool(const PersistentStagingPool&) = delete;
+        PersistentStagingPool& operator=(const PersistentStagingPool&) = delete;
+
+        // Route command buffers through a device submission queue instead of Queue::Submit.
+        // The queue must outlive the pool.
+        void setSubmitQueue(SubmitQueue* submitQueue) { m_submitQueue = submitQueue; }
+        // Count chunks and readback buffers as GPU memory, and time readback maps
+        void setMetrics(std::shared_ptr<Metrics> metrics) { m_metrics = std::move(metrics); }
+
+        // Carve a mapped upload region of at least 'size' bytes out of the ring. Write to
+        // ->mappedPtr, then hand it back with enqueueUpload or submitUpload. Returns nullptr when
+        // a new chunk is needed and maxInflightChunks are still waiting for their remap; use
+        // writeDirect instead.
         StagingHandlePtr allocate(size_t size);
 
-        // Submit an upload: unmap the staging (if mapped), copy staging -> dstBuffer, submit on queue,
-        // and create a replacement mapped staging buffer for future use if pool isn't saturated.
-        // Returns a replacement staging handle (may be null if none created).
-        StagingHandlePtr submitUpload(
+        // Record a copy region -> dstBuffer; it is submitted by the next flush().
+        // Adjacent copies into the same buffer are merged.
+        void enqueueUpload(StagingHandlePtr staging, wgpu::Buffer dstBuffer, size_t bytes, size_t dstOffset);
+
+        // Same, for a region packed with several uploads. Copy::srcOffset is relative to the
+        // start of the region; sizes and offsets must be multiples of 4.
+        void enqueueUploads(StagingHandlePtr staging, const StagingChunk::Copy* copies, size_t count);
+
+        // Unmap every chunk with enqueued copies and no regions still being written, submit all
+        // of their copies in one command buffer and start remapping the chunks for reuse.
+        void flush(wgpu::Queue queue);
+
+        // enqueueUpload, then submit the chunks that filled up. The region's own chunk stays open
+        // for later uploads until the next flush() (Device::Flush and CommandList::Submit do one).
+        void submitUpload(
             StagingHandlePtr staging,
             wgpu::Buffer dstBuffer,
             size_t bytes,
@@ -48,14 +129,25 @@ namespace krnl {
             wgpu::Queue queue
         );
 
-        // Acquire a staging buffer intended for readback (MapRead). This will produce a staging
-        // buffer that includes MapRead | CopyDst | CopySrc for safety.
+        // Queue::WriteBuffer, ordered after everything already enqueued in the pool: the fallback
+        // when allocate refuses a region.
+        void writeDirect(wgpu::Buffer dstBuffer, size_t dstOffset, const void* src, size_t bytes, wgpu::Queue queue);
+
+        // Acquire a MapRead | CopyDst staging buffer of at least 'size' bytes from the readback
+        // pool. Give it back with releaseReadback once it is unmapped.
         StagingHandlePtr allocateForReadback(size_t size);
+        void releaseReadback(StagingHandlePtr staging);
+
+        // Map a readback staging whose copy has been submitted, call cb with its first 'bytes'
+        // bytes, then unmap it and return it to the pool. Safe if the pool is gone by then.
+        // If the map fails cb still runs, with (nullptr, 0).
+        wgpu::Future mapReadback(StagingHandlePtr staging, size_t bytes, std::function<void(const void* data, size_t size)> cb);
 
-        // Copy from a source GPU buffer into a readback staging buffer and map it async.
-        // This helper creates a staging (MapRead|CopyDst|CopySrc), issues the copy, submits, maps it,
-        // and calls callback with the mapped pointer when ready.
-        void readbackInto(
+        // Copy src into a pooled readback buffer, map it and call cb with the mapped bytes.
+        // The buffer is unmapped and recycled as soon as cb returns; cb gets (nullptr, 0) if
+        // the map fails. Pending uploads are flushed first so the copy sees them. The callback
+        // can fire from ProcessEvents, WaitAny on the returned future, or spontaneously.
+        wgpu::Future readbackInto(
             wgpu::Buffer src,
             size_t bytes,
             size_t srcOffset,
@@ -63,16 +155,47 @@ namespace krnl {
             std::function<void(const void* data, size_t size)> cb
         );
 
+        Stats getStats();
+
+        // Drop idle chunks and readback buffers. Chunks in flight are released once remapped.
         void purge();
 
     private:
-        StagingHandlePtr createStaging(size_t size);
+        std::unique_lock<std::mutex> lock();
+
+        StagingChunkPtr createChunk(size_t size);
+        StagingChunkPtr acquireChunk(size_t size);
+        void reclaim();
+        // Submit every chunk ready to go; the open chunk only with includeCurrent
+        void submitChunks(wgpu::Queue queue, bool includeCurrent);
         StagingHandlePtr createReadbackStaging(size_t size);
+        // afterSubmit runs once cmd is on the queue; flushNow forces the submission queue out
+        void submit(wgpu::Queue queue, wgpu::CommandBuffer cmd, std::function<void()> afterSubmit, bool flushNow);
+
+        // Idle readback buffers per size class. Shared with map callbacks, which may run
+        // after the pool is gone.
+        struct ReadbackState {
+            std::mutex mutex;
+            std::vector<std::vector<StagingHandlePtr>> free;
+            size_t maxPerClass = 0;
+            uint64_t readbacks = 0;
+            uint64_t created = 0;
+            uint64_t reused = 0;
+        };
+        static void recycleReadback(ReadbackState& state, StagingHandlePtr staging);
 
         wgpu::Device m_device;
         Config m_cfg;
-        std::vector<StagingHandlePtr> m_ready;
-        std::vector<StagingHandlePtr> m_inflight;
+        SubmitQueue* m_submitQueue = nullptr;
+        std::shared_ptr<Metrics> m_metrics;
+
+        StagingChunkPtr m_current;                  // chunk new regions are carved from
+        std::vector<StagingChunkPtr> m_active;      // retired from m_current, copies not yet submitted
+        std::vector<StagingChunkPtr> m_inflight;
+        std::vector<StagingChunkPtr> m_free;
+        Stats m_stats;
+
+        std::shared_ptr<ReadbackState> m_readback;
         std::mutex m_mutex;
     };
 
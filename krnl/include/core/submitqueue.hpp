@@ -0,0 +1,92 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace krnl {
+
+    class Profiler;
+
+    /**
+     * Per-device submission queue. Finished command buffers are collected and handed to
+     * Queue::Submit together: when maxPending are waiting, on an explicit Flush(), or when a
+     * map/readback needs their results (Buffer::MapAsync, readbacks and Queue::WriteBuffer
+     * flush first so ordering on the queue timeline is unchanged).
+     *
+     * Thread-safe. Command lists recorded in parallel can keep a deterministic order by
+     * reserving tickets up front: a ticketed command buffer is enqueued only once every
+     * earlier ticket has been filled or cancelled. Untracked Enqueue calls (uploads,
+     * readbacks) are not held back by outstanding tickets.
+     */
+    class SubmitQueue {
+    public:
+        using Ticket = uint64_t;
+
+        struct Stats {
+            uint64_t enqueued = 0;          // command buffers
+            uint64_t submits = 0;           // Queue::Submit calls
+            uint64_t thresholdFlushes = 0;
+            uint64_t ticketsReserved = 0;
+        };
+
+        // maxPending == 1 submits every command buffer immediately
+        SubmitQueue(wgpu::Queue queue, size_t maxPending = 16);
+        // Pending command buffers are submitted
+        ~SubmitQueue();
+
+        SubmitQueue(const SubmitQueue&) = delete;
+        SubmitQueue& operator=(const SubmitQueue&) = delete;
+
+        // afterSubmit runs right after the batch holding cmd was submitted (e.g. to MapAsync a
+        // buffer the command buffer used, which is not allowed before it is submitted).
+        void Enqueue(wgpu::CommandBuffer cmd, std::function<void()> afterSubmit = {});
+
+        // Reserve the next position in submission order. Every ticket must eventually be
+        // passed to Enqueue or Cancel; later tickets wait for it.
+        Ticket Reserve();
+        void Enqueue(Ticket ticket, wgpu::CommandBuffer cmd, std::function<void()> afterSubmit = {});
+        void Cancel(Ticket ticket);
+
+        void Flush();
+
+        // Command buffers ready to submit (not counting ones waiting on an earlier ticket)
+        size_t GetPendingCount() const;
+        Stats GetStats() const;
+        const wgpu::Queue& GetNative() const { return m_Queue; }
+
+        // Record Queue::Submit calls as host spans; the profiler must outlive the queue
+        void setProfiler(Profiler* profiler) { m_Profiler = profiler; }
+
+    private:
+        wgpu::Queue m_Queue;
+        size_t m_MaxPending;
+        Profiler* m_Profiler = nullptr;
+
+        mutable std::mutex m_Mutex;
+        std::vector<wgpu::CommandBuffer> m_Pending;
+        std::vector<std::function<void()>> m_AfterSubmit;
+        Stats m_Stats;
+
+        struct Slot {
+            bool filled = false;
+            wgpu::CommandBuffer cmd;    // null for a cancelled ticket
+            std::function<void()> afterSubmit;
+        };
+        // Tickets from m_NextTicket on, in order
+        std::deque<Slot> m_Reserved;
+        Ticket m_NextTicket = 0;
+
+        // Called with m_Mutex held; returns true when the threshold is reached
+        bool push(wgpu::CommandBuffer cmd, std::function<void()> afterSubmit);
+        bool fill(Ticket ticket, wgpu::CommandBuffer cmd, std::function<void()> afterSubmit);
+
+        // Held across take + Submit so batches reach the queue in the order they were taken.
+        // Recursive: after-submit hooks and spontaneous callbacks may flush again.
+        std::recursive_mutex m_SubmitMutex;
+    };
+
+} // namespace krnl
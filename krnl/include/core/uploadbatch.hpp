@@ -0,0 +1,70 @@
+#pragma once
+#include <webgpu/webgpu_cpp.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "core/stagingpool.hpp"
+
+namespace krnl {
+
+    class Device;
+    class Buffer;
+
+    /**
+     * Coalesces many small buffer writes into one staging region and a single command buffer
+     * of CopyBufferToBuffer commands. Writes are packed back to back into a mapped region of
+     * the device's upload ring, and a write that continues the previous one in the same buffer
+     * extends its copy instead of adding another. Nothing reaches the GPU until Flush(); the
+     * device's own batch (Device::GetUploadBatch) is also flushed by CommandList::Submit.
+     *
+     * When the ring is at its in-flight chunk limit, a write falls back to Queue::WriteBuffer
+     * after submitting the writes before it.
+     *
+     * Sizes and destination offsets must be multiples of 4. Ordering against
+     * Buffer::WriteBuffer on the same range is only guaranteed across a Flush.
+     */
+    class UploadBatch {
+    public:
+        struct Stats {
+            uint64_t writes = 0;
+            uint64_t bytes = 0;
+            uint64_t copies = 0;        // copy commands after merging
+            uint64_t flushes = 0;
+        };
+
+        explicit UploadBatch(const Device& device);
+        UploadBatch(PersistentStagingPool& pool, wgpu::Queue queue, size_t regionSize = 64u << 10);
+        // Pending writes are submitted
+        ~UploadBatch();
+
+        UploadBatch(const UploadBatch&) = delete;
+        UploadBatch& operator=(const UploadBatch&) = delete;
+
+        // Offsets are relative to the Buffer's own range (sub-allocated views included)
+        void Write(const Buffer& dst, const void* src, size_t bytes, size_t dstOffset = 0);
+        void Write(wgpu::Buffer dst, const void* src, size_t bytes, size_t dstOffset);
+
+        // Submit every write made so far in one command buffer, along with the staging ring's
+        // other pending uploads
+        void Flush();
+
+        bool Empty() const;
+        Stats GetStats() const;
+
+    private:
+        void closeRegion();
+
+        PersistentStagingPool& m_Pool;
+        wgpu::Queue m_Queue;
+        size_t m_RegionSize;
+
+        StagingHandlePtr m_Region;              // region currently being packed
+        size_t m_Head = 0;
+        std::vector<StagingChunk::Copy> m_Copies;   // srcOffset relative to m_Region
+        Stats m_Stats;
+        mutable std::mutex m_Mutex;
+    };
+
+} // namespace krnl
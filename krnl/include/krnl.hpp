@@ -3,7 +3,18 @@
 #include "core/instance.hpp"
 #include "core/future.hpp"
 #include "core/buffer.hpp"
+#include "core/mappedview.hpp"
+#include "core/uploadbatch.hpp"
+#include "core/readbackbatch.hpp"
 #include "core/parameterset.hpp"
 #include "core/commandlist.hpp"
+#include "core/capture.hpp"
 #include "core/pipeline.hpp"
+#include "core/profiler.hpp"
+#include "core/metrics.hpp"
+#include "core/graph.hpp"
+#include "core/autotuner.hpp"
 #include "core/shader.hpp"
+#include "tensor/tensor.hpp"
+#include "tensor/gemm.hpp"
+#include "tensor/expr.hpp"
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include "core/commandlist.hpp"
+#include "tensor/tensor.hpp"
+
+namespace krnl {
+
+    enum class UnaryOp {
+        Neg,
+        Abs,
+        Exp,
+        Log,
+        Sqrt,
+        Relu,
+        Sigmoid,
+        Tanh,
+    };
+
+    /**
+     * A lazy elementwise expression over tensors. Building one (the operators, Binary, Unary,
+     * Scalar) only records a node; shapes broadcast NumPy-style and are checked right away.
+     * Eval generates one WGSL kernel for the whole tree: every input is read once, the
+     * intermediates stay in registers, and only the result is written, where TensorOps
+     * launches a kernel and writes a full tensor per op.
+     *
+     * Generated kernels are cached by structure: the ops, which nodes are shared, which
+     * inputs share storage and which are dense. Sizes, strides and scalar values are kernel
+     * parameters, so rebuilding the same chain over new tensors reuses its pipeline.
+     *
+     * Exp, Log, Sqrt, Sigmoid and Tanh need f32 operands; Neg needs f32 or i32. An invalid
+     * node (the error is logged) makes every expression built on it invalid.
+     */
+    class Expr {
+    public:
+        Expr() = default;
+        // Reads t (any view)
+        Expr(const Tensor& t);
+
+        // A constant that broadcasts to any shape
+        static Expr Scalar(double value, DType dtype = DType::F32);
+        static Expr Binary(BinaryOp op, const Expr& a, const Expr& b);
+        static Expr Unary(UnaryOp op, const Expr& a);
+
+        static Expr Max(const Expr& a, const Expr& b) { return Binary(BinaryOp::Max, a, b); }
+        static Expr Min(const Expr& a, const Expr& b) { return Binary(BinaryOp::Min, a, b); }
+        Expr Abs() const { return Unary(UnaryOp::Abs, *this); }
+        Expr Exp() const { return Unary(UnaryOp::Exp, *this); }
+        Expr Log() const { return Unary(UnaryOp::Log, *this); }
+        Expr Sqrt() const { return Unary(UnaryOp::Sqrt, *this); }
+        Expr Relu() const { return Unary(UnaryOp::Relu, *this); }
+        Expr Sigmoid() const { return Unary(UnaryOp::Sigmoid, *this); }
+        Expr Tanh() const { return Unary(UnaryOp::Tanh, *this); }
+
+        // New contiguous tensor holding the result, computed by one fused dispatch (more if the
+        // inputs need more storage bindings than the device allows). Recorded into cmd, or
+        // submitted on its own; the inputs are read when the commands execute.
+        Tensor Eval() const;
+        Tensor Eval(CommandList& cmd) const;
+
+        bool IsValid() const { return m_Node != nullptr; }
+        const Shape& GetShape() const;
+        DType GetDType() const;
+        // Unary and binary nodes in the tree
+        size_t GetOpCount() const;
+
+        // Tree node; defined with the code generator
+        struct Node;
+
+    private:
+        explicit Expr(std::shared_ptr<const Node> node) : m_Node(std::move(node)) {}
+
+        std::shared_ptr<const Node> m_Node;
+    };
+
+    Expr operator+(const Expr& a, const Expr& b);
+    Expr operator-(const Expr& a, const Expr& b);
+    Expr operator*(const Expr& a, const Expr& b);
+    Expr operator/(const Expr& a, const Expr& b);
+    Expr operator-(const Expr& a);
+
+    // The scalar takes the expression's dtype
+    Expr operator+(const Expr& a, double b);
+    Expr operator-(const Expr& a, double b);
+    Expr operator*(const Expr& a, double b);
+    Expr operator/(const Expr& a, double b);
+    Expr operator+(double a, const Expr& b);
+    Expr operator-(double a, const Expr& b);
+    Expr operator*(double a, const Expr& b);
+    Expr operator/(double a, const Expr& b);
+
+} // namespace krnl
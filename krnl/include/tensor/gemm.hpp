@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "tensor/tensor.hpp"
+
+namespace krnl {
+
+    /**
+     * One kernel of the TensorOps::MatMul family. A workgroup computes a tileM x tileN block of
+     * C, walking K in steps of tileK through workgroup memory; each of its
+     * (tileM / threadM) x (tileN / threadN) threads accumulates a threadM x threadN block in
+     * registers. Tiles are loaded with vec4 reads when an operand's contiguous dimension
+     * allows it.
+     */
+    struct GemmConfig {
+        uint32_t tileM = 64;
+        uint32_t tileN = 64;
+        uint32_t tileK = 8;
+        uint32_t threadM = 4;
+        uint32_t threadN = 4;
+
+        uint32_t ThreadsX() const { return tileN / threadN; }
+        uint32_t ThreadsY() const { return tileM / threadM; }
+        uint32_t Threads() const { return ThreadsX() * ThreadsY(); }
+        size_t SharedBytes() const { return size_t(tileK) * (tileM + tileN) * sizeof(float); }
+        // Usable on a device with these limits
+        bool Fits(const wgpu::Limits& limits) const;
+        // "64x64x8_4x4"
+        std::string Name() const;
+
+        bool operator==(const GemmConfig& other) const = default;
+    };
+
+    /**
+     * Chooses the GemmConfig for each TensorOps::MatMul through Autotuner::Default(), so
+     * choices persist per adapter across runs. The problem class is the kernel name (how each
+     * operand is laid out) and the size bucket (M, N and K rounded up to powers of two). On a
+     * miss every candidate that fits the device is timed on the actual operands, once per
+     * class; with tuning off (Autotuner::SetTuning) a size heuristic picks instead.
+     */
+    class GemmTuner {
+    public:
+        static const std::vector<GemmConfig>& Candidates();
+        // The candidate with this Name()
+        static std::optional<GemmConfig> FromName(const std::string& name);
+
+        // Autotuner kernel name and size bucket of a x b (2-D f32 operands): "gemm_k4_x4", "512x512x256"
+        static std::string Kernel(const Tensor& a, const Tensor& b);
+        static std::string Bucket(const Tensor& a, const Tensor& b);
+
+        // Stored, tuned or heuristic choice for a x b
+        static GemmConfig Choose(const Tensor& a, const Tensor& b);
+    };
+
+} // namespace krnl
@@ -1,95 +1,184 @@
-//#pragma once
-//#include <vector>
-//#include <cstdint>
-//#include <memory>
-//#include <string>
-//#include <future>
-//#include <webgpu/webgpu_cpp.h>
-//#include "core/buffer.hpp"
-//#include "core/stagingpool.hpp"
-//#include "core/pipeline.hpp"
-//#include "core/parameterset.hpp"
-//
-//namespace krnl {
-//
-//    enum class DType {
-//        F32,
-//        // add others later
-//    };
-//
-//    struct Shape {
-//        std::vector<size_t> dims;
-//        size_t size() const {
-//            size_t s = 1;
-//            for (auto d : dims) s *= d;
-//            return s;
-//        }
-//    };
-//
-//    class Tensor {
-//    public:
-//        // Create an empty tensor (uninitialized)
-//        static Tensor Empty(wgpu::Device device, const Shape& shape, DType dtype, const char* label = nullptr);
-//
-//        // Create and upload from host vector<float>
-//        static Tensor FromHost(wgpu::Device device, const std::vector<float>& data, const Shape& shape, PersistentStagingPool* pool = nullptr, const char* label = nullptr);
-//
-//        // Create zeros
-//        static Tensor Zeros(wgpu::Device device, const Shape& shape, PersistentStagingPool* pool = nullptr, const char* label = nullptr);
-//
-//        // Accessors
-//        const Shape& shape() const { return m_shape; }
-//        size_t elementCount() const { return m_shape.size(); }
-//        size_t byteSize() const { return m_sizeBytes; }
-//        DType dtype() const { return m_dtype; }
-//        const krnl::Buffer& buffer() const { return m_buffer; }
-//
-//        // Write data from host (synchronous): uses staging pool if provided else Buffer::writeViaStaging
-//        void write(const void* src, size_t bytes, wgpu::Queue queue, PersistentStagingPool* pool = nullptr);
-//
-//        // Async write (returns immediately)
-//        void writeAsync(const void* src, size_t bytes, wgpu::Queue queue, PersistentStagingPool* pool = nullptr);
-//
-//        // Blocking host read (returns vector<float>)
-//        std::vector<float> toHost(wgpu::Device device, wgpu::Queue queue) const;
-//
-//        // convenience dtype helpers
-//        static size_t dtypeSize(DType dt) {
-//            switch (dt) {
-//            case DType::F32: return sizeof(float);
-//            default: return sizeof(float);
-//            }
-//        }
-//
-//    private:
-//        Tensor() = default;
-//        Tensor(wgpu::Device device, const Shape& shape, DType dtype, const krnl::Buffer& buffer);
-//
-//    private:
-//        Shape m_shape;
-//        DType m_dtype;
-//        size_t m_sizeBytes = 0;
-//        krnl::Buffer m_buffer;
-//        wgpu::Device m_device;
-//    };
-//
-//    /////////////////////////
-//    // TensorOps
-//    /////////////////////////
-//    class TensorOps {
-//    public:
-//        // elementwise add: C = A + B  (all same shape)
-//        // returns new Tensor with result
-//        static Tensor Add(const Tensor& A, const Tensor& B, wgpu::Queue queue);
-//
-//        // matmul: C = A * B
-//        // A: MxK, B: KxN -> C: MxN
-//        static Tensor MatMul(const Tensor& A, const Tensor& B, wgpu::Queue queue);
-//
-//    private:
-//        // internal helpers to get pipelines (cached per device could be added)
-//        static Pipeline makeAddPipeline(wgpu::Device device, ParameterSet& params);
-//        static Pipeline makeMatMulPipeline(wgpu::Device device, ParameterSet& params, size_t M, size_t N, size_t K);
-//    };
-//
-//} // namespace krnl
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "core/buffer.hpp"
+#include "core/commandlist.hpp"
+#include "core/device.hpp"
+#include "core/future.hpp"
+
+namespace krnl {
+
+    enum class DType {
+        F32,
+        I32,
+        U32,
+    };
+
+    // Every supported dtype is 32-bit
+    inline size_t DTypeSize(DType) { return 4; }
+
+    // WGSL scalar type of a dtype ("f32", "i32", "u32")
+    const char* DTypeWGSL(DType dtype);
+
+    using Shape = std::vector<size_t>;
+
+    struct GemmConfig;
+
+    inline size_t ShapeElementCount(const Shape& shape) {
+        size_t n = 1;
+        for (size_t d : shape) {
+            n *= d;
+        }
+        return n;
+    }
+
+    /**
+     * An n-dimensional view of device memory: shape, per-dimension strides (in elements) and a
+     * byte offset into a Buffer that views share. Slice, Select, Transpose, Permute, Squeeze,
+     * Unsqueeze, BroadcastTo and (where the strides allow) Reshape only derive new metadata;
+     * no memory is allocated or copied, and every view sees writes made through the others.
+     * A stride of 0 repeats one element along that dimension (broadcasting).
+     *
+     * TensorOps kernels read strided operands as they are. A dense copy is made only where
+     * one is really needed: Contiguous() on a view that isn't row-major, Reshape when no
+     * view of the current layout has the new shape, and reads back to the host.
+     *
+     * Storage is sub-allocated from the device allocator with Storage | CopySrc | CopyDst
+     * usage. A default-constructed Tensor is invalid; so is the result of an invalid view
+     * or op (the error is logged).
+     */
+    class Tensor {
+    public:
+        static constexpr size_t kMaxRank = 8;
+
+        Tensor() = default;
+
+        // Uninitialized contents
+        static Tensor Empty(const Device& device, const Shape& shape, DType dtype = DType::F32, const std::string& label = "tensor");
+        // 'data' holds the elements densely in row-major order
+        static Tensor FromHost(const Device& device, const void* data, const Shape& shape, DType dtype, const std::string& label = "tensor");
+        static Tensor FromHost(const Device& device, const std::vector<float>& data, const Shape& shape, const std::string& label = "tensor");
+        static Tensor Zeros(const Device& device, const Shape& shape, DType dtype = DType::F32, const std::string& label = "tensor");
+        // Row-major view of an existing buffer (which needs Storage usage), starting at byteOffset
+        static Tensor FromBuffer(const Device& device, const Buffer& buffer, const Shape& shape, DType dtype, size_t byteOffset = 0);
+
+        // Zero-copy views
+        // Elements start, start + step, ... below end along dim
+        Tensor Slice(size_t dim, size_t start, size_t end, size_t step = 1) const;
+        // Element 'index' along dim, which is removed
+        Tensor Select(size_t dim, size_t index) const;
+        Tensor Transpose(size_t dim0, size_t dim1) const;
+        // Dimension i of the result is dimension dims[i] of this tensor
+        Tensor Permute(const std::vector<size_t>& dims) const;
+        // Remove every dimension of size 1, or only 'dim'
+        Tensor Squeeze() const;
+        Tensor Squeeze(size_t dim) const;
+        // Insert a dimension of size 1 before 'dim' (dim == rank appends one)
+        Tensor Unsqueeze(size_t dim) const;
+        // NumPy broadcasting: size-1 and missing leading dimensions repeat with stride 0
+        Tensor BroadcastTo(const Shape& shape) const;
+
+        // A view when the strides allow it, otherwise a contiguous copy with the new shape.
+        // The copy is recorded into cmd, or submitted on its own.
+        Tensor Reshape(const Shape& shape) const;
+        Tensor Reshape(CommandList& cmd, const Shape& shape) const;
+        // Dense row-major tensor with the same elements: *this when already contiguous
+        Tensor Contiguous() const;
+        Tensor Contiguous(CommandList& cmd) const;
+
+        // Overwrite the elements of a contiguous tensor from dense host data
+        void Write(const void* data, size_t bytes);
+        // The elements in row-major order; strided views are made contiguous first
+        Future<std::vector<std::byte>> ReadAsync() const;
+        template<typename T>
+        std::vector<T> ToHost() const {
+            // The future owns the value: keep it alive while the bytes are copied out
+            const Future<std::vector<std::byte>> read = ReadAsync();
+            const std::vector<std::byte>& bytes = read.Get();
+            std::vector<T> out(bytes.size() / sizeof(T));
+            std::memcpy(out.data(), bytes.data(), out.size() * sizeof(T));
+            return out;
+        }
+
+        bool IsValid() const { return m_Storage != nullptr; }
+        // Row-major with no gaps (size-1 dimensions may have any stride)
+        bool IsContiguous() const;
+
+        const Shape& GetShape() const { return m_Shape; }
+        const std::vector<size_t>& GetStrides() const { return m_Strides; }
+        size_t GetRank() const { return m_Shape.size(); }
+        size_t GetElementCount() const { return ShapeElementCount(m_Shape); }
+        // Bytes of the elements, not of the storage they are spread over
+        size_t GetByteSize() const { return GetElementCount() * DTypeSize(m_DType); }
+        DType GetDType() const { return m_DType; }
+        // Offset of element 0 from the start of GetStorage()
+        size_t GetByteOffset() const { return m_ByteOffset; }
+        const Buffer& GetStorage() const { return *m_Storage; }
+        const std::shared_ptr<Buffer>& GetStoragePtr() const { return m_Storage; }
+        const Device& GetDevice() const { return *m_Device; }
+
+        // Row-major strides of a shape
+        static std::vector<size_t> ContiguousStrides(const Shape& shape);
+
+    private:
+        Tensor(const Device& device, std::shared_ptr<Buffer> storage, Shape shape, std::vector<size_t> strides, size_t byteOffset, DType dtype);
+
+        // Same storage, new metadata
+        Tensor view(Shape shape, std::vector<size_t> strides, size_t byteOffset) const;
+
+        const Device* m_Device = nullptr;
+        std::shared_ptr<Buffer> m_Storage;
+        Shape m_Shape;
+        std::vector<size_t> m_Strides;
+        size_t m_ByteOffset = 0;
+        DType m_DType = DType::F32;
+    };
+
+    enum class BinaryOp {
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Max,
+        Min,
+    };
+
+    /**
+     * Kernels over tensors. Operands may be any view (strided, offset, broadcast) of the same
+     * dtype; results are new contiguous tensors. The overloads taking a CommandList record
+     * into it (inside its open compute pass, if any) and keep their temporaries alive until
+     * the list is destroyed; the others submit their own list. Don't record tensor ops into
+     * a capture: the temporaries would not outlive the list.
+     */
+    class TensorOps {
+    public:
+        // Elementwise with NumPy broadcasting
+        static Tensor Binary(BinaryOp op, const Tensor& a, const Tensor& b);
+        static Tensor Binary(CommandList& cmd, BinaryOp op, const Tensor& a, const Tensor& b);
+
+        static Tensor Add(const Tensor& a, const Tensor& b) { return Binary(BinaryOp::Add, a, b); }
+        static Tensor Sub(const Tensor& a, const Tensor& b) { return Binary(BinaryOp::Sub, a, b); }
+        static Tensor Mul(const Tensor& a, const Tensor& b) { return Binary(BinaryOp::Mul, a, b); }
+        static Tensor Div(const Tensor& a, const Tensor& b) { return Binary(BinaryOp::Div, a, b); }
+
+        // C = A x B for 2-D f32 tensors (M x K times K x N). Any strides work, so a Transpose
+        // view is a transposed operand with no copy. The tile configuration comes from
+        // GemmTuner (tensor/gemm.hpp) unless one is given.
+        static Tensor MatMul(const Tensor& a, const Tensor& b);
+        static Tensor MatMul(CommandList& cmd, const Tensor& a, const Tensor& b);
+        static Tensor MatMul(CommandList& cmd, const Tensor& a, const Tensor& b, const GemmConfig& config);
+
+        // Dense row-major copy of any view
+        static Tensor Copy(const Tensor& src);
+        static Tensor Copy(CommandList& cmd, const Tensor& src);
+
+        // Shape both operands broadcast to, if they are compatible
+        static std::optional<Shape> BroadcastShapes(const Shape& a, const Shape& b);
+    };
+
+} // namespace krnl
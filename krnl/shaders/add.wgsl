@@ -1,9 +1,24 @@
+// out = a + b. Each thread adds ELEMENTS_PER_THREAD elements, WORKGROUP_SIZE apart, so a
+// workgroup covers one contiguous block of WORKGROUP_SIZE * ELEMENTS_PER_THREAD elements;
+// both are set per pipeline through Pipeline::CreateCompute's constants. Dispatch
+// ceil(count / block) workgroups, split over x and y past the per-dimension limit.
+override WORKGROUP_SIZE : u32 = 64;
+override ELEMENTS_PER_THREAD : u32 = 1;
+
 @group(0) @binding(0) var<storage, read> a : array<f32>;
 @group(0) @binding(1) var<storage, read> b : array<f32>;
 @group(0) @binding(2) var<storage, read_write> out : array<f32>;
 
-@compute @workgroup_size(1)
-fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
-    let i = gid.x;
-    out[i] = a[i] + b[i];
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(workgroup_id) wid : vec3<u32>,
+        @builtin(num_workgroups) groups : vec3<u32>,
+        @builtin(local_invocation_index) lid : u32) {
+    let base = (wid.y * groups.x + wid.x) * WORKGROUP_SIZE * ELEMENTS_PER_THREAD + lid;
+    let count = arrayLength(&out);
+    for (var j = 0u; j < ELEMENTS_PER_THREAD; j = j + 1u) {
+        let i = base + j * WORKGROUP_SIZE;
+        if (i < count) {
+            out[i] = a[i] + b[i];
+        }
+    }
 }
@@ -0,0 +1,368 @@
+#include "core/allocator.hpp"
+#include "core/log.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+
+namespace krnl {
+
+    struct BufferAllocator::Block {
+        Heap* heap = nullptr;
+        wgpu::Buffer buffer;
+        // Free buddy ranges by order (offsets within the block)
+        std::vector<std::unordered_set<uint64_t>> freeByOrder;
+        Metrics::GpuMemory memory;
+    };
+
+    struct BufferAllocator::SlabPage {
+        SlabClass* cls = nullptr;
+        Block* block = nullptr;
+        uint64_t offset = 0;        // page start within the block
+        uint32_t order = 0;         // buddy order of the page
+        uint32_t slotCount = 0;
+        std::vector<uint32_t> freeSlots;
+    };
+
+    struct BufferAllocator::SlabClass {
+        uint64_t slotSize = 0;
+        uint64_t pageSize = 0;
+        std::vector<std::unique_ptr<SlabPage>> pages;
+        std::vector<SlabPage*> partial;     // pages with at least one free slot
+    };
+
+    struct BufferAllocator::Heap {
+        wgpu::BufferUsage usage;
+        std::vector<std::unique_ptr<Block>> blocks;
+        std::vector<SlabClass> classes;
+    };
+
+    BufferAllocation::~BufferAllocation() {
+        if (auto owner = m_Owner.lock()) {
+            owner->release(*this);
+        }
+    }
+
+    std::shared_ptr<BufferAllocator> BufferAllocator::Create(wgpu::Device device) {
+        return Create(device, Config{});
+    }
+
+    std::shared_ptr<BufferAllocator> BufferAllocator::Create(wgpu::Device device, const Config& cfg) {
+        return std::shared_ptr<BufferAllocator>(new BufferAllocator(device, cfg));
+    }
+
+    BufferAllocator::BufferAllocator(wgpu::Device device, const Config& cfg)
+        : m_Device(device), m_Cfg(cfg)
+    {
+        while (orderSize(m_MaxOrder) < m_Cfg.blockSize) {
+            ++m_MaxOrder;
+        }
+        m_Cfg.blockSize = orderSize(m_MaxOrder);
+    }
+
+    BufferAllocator::~BufferAllocator() = default;
+
+    uint32_t BufferAllocator::orderFor(uint64_t size) const {
+        uint32_t order = 0;
+        while (orderSize(order) < size) {
+            ++order;
+        }
+        return order;
+    }
+
+    BufferAllocator::Heap& BufferAllocator::heapFor(wgpu::BufferUsage usage) {
+        auto& heap = m_Heaps[static_cast<uint64_t>(usage)];
+        if (!heap) {
+            heap = std::make_unique<Heap>();
+            heap->usage = usage;
+            for (uint64_t slot = m_Cfg.alignment; slot <= m_Cfg.maxSlabSize; slot *= 2) {
+                SlabClass cls;
+                cls.slotSize = slot;
+                // At least 16 slots per page so a page amortizes one buddy allocation
+                cls.pageSize = std::max(m_Cfg.minBuddySize, slot * 16);
+                heap->classes.push_back(std::move(cls));
+            }
+        }
+        return *heap;
+    }
+
+    BufferAllocator::Block* BufferAllocator::createBlock(Heap& heap) {
+        wgpu::BufferDescriptor desc{};
+        desc.size = m_Cfg.blockSize;
+        desc.usage = heap.usage;
+        desc.mappedAtCreation = false;
+        desc.label = "krnl_heap_block";
+
+        auto block = std::make_unique<Block>();
+        block->heap = &heap;
+        block->buffer = m_Device.CreateBuffer(&desc);
+        block->freeByOrder.resize(m_MaxOrder + 1);
+        block->freeByOrder[m_MaxOrder].insert(0);
+        if (m_Metrics) {
+            block->memory = m_Metrics->TrackGpuMemory(m_Cfg.blockSize);
+        }
+
+        m_Stats.reservedBytes += m_Cfg.blockSize;
+        m_Stats.heapBlocks++;
+
+        heap.blocks.push_back(std::move(block));
+        return heap.blocks.back().get();
+    }
+
+    bool BufferAllocator::buddyAllocate(Heap& heap, uint32_t order, Block*& outBlock, uint64_t& outOffset) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            for (auto& block : heap.blocks) {
+                for (uint32_t k = order; k <= m_MaxOrder; ++k) {
+                    auto& freeList = block->freeByOrder[k];
+                    if (freeList.empty()) {
+                        continue;
+                    }
+                    uint64_t offset = *freeList.begin();
+                    freeList.erase(freeList.begin());
+                    // Split down, returning the upper halves to the free lists
+                    while (k > order) {
+                        --k;
+                        block->freeByOrder[k].insert(offset + orderSize(k));
+                    }
+                    outBlock = block.get();
+                    outOffset = offset;
+                    return true;
+                }
+            }
+            if (attempt == 0) {
+                createBlock(heap);
+            }
+        }
+        return false;
+    }
+
+    void BufferAllocator::buddyFree(Block* block, uint64_t offset, uint32_t order) {
+        while (order < m_MaxOrder) {
+            uint64_t buddy = offset ^ orderSize(order);
+            auto& freeList = block->freeByOrder[order];
+            auto it = freeList.find(buddy);
+            if (it == freeList.end()) {
+                break;
+            }
+            freeList.erase(it);
+            offset = std::min(offset, buddy);
+            ++order;
+        }
+        block->freeByOrder[order].insert(offset);
+    }
+
+    void BufferAllocator::releaseBlockIfEmpty(Block* block) {
+        Heap& heap = *block->heap;
+        // Keep one block per heap around to avoid CreateBuffer churn at the boundary
+        if (heap.blocks.size() <= 1 || block->freeByOrder[m_MaxOrder].empty()) {
+            return;
+        }
+        auto it = std::find_if(heap.blocks.begin(), heap.blocks.end(),
+            [block](const std::unique_ptr<Block>& b) { return b.get() == block; });
+        if (it != heap.blocks.end()) {
+            (*it)->buffer.Destroy();
+            heap.blocks.erase(it);
+            m_Stats.reservedBytes -= m_Cfg.blockSize;
+            m_Stats.heapBlocks--;
+        }
+    }
+
+    BufferAllocationPtr BufferAllocator::Allocate(uint64_t size, wgpu::BufferUsage usage, const char* label) {
+        auto allocation = std::make_shared<BufferAllocation>();
+        allocation->m_Requested = size;
+
+        size = std::max<uint64_t>(size, 1);
+
+        if (size > m_Cfg.blockSize) {
+            uint64_t rounded = (size + m_Cfg.alignment - 1) / m_Cfg.alignment * m_Cfg.alignment;
+            wgpu::BufferDescriptor desc{};
+            desc.size = rounded;
+            desc.usage = usage;
+            desc.label = label;
+            allocation->m_Buffer = m_Device.CreateBuffer(&desc);
+            allocation->m_Size = rounded;
+            allocation->m_Kind = BufferAllocation::Kind::Dedicated;
+            if (m_Metrics) {
+                allocation->m_Memory = m_Metrics->TrackGpuMemory(rounded);
+            }
+
+            allocation->m_Owner = weak_from_this();
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stats.reservedBytes += rounded;
+            m_Stats.dedicatedAllocations++;
+            m_Stats.liveAllocations++;
+            m_Stats.totalAllocations++;
+            m_Stats.requestedBytes += allocation->m_Requested;
+            m_Stats.usedBytes += rounded;
+            return allocation;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Heap& heap = heapFor(usage);
+
+        if (size <= m_Cfg.maxSlabSize) {
+            size_t classIndex = 0;
+            while (heap.classes[classIndex].slotSize < size) {
+                ++classIndex;
+            }
+            SlabClass& cls = heap.classes[classIndex];
+
+            if (cls.partial.empty()) {
+                uint32_t order = orderFor(cls.pageSize);
+                Block* block = nullptr;
+                uint64_t offset = 0;
+                if (!buddyAllocate(heap, order, block, offset)) {
+                    KRNL_ERROR("BufferAllocator: failed to allocate a slab page of " << cls.pageSize << " bytes");
+                    return nullptr;
+                }
+                auto page = std::make_unique<SlabPage>();
+                page->cls = &cls;
+                page->block = block;
+                page->offset = offset;
+                page->order = order;
+                page->slotCount = static_cast<uint32_t>(orderSize(order) / cls.slotSize);
+                page->freeSlots.reserve(page->slotCount);
+                for (uint32_t s = page->slotCount; s > 0; --s) {
+                    page->freeSlots.push_back(s - 1);
+                }
+                cls.partial.push_back(page.get());
+                cls.pages.push_back(std::move(page));
+            }
+
+            SlabPage* page = cls.partial.back();
+            uint32_t slot = page->freeSlots.back();
+            page->freeSlots.pop_back();
+            if (page->freeSlots.empty()) {
+                cls.partial.pop_back();
+            }
+
+            allocation->m_Buffer = page->block->buffer;
+            allocation->m_Offset = page->offset + slot * cls.slotSize;
+            allocation->m_Size = cls.slotSize;
+            allocation->m_Kind = BufferAllocation::Kind::Slab;
+            allocation->m_Home = page;
+            allocation->m_Slot = slot;
+        }
+        else {
+            uint32_t order = orderFor(size);
+            Block* block = nullptr;
+            uint64_t offset = 0;
+            if (!buddyAllocate(heap, order, block, offset)) {
+                KRNL_ERROR("BufferAllocator: failed to allocate " << size << " bytes");
+                return nullptr;
+            }
+            allocation->m_Buffer = block->buffer;
+            allocation->m_Offset = offset;
+            allocation->m_Size = orderSize(order);
+            allocation->m_Kind = BufferAllocation::Kind::Buddy;
+            allocation->m_Home = block;
+            allocation->m_Slot = order;
+        }
+
+        // Only a fully set up allocation hands itself back on destruction
+        allocation->m_Owner = weak_from_this();
+        m_Stats.liveAllocations++;
+        m_Stats.totalAllocations++;
+        m_Stats.requestedBytes += allocation->m_Requested;
+        m_Stats.usedBytes += allocation->m_Size;
+        return allocation;
+    }
+
+    void BufferAllocator::release(BufferAllocation& allocation) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Stats.liveAllocations--;
+        m_Stats.requestedBytes -= allocation.m_Requested;
+        m_Stats.usedBytes -= allocation.m_Size;
+
+        switch (allocation.m_Kind) {
+        case BufferAllocation::Kind::Dedicated:
+            allocation.m_Buffer.Destroy();
+            m_Stats.reservedBytes -= allocation.m_Size;
+            m_Stats.dedicatedAllocations--;
+            break;
+
+        case BufferAllocation::Kind::Buddy: {
+            Block* block = static_cast<Block*>(allocation.m_Home);
+            buddyFree(block, allocation.m_Offset, allocation.m_Slot);
+            releaseBlockIfEmpty(block);
+            break;
+        }
+
+        case BufferAllocation::Kind::Slab: {
+            SlabPage* page = static_cast<SlabPage*>(allocation.m_Home);
+            SlabClass& cls = *page->cls;
+            if (page->freeSlots.empty()) {
+                cls.partial.push_back(page);
+            }
+            page->freeSlots.push_back(allocation.m_Slot);
+
+            // Give a fully free page back to the buddy heap unless it is the class's only spare
+            if (page->freeSlots.size() == page->slotCount && cls.partial.size() > 1) {
+                cls.partial.erase(std::find(cls.partial.begin(), cls.partial.end(), page));
+                Block* block = page->block;
+                buddyFree(block, page->offset, page->order);
+                cls.pages.erase(std::find_if(cls.pages.begin(), cls.pages.end(),
+                    [page](const std::unique_ptr<SlabPage>& p) { return p.get() == page; }));
+                releaseBlockIfEmpty(block);
+            }
+            break;
+        }
+        }
+    }
+
+    void BufferAllocator::Trim() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto& [usage, heap] : m_Heaps) {
+            // Drop spare slab pages first so their blocks can become empty
+            for (auto& cls : heap->classes) {
+                for (auto it = cls.pages.begin(); it != cls.pages.end();) {
+                    SlabPage* page = it->get();
+                    if (page->freeSlots.size() == page->slotCount) {
+                        cls.partial.erase(std::find(cls.partial.begin(), cls.partial.end(), page));
+                        buddyFree(page->block, page->offset, page->order);
+                        it = cls.pages.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+            }
+            for (auto it = heap->blocks.begin(); it != heap->blocks.end();) {
+                if (!(*it)->freeByOrder[m_MaxOrder].empty()) {
+                    (*it)->buffer.Destroy();
+                    it = heap->blocks.erase(it);
+                    m_Stats.reservedBytes -= m_Cfg.blockSize;
+                    m_Stats.heapBlocks--;
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    BufferAllocator::Stats BufferAllocator::GetStats() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Stats s = m_Stats;
+
+        uint64_t heapBytes = s.heapBlocks * m_Cfg.blockSize;
+        uint64_t dedicatedBytes = s.reservedBytes - heapBytes;
+        uint64_t heapUsed = s.usedBytes - dedicatedBytes;
+        s.freeBytes = heapBytes - heapUsed;
+
+        s.largestFreeRange = 0;
+        for (const auto& [usage, heap] : m_Heaps) {
+            for (const auto& block : heap->blocks) {
+                for (uint32_t k = m_MaxOrder + 1; k > 0; --k) {
+                    if (!block->freeByOrder[k - 1].empty()) {
+                        s.largestFreeRange = std::max(s.largestFreeRange, orderSize(k - 1));
+                        break;
+                    }
+                }
+            }
+        }
+        return s;
+    }
+
+} // namespace krnl
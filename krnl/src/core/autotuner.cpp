@@ -0,0 +1,245 @@
+#include "core/autotuner.hpp"
+#include "core/commandlist.hpp"
+#include "core/device.hpp"
+#include "core/diskcache.hpp"
+#include "core/hash.hpp"
+#include "core/log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <system_error>
+#include <thread>
+
+namespace krnl {
+
+    namespace {
+        const char* kHeader = "# krnl autotune v1";
+
+        bool validField(const std::string& s) {
+            return !s.empty() && s.find_first_of("\t\r\n") == std::string::npos;
+        }
+    }
+
+    Autotuner::Autotuner(std::filesystem::path file)
+        : Autotuner(std::move(file), Options{})
+    {
+    }
+
+    Autotuner::Autotuner(std::filesystem::path file, const Options& options)
+        : m_File(std::move(file)), m_Options(options)
+    {
+        if (!m_File.empty()) {
+            Load();
+        }
+    }
+
+    Autotuner& Autotuner::Default() {
+        static Autotuner tuner([] {
+            if (const char* env = std::getenv("KRNL_AUTOTUNE_FILE"); env && *env) {
+                return std::filesystem::path(env);
+            }
+            return DiskCache::DefaultRoot() / "autotune.txt";
+        }());
+        return tuner;
+    }
+
+    std::string Autotuner::SizeBucket(std::initializer_list<uint64_t> sizes) {
+        std::string bucket;
+        for (uint64_t size : sizes) {
+            uint64_t p = 1;
+            while (p < size && p < (uint64_t(1) << 63)) {
+                p <<= 1;
+            }
+            if (!bucket.empty()) {
+                bucket += "x";
+            }
+            bucket += std::to_string(p);
+        }
+        return bucket;
+    }
+
+    std::string Autotuner::Key(const Device& device, const std::string& kernel, const std::string& bucket) {
+        return device.GetAdapterKey() + "|" + kernel + "|" + bucket;
+    }
+
+    std::optional<std::string> Autotuner::Select(const Device& device, const std::string& kernel,
+        const std::string& bucket, const std::vector<Variant>& variants)
+    {
+        if (variants.empty()) {
+            return std::nullopt;
+        }
+        const std::string key = Key(device, kernel, bucket);
+        auto known = [&](const std::string& name) {
+            return std::any_of(variants.begin(), variants.end(), [&](const Variant& v) { return v.name == name; });
+        };
+        if (std::optional<std::string> found = Find(key); found && known(*found)) {
+            return found;
+        }
+        if (!m_Tuning) {
+            return std::nullopt;
+        }
+        if (variants.size() == 1) {
+            return variants[0].name;
+        }
+
+        std::vector<Measurement> measured = Measure(device, variants);
+        auto best = std::min_element(measured.begin(), measured.end(),
+            [](const Measurement& a, const Measurement& b) { return a.ms < b.ms; });
+        if (!std::isfinite(best->ms)) {
+            KRNL_WARN("Autotuner: no variant of " << kernel << " could be timed");
+            return variants[0].name;
+        }
+        KRNL_LOG("Autotuner: " << kernel << " [" << bucket << "] -> " << best->variant << " (" << best->ms << " ms)");
+        Set(key, best->variant, best->ms);
+        return best->variant;
+    }
+
+    std::vector<Autotuner::Measurement> Autotuner::Measure(const Device& device, const std::vector<Variant>& variants) const {
+        std::vector<Measurement> measured;
+        measured.reserve(variants.size());
+        for (const Variant& variant : variants) {
+            Measurement m{ variant.name, std::numeric_limits<double>::infinity() };
+            if (!variant.encode) {
+                measured.push_back(m);
+                continue;
+            }
+            // The first launch compiles the pipeline; it only sizes the trials
+            const double firstMs = timeLaunches(device, variant, 1);
+            const double perLaunch = std::max(firstMs, 1e-3);
+            const uint32_t launches = static_cast<uint32_t>(std::clamp(
+                std::ceil(m_Options.minTrialMs / perLaunch), 1.0, double(std::max(m_Options.maxLaunchesPerTrial, 1u))));
+            for (uint32_t trial = 0; trial < std::max(m_Options.trials, 1u); ++trial) {
+                m.ms = std::min(m.ms, timeLaunches(device, variant, launches) / launches);
+            }
+            measured.push_back(m);
+        }
+        return measured;
+    }
+
+    double Autotuner::timeLaunches(const Device& device, const Variant& variant, uint32_t launches) const {
+        using Clock = std::chrono::steady_clock;
+        auto start = Clock::now();
+        {
+            CommandList cmd(device);
+            for (uint32_t i = 0; i < launches; ++i) {
+                variant.encode(cmd);
+            }
+            cmd.Submit();
+        }
+        device.WaitIdle();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::optional<std::string> Autotuner::Find(const std::string& key) const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Choices.find(key);
+        if (it == m_Choices.end()) {
+            return std::nullopt;
+        }
+        return it->second.variant;
+    }
+
+    void Autotuner::Set(const std::string& key, const std::string& variant, double ms) {
+        if (!validField(key) || !validField(variant)) {
+            KRNL_ERROR("Autotuner: keys and variant names must be non-empty and free of tabs and newlines");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Choices[key] = { variant, ms };
+        }
+        if (!m_File.empty()) {
+            Save();
+        }
+    }
+
+    void Autotuner::Clear() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Choices.clear();
+        }
+        if (!m_File.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(m_File, ec);
+        }
+    }
+
+    size_t Autotuner::Size() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Choices.size();
+    }
+
+    bool Autotuner::Load() {
+        std::error_code ec;
+        if (m_File.empty() || !std::filesystem::exists(m_File, ec)) {
+            return true;
+        }
+        std::ifstream file(m_File);
+        if (!file) {
+            KRNL_WARN("Autotuner: cannot read " << m_File.string());
+            return false;
+        }
+        std::string line;
+        if (!std::getline(file, line) || line != kHeader) {
+            KRNL_WARN("Autotuner: ignoring " << m_File.string() << " (unknown format)");
+            return false;
+        }
+
+        // <key> \t <variant> \t <ms>
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        while (std::getline(file, line)) {
+            const size_t first = line.find('\t');
+            const size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+            if (second == std::string::npos) {
+                continue;
+            }
+            Choice choice;
+            choice.variant = line.substr(first + 1, second - first - 1);
+            choice.ms = std::strtod(line.c_str() + second + 1, nullptr);
+            m_Choices[line.substr(0, first)] = std::move(choice);
+        }
+        return true;
+    }
+
+    bool Autotuner::Save() const {
+        if (m_File.empty()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        std::error_code ec;
+        if (m_File.has_parent_path()) {
+            std::filesystem::create_directories(m_File.parent_path(), ec);
+        }
+
+        // Private temp file and rename, so another process never reads a half-written file
+        std::filesystem::path tmp = m_File;
+        size_t tid = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        tmp += "." + std::to_string(HashCombine(tid, ++m_SaveCounter)) + ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::trunc);
+            file << kHeader << "\n";
+            for (const auto& [key, choice] : m_Choices) {
+                file << key << "\t" << choice.variant << "\t" << choice.ms << "\n";
+            }
+            if (!file) {
+                KRNL_WARN("Autotuner: failed to write " << tmp.string());
+                file.close();
+                std::filesystem::remove(tmp, ec);
+                return false;
+            }
+        }
+        std::filesystem::rename(tmp, m_File, ec);
+        if (ec) {
+            KRNL_WARN("Autotuner: failed to publish " << m_File.string() << " (" << ec.message() << ")");
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace krnl
@@ -6,6 +6,21 @@
 
 namespace krnl {
 
+    namespace {
+        MappedView makeView(const wgpu::Buffer& buffer, MapMode mode, size_t start, size_t size) {
+            if (mode == MapMode::Write) {
+                void* data = buffer.GetMappedRange(start, size);
+                if (data) return MappedView(buffer, data, size, true);
+            }
+            else {
+                const void* data = buffer.GetConstMappedRange(start, size);
+                if (data) return MappedView(buffer, const_cast<void*>(data), size, false);
+            }
+            KRNL_ERROR("Buffer => mapped range [" << start << ", " << start + size << ") is not available");
+            return {};
+        }
+    }
+
     wgpu::BufferDescriptor Buffer::makeDesc(size_t size, wgpu::BufferUsage usage, const char* label, bool mappedAtCreation) {
         wgpu::BufferDescriptor desc{};
         desc.size = size;
@@ -18,6 +33,10 @@ namespace krnl {
 
     Buffer::Buffer(const Device& device, size_t sizeBytes, BufferUsageType usage ,std::string label , bool mappedAtCreation)
         : m_Device(device), m_size(sizeBytes), m_BufferUsageType(usage), m_Label(label), m_Buffer(nullptr) {
+        if (!m_Device.IsValid()) {
+            KRNL_ERROR("Buffer => cannot create " << m_Label << " on an invalid device");
+            return;
+        }
 
         wgpu::BufferDescriptor desc = makeDesc(
             sizeBytes,
@@ -27,31 +46,92 @@ namespace krnl {
         );
 
         m_Buffer = m_Device.GetNative().CreateBuffer(&desc);
+        m_Tracking = m_Device.GetMetrics().TrackBuffer(m_Label, sizeBytes, true);
+    }
+
+    Buffer::Buffer(const Device& device, BufferAllocationPtr allocation, size_t sizeBytes, BufferUsageType usage, std::string label)
+        : m_BufferUsageType(usage), m_Label(label), m_Device(device), m_size(sizeBytes),
+          m_Offset(static_cast<size_t>(allocation->GetOffset())), m_Buffer(allocation->GetBuffer()), m_Allocation(std::move(allocation)) {
+        m_Tracking = m_Device.GetMetrics().TrackBuffer(m_Label, sizeBytes, false);
+    }
+
+    Buffer Buffer::Suballocate(const Device& device, size_t sizeBytes, BufferUsageType usage, std::string label) {
+        const BufferUsageType mapUsage = BufferUsageType::MapRead | BufferUsageType::MapWrite;
+        if (!device.IsValid() || static_cast<uint64_t>(usage & mapUsage) != 0) {
+            return Buffer(device, sizeBytes, usage, std::move(label));
+        }
+
+        BufferAllocationPtr allocation = device.GetAllocator().Allocate(sizeBytes, static_cast<wgpu::BufferUsage>(usage), label.c_str());
+        if (!allocation) {
+            KRNL_WARN("Buffer::Suballocate => allocator failed, using a dedicated buffer for " << label);
+            return Buffer(device, sizeBytes, usage, std::move(label));
+        }
+        return Buffer(device, std::move(allocation), sizeBytes, usage, std::move(label));
     }
 
-    Future Buffer::MapAsync(MapMode mode, size_t offset, size_t size ,void* data) {
+    Future<> Buffer::MapAsync(MapMode mode, size_t offset, size_t size ,void* data) {
+        // The copy is just a consumer of the zero-copy view; the view unmaps when it returns
+        return MapAsync(mode, offset, size, [mode, data](MappedView view) {
+            if (!view.IsValid()) {
+                return;
+            }
+            if (mode == MapMode::Write) {
+                std::memcpy(view.MutableBytes().data(), data, view.GetSize());
+            }
+            else {
+                std::memcpy(data, view.Bytes().data(), view.GetSize());
+            }
+        });
+	}
+
+    Future<> Buffer::MapAsync(MapMode mode, size_t offset, size_t size, MappedCallback cb) {
         assert(m_Buffer);
 		wgpu::MapMode wgpuMode = static_cast<wgpu::MapMode>(mode);
-        return m_Buffer.MapAsync(wgpuMode, 0, size, wgpu::CallbackMode::WaitAnyOnly,
-            [&](wgpu::MapAsyncStatus status, wgpu::StringView message) {
-                if (status == wgpu::MapAsyncStatus::Success) {
-                    const void* mapped = m_Buffer.GetConstMappedRange(offset, size);
-                    memcpy(data, mapped, size);
-					KRNL_LOG("Buffer mapped successfully");
+        const size_t start = m_Offset + offset;
+        // Everything the callback needs is captured by value: it may run after this Buffer is gone
+        wgpu::Buffer buffer = m_Buffer;
+        // Work that writes this buffer must be submitted before it can be mapped
+        m_Device.Flush();
+        std::function<void()> endSpan;
+        if (Profiler* profiler = m_Device.GetProfiler()) {
+            endSpan = profiler->BeginAsyncSpan("map", "MapAsync " + m_Label);
+        }
+        Metrics::MapTimer timer = m_Device.GetMetrics().StartMapWait();
+        wgpu::Future f = m_Buffer.MapAsync(wgpuMode, start, size, wgpu::CallbackMode::AllowSpontaneous,
+            [buffer, mode, start, size, endSpan, timer, cb = std::move(cb)](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+                timer.Stop();
+                if (endSpan) {
+                    endSpan();
                 }
-                else {
+                if (status != wgpu::MapAsyncStatus::Success) {
 					KRNL_ERROR("Buffer mapping failed: " << message);
+                    cb(MappedView());
+                    return;
                 }
+                cb(makeView(buffer, mode, start, size));
             });
+        return Future<>(m_Device.GetInstance(), f);
 	}
 
+    MappedView Buffer::GetMappedView(MapMode mode, size_t offset, size_t size) const {
+        assert(m_Buffer);
+        if (offset + size > m_size) {
+            KRNL_ERROR("Buffer::GetMappedView => out of range (requested " << size << " bytes at offset " << offset << ", buffer size " << m_size << ")");
+            return {};
+        }
+        return makeView(m_Buffer, mode, m_Offset + offset, size);
+    }
+
     void Buffer::WriteBuffer(const void* src, size_t bytes, size_t dstOffset) {
         assert(m_Buffer);
         if (bytes + dstOffset > m_size) {
             KRNL_ERROR("Buffer::WriteBuffer => out of range write (requested " << bytes << " bytes at offset " << dstOffset << ", buffer size " << m_size << ")");
             return;
         }
-        m_Device.GetNative().GetQueue().WriteBuffer(m_Buffer, static_cast<uint64_t>(dstOffset), src, bytes);
+        // Queue::WriteBuffer takes effect ahead of anything not yet submitted: staged uploads
+        // and deferred command buffers go out first
+        m_Device.Flush();
+        m_Device.GetNative().GetQueue().WriteBuffer(m_Buffer, static_cast<uint64_t>(m_Offset + dstOffset), src, bytes);
 	}
 
     ///* writeViaStaging */
@@ -62,61 +142,47 @@ namespace krnl {
             return;
         }
 
-        wgpu::BufferDescriptor desc = makeDesc(bytes, wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc, "krnl_staging_upload", true);
-        wgpu::Buffer staging = m_Device.GetNative().CreateBuffer(&desc);
-
-        void* mapped = staging.GetMappedRange();
-        if (!mapped) {
-            KRNL_ERROR("Buffer::writeViaStaging => staging.GetMappedRange() returned null");
+        // Carve the staging region out of the device's upload ring instead of a fresh buffer per write
+        PersistentStagingPool& pool = m_Device.GetStagingPool();
+        StagingHandlePtr staging = pool.allocate(bytes);
+        if (!staging || !staging->mappedPtr) {
+            // Too many chunks waiting for their remap: don't grow the ring further
+            pool.writeDirect(m_Buffer, m_Offset, src, bytes, m_Device.getQueue());
             return;
         }
-        std::memcpy(mapped, src, bytes);
-        staging.Unmap();
-
-        wgpu::CommandEncoderDescriptor encoderDesc{};
-        wgpu::CommandEncoder encoder = m_Device.GetNative().CreateCommandEncoder(&encoderDesc);
-        encoder.CopyBufferToBuffer(staging, 0, m_Buffer, 0, bytes);
-        wgpu::CommandBuffer cmd = encoder.Finish();
-        m_Device.getQueue().Submit(1, &cmd);
+        std::memcpy(staging->mappedPtr, src, bytes);
+        pool.submitUpload(staging, m_Buffer, bytes, m_Offset, m_Device.getQueue());
     }
 
     ///* readAsync */
-    void Buffer::ReadAsync(ReadCallback cb) {
+    Future<> Buffer::ReadAsync(ReadCallback cb) {
         assert(m_Buffer);
 
-        // create staging read (MapRead | CopyDst)
-        wgpu::BufferDescriptor desc = makeDesc(m_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst, "krnl_staging_read", false);
-        wgpu::Buffer staging = m_Device.GetNative().CreateBuffer(&desc);
-
-        // encode copy
-        wgpu::CommandEncoderDescriptor encoderDesc{};
-        wgpu::CommandEncoder encoder = m_Device.GetNative().CreateCommandEncoder(&encoderDesc);
-        encoder.CopyBufferToBuffer(m_Buffer, 0, staging, 0, m_size);
-        wgpu::CommandBuffer cmd = encoder.Finish();
-        m_Device.getQueue().Submit(1, &cmd);
-
-        auto stagingPtr = std::make_shared<wgpu::Buffer>(staging);
-        stagingPtr->MapAsync(
-            wgpu::MapMode::Read,
-            0,
-            m_size,
-            wgpu::CallbackMode::WaitAnyOnly,
-            [stagingPtr, cb, this](wgpu::MapAsyncStatus status, wgpu::StringView message) {
-                if (status != wgpu::MapAsyncStatus::Success) {
-                    KRNL_ERROR("Buffer::readAsync -> MapAsync failed"<< status <<
-                       message);
-                    return;
-                }
-                const void* mapped = stagingPtr->GetConstMappedRange(0, this->m_size);
-                if (!mapped) {
-                    KRNL_ERROR("Buffer::readAsync -> GetConstMappedRange returned null");
-                    stagingPtr->Unmap();
-                    return;
-                }
-                cb(mapped, this->m_size);
-                stagingPtr->Unmap();
-            }
-        );
+        // Staging comes from the device's readback pool and goes back to it after cb
+        m_Device.GetUploadBatch().Flush();
+        if (Profiler* profiler = m_Device.GetProfiler()) {
+            cb = [endSpan = profiler->BeginAsyncSpan("map", "ReadAsync " + m_Label), cb = std::move(cb)](const void* data, size_t size) {
+                endSpan();
+                cb(data, size);
+            };
+        }
+        wgpu::Future f = m_Device.GetStagingPool().readbackInto(m_Buffer, m_size, m_Offset, m_Device.getQueue(), std::move(cb));
+        return Future<>(m_Device.GetInstance(), f);
+    }
+
+    Future<std::vector<std::byte>> Buffer::ReadAsync() {
+        assert(m_Buffer);
+
+        // The map callback fills the value before the future is marked complete
+        auto state = std::make_shared<detail::FutureState<std::vector<std::byte>>>();
+        m_Device.GetUploadBatch().Flush();
+        wgpu::Future f = m_Device.GetStagingPool().readbackInto(m_Buffer, m_size, m_Offset, m_Device.getQueue(),
+            [state](const void* data, size_t size) {
+                const std::byte* bytes = static_cast<const std::byte*>(data);
+                std::lock_guard<std::mutex> l(state->mutex);
+                state->value.assign(bytes, bytes + size);
+            });
+        return Future<std::vector<std::byte>>(state, &m_Device.GetInstance(), f);
     }
 
 
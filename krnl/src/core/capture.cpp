@@ -0,0 +1,197 @@
+#include "core/capture.hpp"
+#include "core/buffer.hpp"
+#include "core/commandlist.hpp"
+#include "core/device.hpp"
+#include "core/hash.hpp"
+#include "core/parameterset.hpp"
+#include "core/log.h"
+
+#include <cassert>
+
+namespace krnl {
+
+    namespace {
+        // Substituted bind groups kept before the cache starts over
+        constexpr size_t kMaxSubstitutedGroups = 256;
+    }
+
+    void CommandCapture::Reset() {
+        m_Ops.clear();
+        m_Pipelines.clear();
+        m_Groups.clear();
+        m_Copies.clear();
+        m_SubstitutedGroups.clear();
+        m_Dispatches = 0;
+        m_InPass = false;
+        m_CurrentPipeline = -1;
+        m_CurrentGroup = -1;
+    }
+
+    void CommandCapture::RecordBeginPass() {
+        m_Ops.push_back({ OpType::BeginPass, { 0, 0, 0 } });
+        m_InPass = true;
+        m_CurrentPipeline = -1;
+        m_CurrentGroup = -1;
+    }
+
+    void CommandCapture::RecordEndPass() {
+        m_Ops.push_back({ OpType::EndPass, { 0, 0, 0 } });
+        m_InPass = false;
+    }
+
+    void CommandCapture::RecordDispatch(const wgpu::ComputePipeline& pipeline, const ParameterSet& params, uint32_t x, uint32_t y, uint32_t z) {
+        assert(m_InPass && "CommandCapture: dispatch outside a compute pass");
+
+        uint32_t pipelineIndex = 0;
+        while (pipelineIndex < m_Pipelines.size() && m_Pipelines[pipelineIndex].Get() != pipeline.Get()) {
+            pipelineIndex++;
+        }
+        if (pipelineIndex == m_Pipelines.size()) {
+            m_Pipelines.push_back(pipeline);
+        }
+
+        wgpu::BindGroup group = params.bindGroup();
+        uint32_t groupIndex = 0;
+        while (groupIndex < m_Groups.size() && m_Groups[groupIndex].group.Get() != group.Get()) {
+            groupIndex++;
+        }
+        if (groupIndex == m_Groups.size()) {
+            Group g;
+            g.group = group;
+            g.layout = params.layout();
+            for (const ParameterSet::Entry& e : params.entries()) {
+                g.bindings.push_back({ e.buffer.GetNative(), e.buffer.GetOffset(), e.buffer.GetSize() });
+            }
+            m_Groups.push_back(std::move(g));
+        }
+
+        if (m_CurrentPipeline != pipelineIndex) {
+            m_Ops.push_back({ OpType::SetPipeline, { pipelineIndex, 0, 0 } });
+            m_CurrentPipeline = pipelineIndex;
+        }
+        if (m_CurrentGroup != groupIndex) {
+            m_Ops.push_back({ OpType::SetBindGroup, { groupIndex, 0, 0 } });
+            m_CurrentGroup = groupIndex;
+        }
+        m_Ops.push_back({ OpType::Dispatch, { x, y, z } });
+        m_Dispatches++;
+    }
+
+    void CommandCapture::RecordCopy(const wgpu::Buffer& src, uint64_t srcOffset, const wgpu::Buffer& dst, uint64_t dstOffset, uint64_t size) {
+        assert(!m_InPass && "CommandCapture: copy inside a compute pass");
+        m_Copies.push_back({ { src, srcOffset, size }, { dst, dstOffset, size } });
+        m_Ops.push_back({ OpType::Copy, { static_cast<uint32_t>(m_Copies.size() - 1), 0, 0 } });
+    }
+
+    CommandCapture::Resolved CommandCapture::resolve(const wgpu::Buffer& buffer, uint64_t offset, const std::vector<Substitution>& substitutions) const {
+        for (const Substitution& s : substitutions) {
+            const uint64_t base = s.from->GetOffset();
+            if (s.from->GetNative().Get() == buffer.Get() && offset >= base && offset < base + s.from->GetSize()) {
+                return { s.to->GetNative(), s.to->GetOffset() + (offset - base), true };
+            }
+        }
+        return { buffer, offset, false };
+    }
+
+    wgpu::BindGroup CommandCapture::groupFor(const wgpu::Device& device, uint32_t index, const std::vector<Substitution>& substitutions) {
+        const Group& g = m_Groups[index];
+
+        std::vector<Resolved> resolved;
+        resolved.reserve(g.bindings.size());
+        bool any = false;
+        uint64_t key = HashCombine(kHashSeed, index);
+        for (const Binding& b : g.bindings) {
+            resolved.push_back(resolve(b.buffer, b.offset, substitutions));
+            const Resolved& r = resolved.back();
+            if (r.substituted) {
+                any = true;
+                key = HashCombine(key, reinterpret_cast<uintptr_t>(r.buffer.Get()));
+                key = HashCombine(key, r.offset);
+            }
+            else {
+                key = HashCombine(key, 0);
+            }
+        }
+        if (!any) {
+            return g.group;
+        }
+
+        auto it = m_SubstitutedGroups.find(key);
+        if (it != m_SubstitutedGroups.end()) {
+            return it->second;
+        }
+
+        std::vector<wgpu::BindGroupEntry> entries;
+        entries.reserve(resolved.size());
+        for (uint32_t i = 0; i < resolved.size(); ++i) {
+            wgpu::BindGroupEntry ent{};
+            ent.binding = i;
+            ent.buffer = resolved[i].buffer;
+            ent.offset = resolved[i].offset;
+            ent.size = g.bindings[i].size;
+            entries.push_back(ent);
+        }
+
+        wgpu::BindGroupDescriptor desc{};
+        desc.layout = g.layout;
+        desc.entryCount = static_cast<uint32_t>(entries.size());
+        desc.entries = entries.data();
+
+        if (m_SubstitutedGroups.size() >= kMaxSubstitutedGroups) {
+            m_SubstitutedGroups.clear();
+        }
+        wgpu::BindGroup group = device.CreateBindGroup(&desc);
+        m_SubstitutedGroups.emplace(key, group);
+        return group;
+    }
+
+    void CommandCapture::Replay(CommandList& cmd) {
+        Replay(cmd, {});
+    }
+
+    void CommandCapture::Replay(CommandList& cmd, const std::vector<Substitution>& substitutions) {
+        if (cmd.IsCapturing()) {
+            KRNL_ERROR("CommandCapture::Replay: target CommandList is capturing");
+            return;
+        }
+
+        const wgpu::CommandEncoder& encoder = cmd.GetEncoder();
+        wgpu::ComputePassEncoder pass;
+
+        for (const Op& op : m_Ops) {
+            switch (op.type) {
+            case OpType::BeginPass:
+                pass = encoder.BeginComputePass();
+                break;
+            case OpType::EndPass:
+                pass.End();
+                pass = wgpu::ComputePassEncoder();
+                break;
+            case OpType::SetPipeline:
+                pass.SetPipeline(m_Pipelines[op.args[0]]);
+                break;
+            case OpType::SetBindGroup:
+                pass.SetBindGroup(0, substitutions.empty()
+                    ? m_Groups[op.args[0]].group
+                    : groupFor(cmd.GetDevice().GetNative(), op.args[0], substitutions), 0, nullptr);
+                break;
+            case OpType::Dispatch:
+                pass.DispatchWorkgroups(op.args[0], op.args[1], op.args[2]);
+                break;
+            case OpType::Copy: {
+                const Copy& c = m_Copies[op.args[0]];
+                Resolved src = resolve(c.src.buffer, c.src.offset, substitutions);
+                Resolved dst = resolve(c.dst.buffer, c.dst.offset, substitutions);
+                encoder.CopyBufferToBuffer(src.buffer, src.offset, dst.buffer, dst.offset, c.src.size);
+                break;
+            }
+            }
+        }
+
+        if (pass) {
+            KRNL_WARN("CommandCapture::Replay: capture ended inside a compute pass; closing it");
+            pass.End();
+        }
+    }
+
+} // namespace krnl
@@ -1,31 +1,115 @@
 #include "core/commandlist.hpp"
+#include "core/log.h"
 
 namespace krnl {
 
+    CommandList::CommandList(const Device& device)
+        : m_Device(device) {
+        if (!device.IsValid()) {
+            KRNL_ERROR("CommandList => the device is invalid");
+            return;
+        }
+        m_Encoder = device.GetNative().CreateCommandEncoder();
+        if (Profiler* profiler = device.GetProfiler()) {
+            m_Profile = profiler->BeginList();
+        }
+    }
+
     void CommandList::BeginComputePass() {
-        m_ComputePass = m_Encoder.BeginComputePass();
+        if (m_Capture) {
+            m_Capture->RecordBeginPass();
+            return;
+        }
+        if (!m_Encoder) {
+            return;
+        }
+        wgpu::ComputePassDescriptor desc{};
+        wgpu::PassTimestampWrites writes{};
+        if (m_Profile && m_Device.GetProfiler()->BeginPass(*m_Profile, writes)) {
+            desc.timestampWrites = &writes;
+        }
+        m_ComputePass = m_Encoder.BeginComputePass(&desc);
+    }
+
+    void CommandList::NoteDispatch(const std::string& label) const {
+        if (m_Profile) {
+            m_Device.GetProfiler()->AddDispatch(*m_Profile, label);
+        }
     }
 
     void CommandList::EndComputePass() {
+        if (m_Capture) {
+            m_Capture->RecordEndPass();
+            return;
+        }
+        if (!m_ComputePass) {
+            return;
+        }
         m_ComputePass.End();
+        // No open pass from here on (see GetComputePass)
+        m_ComputePass = wgpu::ComputePassEncoder();
+    }
+
+    void CommandList::BeginCapture(CommandCapture& capture) {
+        capture.Reset();
+        m_Capture = &capture;
+    }
+
+    void CommandList::EndCapture() {
+        m_Capture = nullptr;
     }
 
     void CommandList::CopyBufferToBuffer(const Buffer& src, const Buffer& dst, size_t size) {
+        CopyBufferToBuffer(src, 0, dst, 0, size);
+    }
+
+    void CommandList::CopyBufferToBuffer(const Buffer& src, size_t srcOffset, const Buffer& dst, size_t dstOffset, size_t size) {
+        if (m_Capture) {
+            m_Capture->RecordCopy(src.GetNative(), src.GetOffset() + srcOffset, dst.GetNative(), dst.GetOffset() + dstOffset, size);
+            return;
+        }
+        if (!m_Encoder) {
+            return;
+        }
         m_Encoder.CopyBufferToBuffer(
-            src.GetNative(), 0,
-            dst.GetNative(), 0,
+            src.GetNative(), src.GetOffset() + srcOffset,
+            dst.GetNative(), dst.GetOffset() + dstOffset,
             size
         );
     }
 
     wgpu::CommandBuffer CommandList::Finish() {
+        if (!m_Encoder) {
+            return {};
+        }
+        if (m_Capture) {
+            KRNL_WARN("CommandList::Finish while capturing; the captured commands are not in this command buffer");
+        }
+        if (m_Profile) {
+            m_Device.GetProfiler()->ResolveList(*m_Profile, m_Encoder);
+        }
         return m_Encoder.Finish();
     }
 
     void CommandList::Submit() {
-        auto cmd = Finish();
-        wgpu::Queue queue = m_Device.getQueue();
-        queue.Submit(1, &cmd);
+        if (!m_Encoder) {
+            return;
+        }
+        // Batched uploads recorded before this submit must land before it runs
+        m_Device.GetUploadBatch().Flush();
+        // Deferred: goes out with the next batch of the device's submission queue
+        wgpu::CommandBuffer cmd = Finish();
+        m_Device.GetSubmitQueue().Enqueue(std::move(cmd), m_Profile ? m_Device.GetProfiler()->OnSubmitted(m_Profile) : nullptr);
+    }
+
+    void CommandList::Submit(SubmitQueue::Ticket ticket) {
+        if (!m_Encoder) {
+            return;
+        }
+        // The upload copies are enqueued untracked, ahead of this ticket
+        m_Device.GetUploadBatch().Flush();
+        wgpu::CommandBuffer cmd = Finish();
+        m_Device.GetSubmitQueue().Enqueue(ticket, std::move(cmd), m_Profile ? m_Device.GetProfiler()->OnSubmitted(m_Profile) : nullptr);
     }
 
 } // namespace krnl
@@ -1,38 +1,215 @@
 #include "core/device.hpp"
 #include "core/log.h"
 
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef KRNL_DAWN_VERSION
+#define KRNL_DAWN_VERSION "unknown"
+#endif
+
 namespace krnl
 {
 
-	Device::Device(const Instance& instance)
+	namespace
 	{
-		wgpu::Adapter adapter;
-		wgpu::RequestAdapterOptions options{};
-		options.powerPreference = wgpu::PowerPreference::HighPerformance;
-		wgpu::Future f1 =
-			instance.GetNative().RequestAdapter(&options, wgpu::CallbackMode::WaitAnyOnly,
-				[&adapter](wgpu::RequestAdapterStatus status, wgpu::Adapter a,
-					wgpu::StringView message)
+		// Everything that can invalidate a cached blob: Dawn itself and the exact adapter/driver.
+		std::string makeIsolationKey(const wgpu::AdapterInfo& info)
+		{
+			std::string key = "dawn=" KRNL_DAWN_VERSION;
+			key += ";backend=" + std::to_string(static_cast<uint32_t>(info.backendType));
+			key += ";vendorID=" + std::to_string(info.vendorID);
+			key += ";deviceID=" + std::to_string(info.deviceID);
+			key += ";vendor=" + std::string(std::string_view(info.vendor));
+			key += ";arch=" + std::string(std::string_view(info.architecture));
+			key += ";device=" + std::string(std::string_view(info.device));
+			key += ";desc=" + std::string(std::string_view(info.description));
+			return key;
+		}
+
+		wgpu::Adapter requestAdapter(const Instance& instance, wgpu::PowerPreference preference, bool fallback, wgpu::BackendType backend)
+		{
+			wgpu::RequestAdapterOptions options{};
+			options.powerPreference = preference;
+			options.forceFallbackAdapter = fallback;
+			options.backendType = backend;
+
+			wgpu::Adapter adapter;
+			wgpu::Future f = instance.GetNative().RequestAdapter(&options, wgpu::CallbackMode::WaitAnyOnly,
+				[&adapter](wgpu::RequestAdapterStatus status, wgpu::Adapter a, wgpu::StringView message)
 				{
-					if (status != wgpu::RequestAdapterStatus::Success) {
-						KRNL_ERROR("RequestAdapter: " << message);
-						exit(0);
+					if (status != wgpu::RequestAdapterStatus::Success)
+					{
+						KRNL_WARN("RequestAdapter: " << message);
+						return;
 					}
-					adapter = std::move(a); });
+					adapter = std::move(a);
+				});
+			instance.WaitAny(f, UINT64_MAX);
+			return adapter;
+		}
+
+		AdapterDescription describe(const wgpu::AdapterInfo& info)
+		{
+			AdapterDescription d;
+			d.vendor = std::string(std::string_view(info.vendor));
+			d.architecture = std::string(std::string_view(info.architecture));
+			d.device = std::string(std::string_view(info.device));
+			d.description = std::string(std::string_view(info.description));
+			d.backendType = info.backendType;
+			d.adapterType = info.adapterType;
+			d.vendorID = info.vendorID;
+			d.deviceID = info.deviceID;
+			return d;
+		}
 
-		instance.WaitAny(f1, UINT64_MAX);
+		bool matches(const AdapterDescription& adapter, const DeviceOptions& options)
+		{
+			if (options.backendType != wgpu::BackendType::Undefined && adapter.backendType != options.backendType)
+				return false;
+			return !options.adapterType || adapter.adapterType == *options.adapterType;
+		}
 
-		wgpu::AdapterInfo adapterInfo;
-		adapter.GetInfo(&adapterInfo);
+		// First adapter that passes the backend/type filters, trying the other power
+		// preference when the requested one lands on an adapter of the wrong type
+		wgpu::Adapter selectAdapter(const Instance& instance, const DeviceOptions& options, AdapterDescription& description, std::string& isolationKey)
+		{
+			const bool fallback = options.forceFallbackAdapter ||
+				(options.adapterType && *options.adapterType == wgpu::AdapterType::CPU);
+			std::vector<wgpu::PowerPreference> preferences = { options.powerPreference };
+			if (options.adapterType && !fallback)
+			{
+				preferences.push_back(options.powerPreference == wgpu::PowerPreference::LowPower
+					? wgpu::PowerPreference::HighPerformance
+					: wgpu::PowerPreference::LowPower);
+			}
+
+			for (wgpu::PowerPreference preference : preferences)
+			{
+				wgpu::Adapter adapter = requestAdapter(instance, preference, fallback, options.backendType);
+				if (!adapter)
+					continue;
+				wgpu::AdapterInfo info;
+				adapter.GetInfo(&info);
+				AdapterDescription candidate = describe(info);
+				if (!matches(candidate, options))
+				{
+					KRNL_LOG("Skipping adapter " << candidate.description << " (backend " << candidate.backendType
+						<< ", type " << candidate.adapterType << ")");
+					continue;
+				}
+				description = std::move(candidate);
+				isolationKey = makeIsolationKey(info);
+				return adapter;
+			}
+			return wgpu::Adapter();
+		}
+
+		void addFeature(std::vector<wgpu::FeatureName>& features, wgpu::FeatureName feature)
+		{
+			if (std::find(features.begin(), features.end(), feature) == features.end())
+				features.push_back(feature);
+		}
+	}
+
+	Device::Device(const Instance& instance, const DeviceOptions& deviceOptions)
+	{
+		m_Instance = &instance;
+		std::string isolationKey;
+		wgpu::Adapter adapter = selectAdapter(instance, deviceOptions, m_Adapter, isolationKey);
+		m_AdapterKey = isolationKey;
+		if (!adapter)
+		{
+			KRNL_ERROR("No adapter matches the device options; the device is invalid");
+			return;
+		}
 
 		KRNL_LOG("GPU Adapter Info:");
-		KRNL_LOG("  Vendor: " << adapterInfo.vendor);
-		KRNL_LOG("  Architecture: " << adapterInfo.architecture);
-		KRNL_LOG("  Device: " << adapterInfo.device);
-		KRNL_LOG("  Description: " << adapterInfo.description);
-		KRNL_LOG("  Backend: " << adapterInfo.backendType);
+		KRNL_LOG("  Vendor: " << m_Adapter.vendor);
+		KRNL_LOG("  Architecture: " << m_Adapter.architecture);
+		KRNL_LOG("  Device: " << m_Adapter.device);
+		KRNL_LOG("  Description: " << m_Adapter.description);
+		KRNL_LOG("  Backend: " << m_Adapter.backendType);
+		KRNL_LOG("  Type: " << m_Adapter.adapterType);
 
 		wgpu::DeviceDescriptor desc{};
+
+		std::vector<wgpu::FeatureName> features;
+		for (wgpu::FeatureName feature : deviceOptions.requiredFeatures)
+		{
+			if (!adapter.HasFeature(feature))
+			{
+				KRNL_ERROR("Adapter lacks required feature " << feature << "; the device is invalid");
+				return;
+			}
+			addFeature(features, feature);
+		}
+		for (wgpu::FeatureName feature : deviceOptions.optionalFeatures)
+		{
+			if (adapter.HasFeature(feature))
+				addFeature(features, feature);
+			else
+				KRNL_LOG("Adapter lacks optional feature " << feature);
+		}
+#if !defined(__EMSCRIPTEN__)
+		if (deviceOptions.threadSafe)
+		{
+			if (adapter.HasFeature(wgpu::FeatureName::ImplicitDeviceSynchronization))
+			{
+				addFeature(features, wgpu::FeatureName::ImplicitDeviceSynchronization);
+				m_ThreadSafe = true;
+			}
+			else
+			{
+				KRNL_WARN("Adapter lacks ImplicitDeviceSynchronization; record CommandLists from one thread only");
+			}
+		}
+#endif
+		bool timestamps = false;
+		if (deviceOptions.enableProfiling)
+		{
+			if (adapter.HasFeature(wgpu::FeatureName::TimestampQuery))
+			{
+				addFeature(features, wgpu::FeatureName::TimestampQuery);
+				timestamps = true;
+			}
+			else
+			{
+				KRNL_WARN("Adapter lacks TimestampQuery; profiling falls back to host timing around submits");
+			}
+		}
+
+		desc.requiredFeatureCount = features.size();
+		desc.requiredFeatures = features.data();
+
+		wgpu::Limits adapterLimits{};
+		if (deviceOptions.requestAdapterLimits)
+		{
+			if (adapter.GetLimits(&adapterLimits) == wgpu::Status::Success)
+				desc.requiredLimits = &adapterLimits;
+			else
+				KRNL_WARN("Could not query adapter limits; using the WebGPU defaults");
+		}
+
+#if !defined(__EMSCRIPTEN__)
+		wgpu::DawnCacheDeviceDescriptor cacheDesc{};
+		if (deviceOptions.enableDiskCache)
+		{
+			std::filesystem::path root = deviceOptions.cacheDirectory.empty()
+				? DiskCache::DefaultRoot()
+				: deviceOptions.cacheDirectory;
+			m_DiskCache = std::make_unique<DiskCache>(root, isolationKey);
+
+			cacheDesc.isolationKey = isolationKey.c_str();
+			cacheDesc.loadDataFunction = &DiskCache::LoadCallback;
+			cacheDesc.storeDataFunction = &DiskCache::StoreCallback;
+			cacheDesc.functionUserdata = m_DiskCache.get();
+			desc.nextInChain = &cacheDesc;
+		}
+#endif
+
 		desc.SetUncapturedErrorCallback([](const wgpu::Device&,
 			wgpu::ErrorType errorType,
 			wgpu::StringView message)
@@ -57,15 +234,101 @@ namespace krnl
 				if (status != wgpu::RequestDeviceStatus::Success)
 				{
 					KRNL_ERROR("RequestDevice: " << message);
-					exit(0);
+					return;
 				}
 				this->m_Device = std::move(d);
 			});
 		instance.WaitAny(f2, UINT64_MAX);
+		if (!m_Device)
+		{
+			KRNL_ERROR("Device creation failed; the device is invalid");
+			m_DiskCache.reset();
+			return;
+		}
+
+		m_Device.GetLimits(&m_Limits);
+		wgpu::SupportedFeatures supported;
+		m_Device.GetFeatures(&supported);
+		m_Features.assign(supported.features, supported.features + supported.featureCount);
 
 		m_Queue = m_Device.GetQueue();
+		m_Metrics = std::make_shared<Metrics>();
+		m_PipelineCache = std::make_unique<PipelineCache>(m_Device);
+		m_Allocator = BufferAllocator::Create(m_Device);
+		m_Allocator->SetMetrics(m_Metrics);
+		m_SubmitQueue = std::make_unique<SubmitQueue>(m_Queue, deviceOptions.maxPendingSubmits);
+		if (deviceOptions.enableProfiling)
+		{
+			m_Profiler = std::make_unique<Profiler>(m_Device, m_Queue, timestamps);
+			m_SubmitQueue->setProfiler(m_Profiler.get());
+		}
+		m_StagingPool = std::make_unique<PersistentStagingPool>(m_Device);
+		m_StagingPool->setSubmitQueue(m_SubmitQueue.get());
+		m_StagingPool->setMetrics(m_Metrics);
+		m_UploadBatch = std::make_unique<UploadBatch>(*m_StagingPool, m_Queue);
 
 		KRNL_LOG("Device acquired successfully");
 	}
 
+	Metrics::Snapshot Device::GetMetricsSnapshot() const
+	{
+		if (!IsValid())
+			return {};
+		const SubmitQueue::Stats submits = m_SubmitQueue->GetStats();
+		Metrics::Snapshot s = m_Metrics->Collect(submits.submits);
+		s.commandBuffersSubmitted = submits.enqueued;
+
+		const PipelineCache::Stats pipelines = m_PipelineCache->GetStats();
+		s.pipelineCacheHits = pipelines.hits;
+		s.pipelineCacheMisses = pipelines.misses;
+		s.pipelineCacheEntries = pipelines.entries;
+		s.pipelineCacheHitRate = pipelines.hitRate();
+
+		const PersistentStagingPool::Stats staging = m_StagingPool->getStats();
+		auto ratio = [](uint64_t hits, uint64_t misses)
+			{
+				uint64_t total = hits + misses;
+				return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+			};
+		s.stagingReadyChunks = staging.freeChunks;
+		s.stagingInflightChunks = staging.inflightChunks;
+		s.stagingReadyBytes = staging.freeBytes;
+		s.stagingInflightBytes = staging.inflightBytes;
+		s.stagingUploads = staging.uploads;
+		s.stagingUploadBytes = staging.uploadBytes;
+		s.stagingReadbacks = staging.readbacks;
+		s.stagingChunkHitRate = ratio(staging.chunksRecycled, staging.chunksCreated);
+		s.stagingReadbackHitRate = ratio(staging.readbackBuffersReused, staging.readbackBuffersCreated);
+
+		const BufferAllocator::Stats allocator = m_Allocator->GetStats();
+		s.allocatorReservedBytes = allocator.reservedBytes;
+		s.allocatorUsedBytes = allocator.usedBytes;
+		s.allocatorLiveAllocations = allocator.liveAllocations;
+		return s;
+	}
+
+	bool Device::HasFeature(wgpu::FeatureName feature) const
+	{
+		return std::find(m_Features.begin(), m_Features.end(), feature) != m_Features.end();
+	}
+
+	void Device::Flush() const
+	{
+		if (!IsValid())
+			return;
+		m_UploadBatch->Flush();
+		m_SubmitQueue->Flush();
+	}
+
+	void Device::WaitIdle() const
+	{
+		if (!IsValid())
+			return;
+		Flush();
+		wgpu::Future f = m_Queue.OnSubmittedWorkDone(
+			wgpu::CallbackMode::WaitAnyOnly,
+			[](wgpu::QueueWorkDoneStatus, wgpu::StringView) {});
+		m_Instance->Wait(f);
+	}
+
 } // namespace krnl
\ No newline at end of file
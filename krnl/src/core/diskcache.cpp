@@ -0,0 +1,161 @@
+#include "core/diskcache.hpp"
+#include "core/hash.hpp"
+#include "core/log.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace krnl {
+
+    namespace {
+        std::string toHex(uint64_t v) {
+            static const char* digits = "0123456789abcdef";
+            std::string s(16, '0');
+            for (int i = 15; i >= 0; --i) {
+                s[i] = digits[v & 0xF];
+                v >>= 4;
+            }
+            return s;
+        }
+
+        // Entry layout: [uint64 keySize][key bytes][value bytes]. The key is stored so a
+        // hash collision reads as a miss instead of handing Dawn the wrong blob.
+        bool readEntry(const std::filesystem::path& path, const void* key, size_t keySize, std::vector<char>& out) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                return false;
+            }
+            uint64_t storedKeySize = 0;
+            if (!file.read(reinterpret_cast<char*>(&storedKeySize), sizeof(storedKeySize)) || storedKeySize != keySize) {
+                return false;
+            }
+            std::vector<char> storedKey(keySize);
+            if (!file.read(storedKey.data(), static_cast<std::streamsize>(keySize)) ||
+                std::memcmp(storedKey.data(), key, keySize) != 0) {
+                return false;
+            }
+            out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return true;
+        }
+    }
+
+    DiskCache::DiskCache(const std::filesystem::path& root, std::string isolationKey)
+        : m_IsolationKey(std::move(isolationKey))
+    {
+        m_Directory = root / toHex(HashString(m_IsolationKey));
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_Directory, ec);
+        if (ec) {
+            KRNL_WARN("DiskCache: cannot create " << m_Directory.string() << " (" << ec.message() << "), cache disabled");
+            return;
+        }
+        m_Usable = true;
+
+        // Record what this directory belongs to; purely informational.
+        std::ofstream info(m_Directory / "isolation_key.txt", std::ios::trunc);
+        info << m_IsolationKey << "\n";
+
+        KRNL_LOG("DiskCache: using " << m_Directory.string());
+    }
+
+    std::filesystem::path DiskCache::DefaultRoot() {
+        if (const char* env = std::getenv("KRNL_CACHE_DIR"); env && *env) {
+            return std::filesystem::path(env);
+        }
+        std::error_code ec;
+        std::filesystem::path tmp = std::filesystem::temp_directory_path(ec);
+        if (ec) {
+            tmp = ".";
+        }
+        return tmp / "krnl_cache";
+    }
+
+    std::filesystem::path DiskCache::entryPath(const void* key, size_t keySize) const {
+        return m_Directory / (toHex(HashBytes(key, keySize)) + ".bin");
+    }
+
+    size_t DiskCache::Load(const void* key, size_t keySize, void* value, size_t valueSize) {
+        if (!m_Usable) {
+            return 0;
+        }
+
+        std::vector<char> blob;
+        if (!readEntry(entryPath(key, keySize), key, keySize, blob)) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_Stats.misses;
+            return 0;
+        }
+
+        if (value && valueSize >= blob.size()) {
+            std::memcpy(value, blob.data(), blob.size());
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_Stats.loads;
+            m_Stats.bytesLoaded += blob.size();
+        }
+        return blob.size();
+    }
+
+    void DiskCache::Store(const void* key, size_t keySize, const void* value, size_t valueSize) {
+        if (!m_Usable) {
+            return;
+        }
+
+        std::filesystem::path path = entryPath(key, keySize);
+
+        // Write to a private temp file and rename, so concurrent processes sharing the
+        // directory never observe a half-written entry.
+        std::filesystem::path tmp;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            size_t tid = std::hash<std::thread::id>{}(std::this_thread::get_id());
+            tmp = path;
+            tmp += "." + toHex(HashCombine(tid, ++m_TempCounter)) + ".tmp";
+        }
+
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            uint64_t storedKeySize = keySize;
+            file.write(reinterpret_cast<const char*>(&storedKeySize), sizeof(storedKeySize));
+            file.write(static_cast<const char*>(key), static_cast<std::streamsize>(keySize));
+            file.write(static_cast<const char*>(value), static_cast<std::streamsize>(valueSize));
+            if (!file) {
+                KRNL_WARN("DiskCache: failed to write " << tmp.string());
+                std::error_code ec;
+                std::filesystem::remove(tmp, ec);
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            KRNL_WARN("DiskCache: failed to publish " << path.string() << " (" << ec.message() << ")");
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_Stats.stores;
+        m_Stats.bytesStored += valueSize;
+    }
+
+    size_t DiskCache::LoadCallback(const void* key, size_t keySize, void* value, size_t valueSize, void* userdata) {
+        return static_cast<DiskCache*>(userdata)->Load(key, keySize, value, valueSize);
+    }
+
+    void DiskCache::StoreCallback(const void* key, size_t keySize, const void* value, size_t valueSize, void* userdata) {
+        static_cast<DiskCache*>(userdata)->Store(key, keySize, value, valueSize);
+    }
+
+    DiskCache::Stats DiskCache::GetStats() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+} // namespace krnl
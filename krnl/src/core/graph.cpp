@@ -0,0 +1,321 @@
+#include "core/graph.hpp"
+#include "core/buffer.hpp"
+#include "core/commandlist.hpp"
+#include "core/device.hpp"
+#include "core/parameterset.hpp"
+#include "core/pipeline.hpp"
+#include "core/log.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <queue>
+
+namespace krnl {
+
+    bool ComputeGraph::Range::Overlaps(const Range& o) const {
+        return buffer.Get() == o.buffer.Get() && offset < o.offset + o.size && o.offset < offset + size;
+    }
+
+    bool ComputeGraph::Range::operator==(const Range& o) const {
+        return buffer.Get() == o.buffer.Get() && offset == o.offset && size == o.size;
+    }
+
+    ComputeGraph::ComputeGraph(const Device& device)
+        : ComputeGraph(device, Options{})
+    {
+    }
+
+    ComputeGraph::ComputeGraph(const Device& device, const Options& options)
+        : m_Device(device), m_Options(options)
+    {
+    }
+
+    ComputeGraph::Range ComputeGraph::rangeOf(const Buffer& buffer, size_t offset, size_t size) {
+        Range r;
+        r.buffer = buffer.GetNative();
+        r.offset = buffer.GetOffset() + offset;
+        r.size = size;
+        return r;
+    }
+
+    ComputeGraph::NodeId ComputeGraph::AddDispatch(const Pipeline& pipeline, uint32_t x, uint32_t y, uint32_t z,
+        const std::vector<const Buffer*>& reads, const std::vector<const Buffer*>& writes)
+    {
+        Node node;
+        node.kind = Kind::Dispatch;
+        node.pipeline = &pipeline;
+        node.groups[0] = x;
+        node.groups[1] = y;
+        node.groups[2] = z;
+        for (const Buffer* b : reads) {
+            node.reads.push_back(rangeOf(*b, 0, b->GetSize()));
+        }
+        for (const Buffer* b : writes) {
+            node.writes.push_back(rangeOf(*b, 0, b->GetSize()));
+        }
+        return addNode(std::move(node));
+    }
+
+    ComputeGraph::NodeId ComputeGraph::AddDispatch(const Pipeline& pipeline, uint32_t x, uint32_t y, uint32_t z) {
+        std::vector<const Buffer*> reads;
+        std::vector<const Buffer*> writes;
+        for (const ParameterSet::Entry& e : pipeline.getParams().entries()) {
+            reads.push_back(&e.buffer);
+            if (e.bindingType == BufferBindingType::Storage) {
+                writes.push_back(&e.buffer);
+            }
+        }
+        return AddDispatch(pipeline, x, y, z, reads, writes);
+    }
+
+    ComputeGraph::NodeId ComputeGraph::AddCopy(const Buffer& src, const Buffer& dst, size_t size) {
+        return AddCopy(src, 0, dst, 0, size);
+    }
+
+    ComputeGraph::NodeId ComputeGraph::AddCopy(const Buffer& src, size_t srcOffset, const Buffer& dst, size_t dstOffset, size_t size) {
+        Node node;
+        node.kind = Kind::Copy;
+        node.reads.push_back(rangeOf(src, srcOffset, size));
+        node.writes.push_back(rangeOf(dst, dstOffset, size));
+        return addNode(std::move(node));
+    }
+
+    void ComputeGraph::AddDependency(NodeId before, NodeId after) {
+        if (before >= m_Nodes.size() || after >= m_Nodes.size() || before >= after) {
+            KRNL_ERROR("ComputeGraph::AddDependency: invalid edge " << before << " -> " << after);
+            return;
+        }
+        addEdge(before, after);
+        m_Nodes[after].explicitPredecessors.push_back(before);
+        m_Dirty = true;
+    }
+
+    void ComputeGraph::MarkOutput(const Buffer& buffer) {
+        m_Outputs.push_back(rangeOf(buffer, 0, buffer.GetSize()));
+        m_Dirty = true;
+    }
+
+    void ComputeGraph::Clear() {
+        m_Nodes.clear();
+        m_Outputs.clear();
+        m_Order.clear();
+        m_Dirty = true;
+    }
+
+    ComputeGraph::NodeId ComputeGraph::addNode(Node node) {
+        const NodeId id = static_cast<NodeId>(m_Nodes.size());
+        m_Nodes.push_back(std::move(node));
+        const Node& n = m_Nodes.back();
+
+        auto overlapsAny = [](const std::vector<Range>& a, const std::vector<Range>& b) {
+            for (const Range& x : a) {
+                for (const Range& y : b) {
+                    if (x.Overlaps(y)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        };
+
+        // Hazards against every earlier node, in insertion order
+        for (NodeId prev = 0; prev < id; ++prev) {
+            const Node& p = m_Nodes[prev];
+            if (overlapsAny(p.writes, n.reads) || overlapsAny(p.writes, n.writes) || overlapsAny(p.reads, n.writes)) {
+                addEdge(prev, id);
+            }
+        }
+        m_Dirty = true;
+        return id;
+    }
+
+    void ComputeGraph::addEdge(NodeId before, NodeId after) {
+        auto& succ = m_Nodes[before].successors;
+        if (std::find(succ.begin(), succ.end(), after) != succ.end()) {
+            return;
+        }
+        succ.push_back(after);
+        m_Nodes[after].predecessors.push_back(before);
+    }
+
+    void ComputeGraph::schedule() {
+        const NodeId count = static_cast<NodeId>(m_Nodes.size());
+        m_Scheduled = Stats{};
+        m_Scheduled.nodes = count;
+        m_Order.clear();
+
+        // Liveness: everything, or what feeds a declared output. A predecessor is kept if the
+        // node reads something it wrote; pure write-after-read edges carry no data.
+        std::vector<bool> live(count, m_Outputs.empty());
+        if (!m_Outputs.empty()) {
+            std::vector<NodeId> work;
+            for (NodeId id = 0; id < count; ++id) {
+                for (const Range& w : m_Nodes[id].writes) {
+                    for (const Range& out : m_Outputs) {
+                        if (!live[id] && w.Overlaps(out)) {
+                            live[id] = true;
+                            work.push_back(id);
+                        }
+                    }
+                }
+            }
+            while (!work.empty()) {
+                const Node& n = m_Nodes[work.back()];
+                work.pop_back();
+                for (NodeId p : n.predecessors) {
+                    if (live[p]) {
+                        continue;
+                    }
+                    bool feeds = false;
+                    for (const Range& w : m_Nodes[p].writes) {
+                        for (const Range& r : n.reads) {
+                            feeds |= w.Overlaps(r);
+                        }
+                        // Partially overwritten data can still reach the output
+                        for (const Range& w2 : n.writes) {
+                            feeds |= w.Overlaps(w2);
+                        }
+                    }
+                    // Explicit dependencies have no accesses to go by; keep them
+                    const auto& ex = n.explicitPredecessors;
+                    if (feeds || std::find(ex.begin(), ex.end(), p) != ex.end()) {
+                        live[p] = true;
+                        work.push_back(p);
+                    }
+                }
+            }
+        }
+
+        // Kahn's algorithm over live nodes, one ready queue per kind (lowest id first)
+        std::vector<uint32_t> indegree(count, 0);
+        for (NodeId id = 0; id < count; ++id) {
+            if (!live[id]) {
+                m_Scheduled.culledNodes++;
+                continue;
+            }
+            for (NodeId s : m_Nodes[id].successors) {
+                if (live[s]) {
+                    indegree[s]++;
+                    m_Scheduled.edges++;
+                }
+            }
+        }
+
+        using ReadyQueue = std::priority_queue<NodeId, std::vector<NodeId>, std::greater<NodeId>>;
+        ReadyQueue readyDispatch;
+        ReadyQueue readyCopy;
+        auto push = [&](NodeId id) {
+            (m_Nodes[id].kind == Kind::Dispatch ? readyDispatch : readyCopy).push(id);
+        };
+        for (NodeId id = 0; id < count; ++id) {
+            if (live[id] && indegree[id] == 0) {
+                push(id);
+            }
+        }
+
+        // Stay in the current kind while possible: dispatches keep the compute pass open,
+        // copies are drained together between passes
+        std::vector<NodeId> order;
+        bool inPass = false;
+        while (!readyDispatch.empty() || !readyCopy.empty()) {
+            bool takeDispatch = inPass ? !readyDispatch.empty() : readyCopy.empty();
+            ReadyQueue& q = takeDispatch ? readyDispatch : readyCopy;
+            NodeId id = q.top();
+            q.pop();
+            inPass = takeDispatch;
+            order.push_back(id);
+            for (NodeId s : m_Nodes[id].successors) {
+                if (live[s] && --indegree[s] == 0) {
+                    push(s);
+                }
+            }
+        }
+
+        // Drop copies that repeat an earlier one when neither side was written in between
+        std::vector<const Node*> liveCopies;
+        for (NodeId id : order) {
+            const Node& n = m_Nodes[id];
+            if (n.kind == Kind::Copy) {
+                bool repeat = std::any_of(liveCopies.begin(), liveCopies.end(), [&](const Node* c) {
+                    return c->reads[0] == n.reads[0] && c->writes[0] == n.writes[0];
+                });
+                if (repeat) {
+                    m_Scheduled.redundantCopies++;
+                    continue;
+                }
+            }
+            for (const Range& w : n.writes) {
+                liveCopies.erase(std::remove_if(liveCopies.begin(), liveCopies.end(), [&](const Node* c) {
+                    return c->reads[0].Overlaps(w) || c->writes[0].Overlaps(w);
+                }), liveCopies.end());
+            }
+            if (n.kind == Kind::Copy) {
+                liveCopies.push_back(&n);
+            }
+            m_Order.push_back(id);
+        }
+
+        m_Scheduled.executed = static_cast<uint32_t>(m_Order.size());
+        m_Dirty = false;
+    }
+
+    ComputeGraph::Stats ComputeGraph::Execute() {
+        if (m_Dirty) {
+            schedule();
+        }
+        Stats stats = m_Scheduled;
+
+        std::unique_ptr<CommandList> cmd;
+        bool inPass = false;
+        uint32_t recorded = 0;
+
+        auto submit = [&]() {
+            if (!cmd) {
+                return;
+            }
+            if (inPass) {
+                cmd->EndComputePass();
+                inPass = false;
+            }
+            cmd->Submit();
+            stats.commandBuffers++;
+            if (m_Options.submitEarly) {
+                m_Device.GetSubmitQueue().Flush();
+            }
+            cmd.reset();
+            recorded = 0;
+        };
+
+        for (NodeId id : m_Order) {
+            if (!cmd) {
+                cmd = std::make_unique<CommandList>(m_Device);
+            }
+            const Node& n = m_Nodes[id];
+            if (n.kind == Kind::Dispatch) {
+                if (!inPass) {
+                    cmd->BeginComputePass();
+                    inPass = true;
+                    stats.computePasses++;
+                }
+                n.pipeline->encodeDispatch(*cmd, n.groups[0], n.groups[1], n.groups[2]);
+            }
+            else {
+                if (inPass) {
+                    cmd->EndComputePass();
+                    inPass = false;
+                }
+                const Range& src = n.reads[0];
+                const Range& dst = n.writes[0];
+                cmd->GetEncoder().CopyBufferToBuffer(src.buffer, src.offset, dst.buffer, dst.offset, src.size);
+            }
+
+            if (m_Options.nodesPerCommandBuffer != 0 && ++recorded >= m_Options.nodesPerCommandBuffer) {
+                submit();
+            }
+        }
+        submit();
+        return stats;
+    }
+
+} // namespace krnl
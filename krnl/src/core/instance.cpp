@@ -2,12 +2,162 @@
 #include "core/device.hpp"
 #include "core/log.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace krnl
 {
 
-    Instance::Instance()
+    namespace
+    {
+        // Timed WaitAny accepts a bounded number of futures per call (timedWaitAnyMaxCount)
+        constexpr size_t kMaxWaitBatch = 64;
+
+        // WaitAny takes nanoseconds
+        uint64_t toNanoseconds(uint64_t ms)
+        {
+            constexpr uint64_t kNsPerMs = 1'000'000;
+            return ms > UINT64_MAX / kNsPerMs ? UINT64_MAX : ms * kNsPerMs;
+        }
+    }
+
+    /**
+     * Futures somebody waits on or has attached tasks to, keyed by future id. Completion is
+     * detected by whoever calls WaitAny on them: the pump thread, or Wait()/ProcessEvents()
+     * when there is no pump.
+     */
+    struct InstanceImpl
+    {
+        struct Tracked
+        {
+            wgpu::Future future;
+            std::vector<std::function<void()>> tasks;
+        };
+
+        wgpu::Instance instance;
+        InstanceOptions options;
+
+        std::mutex mutex;
+        std::condition_variable wake;       // pump: new future to watch, or stop
+        std::unordered_map<uint64_t, Tracked> tracked;
+        size_t pollStart = 0;               // where the next batch starts when there are more than kMaxWaitBatch
+        bool stop = false;
+        std::thread pump;
+
+        bool hasPending() const
+        {
+            return !tracked.empty();
+        }
+
+        // Stop tracking a completed future and hand back its tasks. Blocked waiters sleep on
+        // their own state, which one of the tasks completes. Called with the lock held.
+        std::vector<std::function<void()>> complete(uint64_t id)
+        {
+            std::vector<std::function<void()>> tasks;
+            auto it = tracked.find(id);
+            if (it == tracked.end())
+                return tasks;
+            tasks = std::move(it->second.tasks);
+            tracked.erase(it);
+            return tasks;
+        }
+
+        void run(std::vector<std::function<void()>>& tasks)
+        {
+            for (auto& task : tasks)
+            {
+                if (options.executor)
+                    options.executor(std::move(task));
+                else
+                    task();
+            }
+            tasks.clear();
+        }
+
+        // One WaitAny round over up to kMaxWaitBatch tracked futures, rotating through them
+        // so none starves; runs the tasks of those that completed. False if WaitAny failed.
+        bool poll(uint64_t timeoutNs)
+        {
+            std::vector<wgpu::FutureWaitInfo> infos;
+            {
+                std::lock_guard<std::mutex> l(mutex);
+                if (tracked.empty())
+                    return true;
+                const size_t start = pollStart % tracked.size();
+                const size_t count = std::min(tracked.size(), kMaxWaitBatch);
+                auto it = std::next(tracked.begin(), start);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (it == tracked.end())
+                        it = tracked.begin();
+                    infos.push_back({ .future = it->second.future, .completed = false });
+                    ++it;
+                }
+                pollStart = start + count;
+            }
+
+            wgpu::WaitStatus status = instance.WaitAny(infos.size(), infos.data(), timeoutNs);
+            if (status != wgpu::WaitStatus::Success && status != wgpu::WaitStatus::TimedOut)
+            {
+                KRNL_WARN("Instance: WaitAny returned " << static_cast<uint32_t>(status));
+                return false;
+            }
+
+            std::vector<std::function<void()>> tasks;
+            {
+                std::lock_guard<std::mutex> l(mutex);
+                for (const auto& info : infos)
+                {
+                    if (!info.completed)
+                        continue;
+                    auto done = complete(info.future.id);
+                    std::move(done.begin(), done.end(), std::back_inserter(tasks));
+                }
+            }
+            run(tasks);
+            return true;
+        }
+
+        void pumpLoop()
+        {
+            const uint64_t sliceNs = toNanoseconds(std::max<uint32_t>(options.waitSliceMs, 1));
+            std::unique_lock<std::mutex> l(mutex);
+            while (!stop)
+            {
+                if (!hasPending())
+                {
+                    l.unlock();
+                    instance.ProcessEvents();
+                    l.lock();
+                    auto ready = [this] { return stop || hasPending(); };
+                    if (options.pollIntervalMs)
+                        wake.wait_for(l, std::chrono::milliseconds(options.pollIntervalMs), ready);
+                    else
+                        wake.wait(l, ready);
+                    continue;
+                }
+
+                // WaitAny sleeps in the backend until a tracked future completes or the slice ends
+                l.unlock();
+                const bool polled = poll(sliceNs);
+                instance.ProcessEvents();
+                l.lock();
+                if (!polled)
+                {
+                    // WaitAny fails straight away; back off for a slice instead of spinning
+                    wake.wait_for(l, std::chrono::nanoseconds(sliceNs), [this] { return stop; });
+                }
+            }
+        }
+    };
+
+    Instance::Instance(const InstanceOptions& options)
     {
         const auto kTimedWaitAny = wgpu::InstanceFeatureName::TimedWaitAny;
         wgpu::InstanceDescriptor desc = {.requiredFeatureCount = 1,
@@ -20,11 +170,149 @@ namespace krnl
             std::exit(EXIT_FAILURE);
         }
 
+        m_Impl = std::make_unique<InstanceImpl>();
+        m_Impl->instance = m_Instance;
+        m_Impl->options = options;
+        if (options.eventPump)
+        {
+            InstanceImpl* impl = m_Impl.get();
+            m_Impl->pump = std::thread([impl] { impl->pumpLoop(); });
+        }
+
         KRNL_LOG("Instance created successfully");
     }
 
     Instance::~Instance()
     {
+        if (m_Impl && m_Impl->pump.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> l(m_Impl->mutex);
+                m_Impl->stop = true;
+            }
+            m_Impl->wake.notify_all();
+            m_Impl->pump.join();
+        }
+    }
+
+    bool Instance::HasEventPump() const
+    {
+        return m_Impl->pump.joinable();
     }
 
+    void Instance::ProcessEvents() const
+    {
+        m_Instance.ProcessEvents();
+        if (!HasEventPump())
+            m_Impl->poll(0);
+    }
+
+    void Instance::post(std::function<void()> task) const
+    {
+        std::vector<std::function<void()>> tasks{ std::move(task) };
+        m_Impl->run(tasks);
+    }
+
+    namespace detail
+    {
+        namespace
+        {
+            // Unfinished states with a native future somewhere under state
+            void collectLeaves(const std::shared_ptr<FutureStateBase>& state, std::vector<std::shared_ptr<FutureStateBase>>& out)
+            {
+                std::vector<std::shared_ptr<FutureStateBase>> deps;
+                {
+                    std::lock_guard<std::mutex> l(state->mutex);
+                    if (state->ready)
+                        return;
+                    deps = state->deps;
+                }
+                if (state->native.id != 0 && std::find(out.begin(), out.end(), state) == out.end())
+                    out.push_back(state);
+                for (const auto& d : deps)
+                    collectLeaves(d, out);
+            }
+        }
+
+        void RegisterNative(const Instance& instance, const std::shared_ptr<FutureStateBase>& state)
+        {
+            if (state->native.id == 0 || state->registered.exchange(true))
+                return;
+
+            InstanceImpl& impl = *instance.m_Impl;
+            std::lock_guard<std::mutex> l(impl.mutex);
+            auto [it, inserted] = impl.tracked.try_emplace(state->native.id);
+            if (inserted)
+                it->second.future = state->native;
+            it->second.tasks.push_back([state] { state->SetReady(); });
+            impl.wake.notify_one();
+        }
+
+        bool WaitState(const Instance& instance, const std::shared_ptr<FutureStateBase>& state, uint64_t timeoutMs)
+        {
+            using Clock = std::chrono::steady_clock;
+            InstanceImpl& impl = *instance.m_Impl;
+
+            const bool forever = timeoutMs == UINT64_MAX;
+            const Clock::time_point deadline = forever ? Clock::time_point::max()
+                : Clock::now() + std::chrono::milliseconds(std::min<uint64_t>(timeoutMs, 1ull << 40));
+            // How often a sleeping waiter re-checks for dependencies that appeared meanwhile
+            const auto recheck = std::chrono::milliseconds(
+                std::max<uint32_t>(impl.options.pollIntervalMs, impl.options.waitSliceMs) + 1);
+
+            std::vector<std::shared_ptr<FutureStateBase>> leaves;
+            while (!state->IsReady())
+            {
+                Clock::time_point now = Clock::now();
+                if (now >= deadline)
+                    return false;
+
+                leaves.clear();
+                collectLeaves(state, leaves);
+                for (const auto& leaf : leaves)
+                    RegisterNative(instance, leaf);
+
+                if (instance.HasEventPump() || leaves.empty())
+                {
+                    // The pump (or a continuation on another thread) completes it; just sleep
+                    std::unique_lock<std::mutex> l(state->mutex);
+                    auto until = std::min(deadline, now + recheck);
+                    state->cv.wait_until(l, until, [&] { return state->ready; });
+                    continue;
+                }
+
+                // No pump: this thread drives WaitAny over the native futures
+                std::vector<wgpu::FutureWaitInfo> infos;
+                for (const auto& leaf : leaves)
+                {
+                    infos.push_back({ .future = leaf->native, .completed = false });
+                    if (infos.size() == kMaxWaitBatch)
+                        break;
+                }
+                uint64_t timeoutNs = forever ? UINT64_MAX
+                    : static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count());
+                wgpu::WaitStatus status = impl.instance.WaitAny(infos.size(), infos.data(), timeoutNs);
+                if (status != wgpu::WaitStatus::Success && status != wgpu::WaitStatus::TimedOut)
+                {
+                    KRNL_WARN("Instance::Wait: WaitAny returned " << static_cast<uint32_t>(status));
+                    return state->IsReady();
+                }
+
+                std::vector<std::function<void()>> tasks;
+                {
+                    std::lock_guard<std::mutex> l(impl.mutex);
+                    for (const auto& info : infos)
+                    {
+                        if (!info.completed)
+                            continue;
+                        auto done = impl.complete(info.future.id);
+                        std::move(done.begin(), done.end(), std::back_inserter(tasks));
+                    }
+                }
+                impl.run(tasks);
+            }
+            return true;
+        }
+    } // namespace detail
+
 } // namespace krnl
@@ -0,0 +1,299 @@
+#include "core/log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace krnl::log {
+
+    namespace detail {
+        std::atomic<uint8_t> g_Level{ static_cast<uint8_t>(Level::Debug) };
+    }
+
+    namespace {
+
+        using detail::Arg;
+        using detail::Record;
+
+        constexpr size_t kCapacity = 4096;     // records; a power of two
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+        // No threads to write from: log synchronously
+        constexpr bool kAsync = false;
+#else
+        constexpr bool kAsync = true;
+#endif
+
+        // Trivially destructible, so they stay usable while other statics are torn down
+        std::atomic<FILE*> g_Output{ nullptr };
+        std::atomic<uint64_t> g_Dropped{ 0 };
+        std::atomic<bool> g_ShutDown{ false };
+
+        template<typename T>
+        T read(const unsigned char*& p) {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+        }
+
+        void format(const Record& r, std::string& out) {
+            switch (r.level) {
+            case Level::Debug: out += KRNL_COLOR_GREEN "[KRNL] "; break;
+            case Level::Warn: out += KRNL_COLOR_YELLOW "[KRNL-WARN] "; break;
+            default: out += KRNL_COLOR_RED "[KRNL-ERROR] "; break;
+            }
+            out += r.file;
+            out += ':';
+            out += std::to_string(r.line);
+            out += ": ";
+
+            char buf[32];
+            const unsigned char* p = r.payload;
+            const unsigned char* end = r.payload + r.size;
+            while (p < end) {
+                switch (static_cast<Arg>(*p++)) {
+                case Arg::Str: {
+                    uint16_t n = read<uint16_t>(p);
+                    out.append(reinterpret_cast<const char*>(p), n);
+                    p += n;
+                    break;
+                }
+                case Arg::I64:
+                    out += std::to_string(read<int64_t>(p));
+                    break;
+                case Arg::U64:
+                    out += std::to_string(read<uint64_t>(p));
+                    break;
+                case Arg::F64:
+                    std::snprintf(buf, sizeof(buf), "%g", read<double>(p));
+                    out += buf;
+                    break;
+                case Arg::Char:
+                    out += static_cast<char>(*p++);
+                    break;
+                case Arg::Bool:
+                    out += *p++ ? "1" : "0";
+                    break;
+                case Arg::Ptr:
+                    std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(read<uint64_t>(p)));
+                    out += buf;
+                    break;
+                }
+            }
+            if (r.truncated) {
+                out += " [...]";
+            }
+            out += KRNL_COLOR_RESET "\n";
+        }
+
+        FILE* outputFor(Level level) {
+            if (FILE* f = g_Output.load(std::memory_order_relaxed)) {
+                return f;
+            }
+            return level == Level::Debug ? stdout : stderr;
+        }
+
+        void writeNow(const Record& r) {
+            std::string line;
+            format(r, line);
+            FILE* f = outputFor(r.level);
+            std::fwrite(line.data(), 1, line.size(), f);
+            std::fflush(f);
+        }
+
+        // Bounded MPSC ring (Vyukov): producers claim a cell with one CAS, the writer thread
+        // is the only consumer
+        class Logger {
+        public:
+            Logger() {
+                for (size_t i = 0; i < kCapacity; ++i) {
+                    m_Cells[i].seq.store(i, std::memory_order_relaxed);
+                }
+                m_Thread = std::thread([this] { run(); });
+            }
+
+            bool TryPush(const Record& r) {
+                size_t pos = m_Head.load(std::memory_order_relaxed);
+                for (;;) {
+                    Cell& cell = m_Cells[pos & (kCapacity - 1)];
+                    size_t seq = cell.seq.load(std::memory_order_acquire);
+                    intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                    if (diff == 0) {
+                        if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            // Only the used part of the payload
+                            std::memcpy(&cell.record, &r, offsetof(Record, payload) + r.size);
+                            cell.seq.store(pos + 1, std::memory_order_release);
+                            break;
+                        }
+                    }
+                    else if (diff < 0) {
+                        return false;
+                    }
+                    else {
+                        pos = m_Head.load(std::memory_order_relaxed);
+                    }
+                }
+                if (m_Sleeping.load(std::memory_order_relaxed) || r.level == Level::Error) {
+                    m_Wake.notify_one();
+                }
+                return true;
+            }
+
+            void Flush() {
+                const size_t target = m_Head.load(std::memory_order_acquire);
+                while (m_Written.load(std::memory_order_acquire) < target && !m_Stop.load()) {
+                    m_Wake.notify_one();
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+
+            void Stop() {
+                {
+                    std::lock_guard<std::mutex> l(m_Mutex);
+                    m_Stop = true;
+                }
+                m_Wake.notify_one();
+                if (m_Thread.joinable()) {
+                    m_Thread.join();
+                }
+            }
+
+        private:
+            struct Cell {
+                std::atomic<size_t> seq;
+                Record record;
+            };
+
+            void writeBatch(std::string& batch) {
+                if (!batch.empty() && m_BatchFile) {
+                    std::fwrite(batch.data(), 1, batch.size(), m_BatchFile);
+                    std::fflush(m_BatchFile);
+                }
+                batch.clear();
+            }
+
+            // Write out every committed record, one fwrite per run of records with the same
+            // destination; returns false if there were none
+            bool drain(std::string& batch) {
+                bool any = false;
+                for (;;) {
+                    Cell& cell = m_Cells[m_Tail & (kCapacity - 1)];
+                    if (cell.seq.load(std::memory_order_acquire) != m_Tail + 1) {
+                        break;
+                    }
+                    FILE* f = outputFor(cell.record.level);
+                    if (f != m_BatchFile || batch.size() > 16384) {
+                        writeBatch(batch);
+                        m_BatchFile = f;
+                    }
+                    format(cell.record, batch);
+                    cell.seq.store(m_Tail + kCapacity, std::memory_order_release);
+                    m_Tail++;
+                    any = true;
+                }
+                writeBatch(batch);
+                m_Written.store(m_Tail, std::memory_order_release);
+                return any;
+            }
+
+            void run() {
+                std::string batch;
+                for (;;) {
+                    if (drain(batch)) {
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> l(m_Mutex);
+                    if (m_Stop) {
+                        break;
+                    }
+                    m_Sleeping.store(true, std::memory_order_relaxed);
+                    // The timeout covers a producer that missed the sleeping flag
+                    m_Wake.wait_for(l, std::chrono::milliseconds(20));
+                    m_Sleeping.store(false, std::memory_order_relaxed);
+                }
+                drain(batch);
+            }
+
+            Cell m_Cells[kCapacity];
+            alignas(64) std::atomic<size_t> m_Head{ 0 };
+            alignas(64) size_t m_Tail = 0;
+            std::atomic<size_t> m_Written{ 0 };
+            FILE* m_BatchFile = nullptr;
+
+            std::mutex m_Mutex;
+            std::condition_variable m_Wake;
+            std::atomic<bool> m_Sleeping{ false };
+            std::atomic<bool> m_Stop{ false };
+            std::thread m_Thread;
+        };
+
+        std::mutex g_StartMutex;
+        Logger* g_Logger = nullptr;     // intentionally never freed
+
+        Logger* logger() {
+            static Logger* instance = [] {
+                std::lock_guard<std::mutex> l(g_StartMutex);
+                g_Logger = new Logger();
+                return g_Logger;
+            }();
+            return instance;
+        }
+
+        // Drains and stops the writer when static objects are destroyed (including exit())
+        struct ShutdownGuard {
+            ~ShutdownGuard() {
+                // Later messages are written synchronously; Stop drains the ring
+                g_ShutDown = true;
+                std::lock_guard<std::mutex> l(g_StartMutex);
+                if (g_Logger) {
+                    g_Logger->Stop();
+                }
+            }
+        } g_ShutdownGuard;
+
+    } // namespace
+
+    namespace detail {
+        void Submit(const Record& record) {
+            if (!kAsync || g_ShutDown.load(std::memory_order_relaxed)) {
+                writeNow(record);
+                return;
+            }
+            if (logger()->TryPush(record)) {
+                return;
+            }
+            if (record.level == Level::Error) {
+                writeNow(record);
+                return;
+            }
+            g_Dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void SetLevel(Level level) {
+        detail::g_Level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    Level GetLevel() {
+        return static_cast<Level>(detail::g_Level.load(std::memory_order_relaxed));
+    }
+
+    void SetOutput(FILE* file) {
+        Flush();
+        g_Output.store(file, std::memory_order_relaxed);
+    }
+
+    void Flush() {
+        if (kAsync && !g_ShutDown.load()) {
+            logger()->Flush();
+        }
+    }
+
+    uint64_t DroppedCount() {
+        return g_Dropped.load(std::memory_order_relaxed);
+    }
+
+} // namespace krnl::log
@@ -0,0 +1,42 @@
+#include "core/mappedview.hpp"
+#include <utility>
+
+namespace krnl {
+
+    MappedView::MappedView(wgpu::Buffer buffer, void* data, size_t size, bool writable)
+        : m_Buffer(std::move(buffer)), m_Data(data), m_Size(size), m_Writable(writable) {
+    }
+
+    MappedView::~MappedView() {
+        Unmap();
+    }
+
+    MappedView::MappedView(MappedView&& other) noexcept
+        : m_Buffer(std::move(other.m_Buffer)),
+          m_Data(std::exchange(other.m_Data, nullptr)),
+          m_Size(std::exchange(other.m_Size, 0)),
+          m_Writable(std::exchange(other.m_Writable, false)) {
+    }
+
+    MappedView& MappedView::operator=(MappedView&& other) noexcept {
+        if (this != &other) {
+            Unmap();
+            m_Buffer = std::move(other.m_Buffer);
+            m_Data = std::exchange(other.m_Data, nullptr);
+            m_Size = std::exchange(other.m_Size, 0);
+            m_Writable = std::exchange(other.m_Writable, false);
+        }
+        return *this;
+    }
+
+    void MappedView::Unmap() {
+        if (m_Data && m_Buffer) {
+            m_Buffer.Unmap();
+        }
+        m_Buffer = wgpu::Buffer();
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Writable = false;
+    }
+
+} // namespace krnl
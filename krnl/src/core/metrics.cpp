@@ -0,0 +1,166 @@
+#include "core/metrics.hpp"
+
+#include <algorithm>
+
+namespace krnl {
+
+    uint64_t Metrics::Histogram::PercentileUs(double p) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return i < boundsUs.size() ? std::min(boundsUs[i], maxUs) : maxUs;
+            }
+        }
+        return maxUs;
+    }
+
+    Metrics::GpuMemory::GpuMemory(std::shared_ptr<Metrics> metrics, uint64_t bytes)
+        : m_Metrics(std::move(metrics)), m_Bytes(bytes)
+    {
+        uint64_t now = m_Metrics->m_GpuBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        uint64_t high = m_Metrics->m_GpuHighWater.load(std::memory_order_relaxed);
+        while (now > high && !m_Metrics->m_GpuHighWater.compare_exchange_weak(high, now, std::memory_order_relaxed)) {
+        }
+    }
+
+    Metrics::GpuMemory::~GpuMemory() {
+        reset();
+    }
+
+    Metrics::GpuMemory::GpuMemory(GpuMemory&& other) noexcept
+        : m_Metrics(std::move(other.m_Metrics)), m_Bytes(other.m_Bytes)
+    {
+        other.m_Bytes = 0;
+    }
+
+    Metrics::GpuMemory& Metrics::GpuMemory::operator=(GpuMemory&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_Metrics = std::move(other.m_Metrics);
+            m_Bytes = other.m_Bytes;
+            other.m_Bytes = 0;
+        }
+        return *this;
+    }
+
+    void Metrics::GpuMemory::reset() {
+        if (m_Metrics) {
+            m_Metrics->m_GpuBytes.fetch_sub(m_Bytes, std::memory_order_relaxed);
+            m_Metrics.reset();
+        }
+        m_Bytes = 0;
+    }
+
+    Metrics::LiveBuffer::LiveBuffer(std::shared_ptr<Metrics> metrics, const std::string& label, uint64_t bytes, bool ownsMemory)
+        : m_Metrics(std::move(metrics)), m_Bytes(bytes)
+    {
+        if (ownsMemory) {
+            m_Memory = GpuMemory(m_Metrics, bytes);
+        }
+        std::lock_guard<std::mutex> lock(m_Metrics->m_Mutex);
+        LabelStats& entry = m_Metrics->m_Buffers[label];
+        if (entry.count == 0) {
+            entry.label = label;
+        }
+        entry.count++;
+        entry.bytes += bytes;
+        m_Entry = &entry;
+        m_Metrics->m_LiveBuffers++;
+        m_Metrics->m_LiveBufferBytes += bytes;
+    }
+
+    Metrics::LiveBuffer::~LiveBuffer() {
+        std::lock_guard<std::mutex> lock(m_Metrics->m_Mutex);
+        m_Metrics->m_LiveBuffers--;
+        m_Metrics->m_LiveBufferBytes -= m_Bytes;
+        m_Entry->bytes -= m_Bytes;
+        if (--m_Entry->count == 0) {
+            // Keep the map bounded by live buffers when labels are unique
+            m_Metrics->m_Buffers.erase(m_Metrics->m_Buffers.find(m_Entry->label));
+        }
+    }
+
+    void Metrics::MapTimer::Stop() const {
+        if (!m_Metrics) {
+            return;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - m_Start;
+        m_Metrics->RecordMapWait(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    }
+
+    Metrics::Metrics()
+        : m_Created(std::chrono::steady_clock::now()), m_LastCollect(m_Created)
+    {
+    }
+
+    Metrics::GpuMemory Metrics::TrackGpuMemory(uint64_t bytes) {
+        return GpuMemory(shared_from_this(), bytes);
+    }
+
+    std::shared_ptr<Metrics::LiveBuffer> Metrics::TrackBuffer(const std::string& label, uint64_t bytes, bool ownsMemory) {
+        return std::make_shared<LiveBuffer>(shared_from_this(), label, bytes, ownsMemory);
+    }
+
+    void Metrics::RecordMapWait(uint64_t us) {
+        size_t bucket = std::lower_bound(kMapWaitBoundsUs.begin(), kMapWaitBoundsUs.end(), us) - kMapWaitBoundsUs.begin();
+        m_MapWaitCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+        m_MapWaitCount.fetch_add(1, std::memory_order_relaxed);
+        m_MapWaitSumUs.fetch_add(us, std::memory_order_relaxed);
+        uint64_t max = m_MapWaitMaxUs.load(std::memory_order_relaxed);
+        while (us > max && !m_MapWaitMaxUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Metrics::ResetMapWait() {
+        for (auto& c : m_MapWaitCounts) {
+            c.store(0, std::memory_order_relaxed);
+        }
+        m_MapWaitCount.store(0, std::memory_order_relaxed);
+        m_MapWaitSumUs.store(0, std::memory_order_relaxed);
+        m_MapWaitMaxUs.store(0, std::memory_order_relaxed);
+    }
+
+    Metrics::Snapshot Metrics::Collect(uint64_t queueSubmits) {
+        Snapshot s;
+        auto now = std::chrono::steady_clock::now();
+        s.uptimeSeconds = std::chrono::duration<double>(now - m_Created).count();
+
+        s.gpuMemoryBytes = m_GpuBytes.load(std::memory_order_relaxed);
+        s.gpuMemoryHighWater = m_GpuHighWater.load(std::memory_order_relaxed);
+        s.queueSubmits = queueSubmits;
+
+        s.mapWait.boundsUs.assign(kMapWaitBoundsUs.begin(), kMapWaitBoundsUs.end());
+        s.mapWait.counts.reserve(kMapWaitBoundsUs.size() + 1);
+        for (const auto& c : m_MapWaitCounts) {
+            s.mapWait.counts.push_back(c.load(std::memory_order_relaxed));
+        }
+        s.mapWait.count = m_MapWaitCount.load(std::memory_order_relaxed);
+        s.mapWait.sumUs = m_MapWaitSumUs.load(std::memory_order_relaxed);
+        s.mapWait.maxUs = m_MapWaitMaxUs.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        double interval = std::chrono::duration<double>(now - m_LastCollect).count();
+        if (interval > 0.0 && queueSubmits >= m_LastSubmits) {
+            s.submitsPerSecond = static_cast<double>(queueSubmits - m_LastSubmits) / interval;
+        }
+        m_LastCollect = now;
+        m_LastSubmits = queueSubmits;
+
+        s.liveBuffers = m_LiveBuffers;
+        s.liveBufferBytes = m_LiveBufferBytes;
+        s.buffersByLabel.reserve(m_Buffers.size());
+        for (const auto& [label, entry] : m_Buffers) {
+            s.buffersByLabel.push_back(entry);
+        }
+        std::sort(s.buffersByLabel.begin(), s.buffersByLabel.end(), [](const LabelStats& a, const LabelStats& b) {
+            return a.bytes != b.bytes ? a.bytes > b.bytes : a.label < b.label;
+        });
+        return s;
+    }
+
+} // namespace krnl
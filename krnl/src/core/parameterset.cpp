@@ -1,4 +1,5 @@
 ﻿#include "core/parameterset.hpp"
+#include "core/hash.hpp"
 #include "core/log.h"
 #include <cassert>
 #include <vector>
@@ -16,24 +17,26 @@ namespace krnl {
         buildBindGroup();
     }
 
-    void ParameterSet::buildLayout() {
-        std::vector<wgpu::BindGroupLayoutEntry> layoutEntries;
-        layoutEntries.reserve(m_Entries.size());
+    wgpu::BindGroup ParameterSet::bindGroup() const {
+        std::lock_guard<std::mutex> l(m_Mutex);
+        return m_BindGroup;
+    }
 
-        for (uint32_t i = 0; i < m_Entries.size(); ++i) {
-            const Entry& e = m_Entries[i];
-            assert(&e.buffer != nullptr && "ParameterSet entry buffer must not be null");
+    wgpu::BindGroupLayout ParameterSet::CreateLayout(const Device& device, const std::vector<BufferBindingType>& bindings) {
+        std::vector<wgpu::BindGroupLayoutEntry> layoutEntries;
+        layoutEntries.reserve(bindings.size());
 
+        for (uint32_t i = 0; i < bindings.size(); ++i) {
             wgpu::BindGroupLayoutEntry be{};
             be.binding = i;
             be.visibility = wgpu::ShaderStage::Compute;
 
             // Use explicit bindingType provided by caller
-            be.buffer.type = static_cast<wgpu::BufferBindingType>(e.bindingType);
+            be.buffer.type = static_cast<wgpu::BufferBindingType>(bindings[i]);
             be.buffer.hasDynamicOffset = false;
 
             // If uniform, set minBindingSize aligned to 256 for portability
-            if (e.bindingType == krnl::BufferBindingType::Uniform) {
+            if (bindings[i] == krnl::BufferBindingType::Uniform) {
                 //be.buffer.minBindingSize = e.buffer->sizeAlignedToUniform();
             }
             else {
@@ -47,8 +50,29 @@ namespace krnl {
         desc.entryCount = static_cast<uint32_t>(layoutEntries.size());
         desc.entries = layoutEntries.data();
 
-        m_BindGroupLayout = m_Device.GetNative().CreateBindGroupLayout(&desc);
-    }   
+        return device.GetNative().CreateBindGroupLayout(&desc);
+    }
+
+    uint64_t ParameterSet::LayoutHash(const std::vector<BufferBindingType>& bindings) {
+        uint64_t h = HashCombine(kHashSeed, bindings.size());
+        for (BufferBindingType type : bindings) {
+            h = HashCombine(h, static_cast<uint64_t>(type));
+        }
+        return h;
+    }
+
+    void ParameterSet::buildLayout() {
+        std::vector<BufferBindingType> bindings;
+        bindings.reserve(m_Entries.size());
+
+        for (const Entry& e : m_Entries) {
+            assert(&e.buffer != nullptr && "ParameterSet entry buffer must not be null");
+            bindings.push_back(e.bindingType);
+        }
+
+        m_BindGroupLayout = CreateLayout(m_Device, bindings);
+        m_LayoutHash = LayoutHash(bindings);
+    }
 
     void ParameterSet::buildBindGroup() {
         std::vector<wgpu::BindGroupEntry> entries;
@@ -61,7 +85,7 @@ namespace krnl {
             wgpu::BindGroupEntry ent{};
             ent.binding = i;
             ent.buffer = e.buffer.GetNative();
-            ent.offset = 0;
+            ent.offset = static_cast<uint64_t>(e.buffer.GetOffset());
             ent.size = static_cast<uint64_t>(e.buffer.GetSize());
             entries.push_back(ent);
         }
@@ -71,7 +95,10 @@ namespace krnl {
         desc.entryCount = static_cast<uint32_t>(entries.size());
         desc.entries = entries.data();
 
-        m_BindGroup = m_Device.GetNative().CreateBindGroup(&desc);
+        // Create outside the lock; readers keep using the previous group until the swap
+        wgpu::BindGroup group = m_Device.GetNative().CreateBindGroup(&desc);
+        std::lock_guard<std::mutex> l(m_Mutex);
+        m_BindGroup = std::move(group);
     }
 
 } // namespace krnl
@@ -1,6 +1,7 @@
 #include "core/pipeline.hpp"
 #include "core/shader.hpp" // loadWGSL helper
 #include "core/log.h"
+#include <algorithm>
 #include <cassert>
 
 namespace krnl {
@@ -11,40 +12,94 @@ namespace krnl {
 		const Shader& module,
 		const ParameterSet& params,
 		const std::string& entryPoint,
-		const char* label)
+		const char* label,
+		const PipelineConstants& constants)
 	{
 		Pipeline p(device , params); // Use new constructor to initialize m_Device
 		p.m_ShaderModule = module.GetNative();
-		p.buildPipeline(p.m_ShaderModule, entryPoint, label);
+		p.m_Label = label ? label : entryPoint;
+		p.buildPipeline(module, entryPoint, label, constants);
 		return p;
 	}
 
-	/* internal helper to build pipeline layout and pipeline */
-	void Pipeline::buildPipeline(const wgpu::ShaderModule& module, const std::string& entryPoint, const char* label) {
-		assert(&m_Params != nullptr && "ParameterSet must be provided");
+	Future<> Pipeline::CreateComputeAsync(
+		const Device& device,
+		const Shader& module,
+		const ParameterSet& params,
+		std::function<void(Pipeline)> onReady,
+		const std::string& entryPoint,
+		const char* label,
+		const PipelineConstants& constants)
+	{
+		if (!device.IsValid()) {
+			KRNL_ERROR("Cannot build pipeline: invalid device");
+			std::exit(EXIT_FAILURE);
+		}
+
+		PipelineKey key = makeKey(module, entryPoint, params.layoutHash(), constants);
+		wgpu::ShaderModule shaderModule = module.GetNative();
+
+		wgpu::Future f = device.GetPipelineCache().GetOrCreateAsync(key, shaderModule, params.layout(), label,
+			[&device, &params, shaderModule, name = std::string(label ? label : entryPoint), onReady = std::move(onReady)](const CachedPipeline& cached) {
+				Pipeline p(device, params);
+				p.m_ShaderModule = shaderModule;
+				p.m_Label = name;
+				p.m_PipelineLayout = cached.layout;
+				p.m_Pipeline = cached.pipeline;
+				if (onReady) {
+					onReady(std::move(p));
+				}
+			});
+		return Future<>(device.GetInstance(), f);
+	}
+
+	std::vector<Future<>> Pipeline::WarmUp(const Device& device, const std::vector<PipelineWarmupEntry>& manifest)
+	{
+		std::vector<Future<>> futures;
+		futures.reserve(manifest.size());
 
-		wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
-		pipelineLayoutDesc.bindGroupLayoutCount = 1;
-		pipelineLayoutDesc.bindGroupLayouts = &m_Params.layout();
-		m_PipelineLayout = m_Device.GetNative().CreatePipelineLayout(&pipelineLayoutDesc);
-
-		// Create compute pipeline
-		wgpu::ComputePipelineDescriptor pipelineDesc{};
-		pipelineDesc.layout = m_PipelineLayout;
-		pipelineDesc.compute.module = module;
-		pipelineDesc.compute.entryPoint = entryPoint.c_str();
-		if (label) {
-			pipelineDesc.label = label;
+		for (const auto& entry : manifest) {
+			PipelineKey key = makeKey(entry.shader, entry.entryPoint, ParameterSet::LayoutHash(entry.bindings), entry.constants);
+			wgpu::BindGroupLayout layout = ParameterSet::CreateLayout(device, entry.bindings);
+			const char* label = entry.label.empty() ? nullptr : entry.label.c_str();
+
+			futures.emplace_back(device.GetInstance(), device.GetPipelineCache().GetOrCreateAsync(key, entry.shader.GetNative(), layout, label));
 		}
+		return futures;
+	}
+
+	PipelineKey Pipeline::makeKey(const Shader& module, const std::string& entryPoint, uint64_t layoutHash, const PipelineConstants& constants) {
+		PipelineKey key;
+		key.shaderHash = module.GetHash();
+		key.entryPoint = entryPoint;
+		key.layoutHash = layoutHash;
+		key.constants = constants;
+		std::sort(key.constants.begin(), key.constants.end(),
+			[](const PipelineConstant& a, const PipelineConstant& b) { return a.name < b.name; });
+		return key;
+	}
+
+	/* internal helper: fetch pipeline layout and pipeline from the device cache */
+	void Pipeline::buildPipeline(const Shader& module, const std::string& entryPoint, const char* label, const PipelineConstants& constants) {
+		assert(&m_Params != nullptr && "ParameterSet must be provided");
 
 		if (!m_Device.IsValid()) {
 			KRNL_ERROR("Cannot build pipeline: invalid device");
 			std::exit(EXIT_FAILURE);
 		}
-		m_Pipeline = m_Device.GetNative().CreateComputePipeline(&pipelineDesc);
+
+		PipelineKey key = makeKey(module, entryPoint, m_Params.layoutHash(), constants);
+		CachedPipeline cached = m_Device.GetPipelineCache().GetOrCreate(key, module.GetNative(), m_Params.layout(), label);
+		m_PipelineLayout = cached.layout;
+		m_Pipeline = cached.pipeline;
 	}
 
-	void Pipeline::encodeDispatch(const CommandList& cmd, uint32_t x, uint32_t y, uint32_t z) {
+	void Pipeline::encodeDispatch(const CommandList& cmd, uint32_t x, uint32_t y, uint32_t z) const {
+		if (CommandCapture* capture = cmd.GetCapture()) {
+			capture->RecordDispatch(m_Pipeline, m_Params, x, y, z);
+			return;
+		}
+		cmd.NoteDispatch(m_Label);
 		cmd.GetComputePass().SetPipeline(m_Pipeline);
 		cmd.GetComputePass().SetBindGroup(0, m_Params.bindGroup(), 0, nullptr);
 		cmd.GetComputePass().DispatchWorkgroups(x, y, z);
@@ -0,0 +1,182 @@
+#include "core/pipelinecache.hpp"
+#include "core/hash.hpp"
+#include "core/log.h"
+
+#include <cstring>
+
+namespace krnl {
+
+    size_t PipelineKeyHash::operator()(const PipelineKey& key) const {
+        uint64_t h = HashCombine(kHashSeed, key.shaderHash);
+        h = HashString(key.entryPoint, h);
+        h = HashCombine(h, key.layoutHash);
+        for (const PipelineConstant& constant : key.constants) {
+            // -0.0 == 0.0, so both must hash alike
+            const double value = constant.value == 0.0 ? 0.0 : constant.value;
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            h = HashCombine(HashString(constant.name, h), bits);
+        }
+        return static_cast<size_t>(h);
+    }
+
+    PipelineCache::PipelineCache(wgpu::Device device)
+        : m_Device(device), m_State(std::make_shared<State>())
+    {
+    }
+
+    bool PipelineCache::lookup(const PipelineKey& key, CachedPipeline& out) {
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        auto it = m_State->entries.find(key);
+        if (it != m_State->entries.end()) {
+            ++m_State->hits;
+            out = it->second;
+            return true;
+        }
+        ++m_State->misses;
+        return false;
+    }
+
+    wgpu::PipelineLayout PipelineCache::createLayout(const wgpu::BindGroupLayout& bindGroupLayout) const {
+        wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+        pipelineLayoutDesc.bindGroupLayouts = &bindGroupLayout;
+        return m_Device.CreatePipelineLayout(&pipelineLayoutDesc);
+    }
+
+    std::vector<wgpu::ConstantEntry> PipelineCache::constantEntries(const PipelineKey& key) {
+        std::vector<wgpu::ConstantEntry> entries(key.constants.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            entries[i].key = key.constants[i].name.c_str();
+            entries[i].value = key.constants[i].value;
+        }
+        return entries;
+    }
+
+    CachedPipeline PipelineCache::insert(State& state, const PipelineKey& key, const CachedPipeline& entry) {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        // Another thread may have compiled the same key meanwhile; keep the first one.
+        auto [it, inserted] = state.entries.emplace(key, entry);
+        if (!inserted) {
+            KRNL_LOG("PipelineCache: concurrent compile of " << key.entryPoint << ", keeping existing entry");
+        }
+        return it->second;
+    }
+
+    CachedPipeline PipelineCache::GetOrCreate(
+        const PipelineKey& key,
+        const wgpu::ShaderModule& module,
+        const wgpu::BindGroupLayout& bindGroupLayout,
+        const char* label)
+    {
+        CachedPipeline entry;
+        if (lookup(key, entry)) {
+            return entry;
+        }
+
+        // Compile outside the lock so independent misses don't serialize on each other.
+        entry.layout = createLayout(bindGroupLayout);
+
+        wgpu::ComputePipelineDescriptor pipelineDesc{};
+        pipelineDesc.layout = entry.layout;
+        pipelineDesc.compute.module = module;
+        pipelineDesc.compute.entryPoint = key.entryPoint.c_str();
+        std::vector<wgpu::ConstantEntry> constants = constantEntries(key);
+        pipelineDesc.compute.constantCount = constants.size();
+        pipelineDesc.compute.constants = constants.data();
+        if (label) {
+            pipelineDesc.label = label;
+        }
+        entry.pipeline = m_Device.CreateComputePipeline(&pipelineDesc);
+
+        return insert(*m_State, key, entry);
+    }
+
+    wgpu::Future PipelineCache::GetOrCreateAsync(
+        const PipelineKey& key,
+        const wgpu::ShaderModule& module,
+        const wgpu::BindGroupLayout& bindGroupLayout,
+        const char* label,
+        ReadyCallback onReady)
+    {
+        CachedPipeline hit;
+        if (lookup(key, hit)) {
+            if (onReady) {
+                onReady(hit);
+            }
+            return wgpu::Future{};
+        }
+
+        wgpu::PipelineLayout layout = createLayout(bindGroupLayout);
+
+        wgpu::ComputePipelineDescriptor pipelineDesc{};
+        pipelineDesc.layout = layout;
+        pipelineDesc.compute.module = module;
+        pipelineDesc.compute.entryPoint = key.entryPoint.c_str();
+        std::vector<wgpu::ConstantEntry> constants = constantEntries(key);
+        pipelineDesc.compute.constantCount = constants.size();
+        pipelineDesc.compute.constants = constants.data();
+        if (label) {
+            pipelineDesc.label = label;
+        }
+
+        std::weak_ptr<State> weakState = m_State;
+        return m_Device.CreateComputePipelineAsync(
+            &pipelineDesc,
+            wgpu::CallbackMode::AllowSpontaneous,
+            [weakState, key, layout, onReady = std::move(onReady)](
+                wgpu::CreatePipelineAsyncStatus status, wgpu::ComputePipeline pipeline, wgpu::StringView message) {
+                if (status != wgpu::CreatePipelineAsyncStatus::Success) {
+                    KRNL_ERROR("PipelineCache: async compile of " << key.entryPoint << " failed: " << message);
+                    return;
+                }
+                CachedPipeline entry{ layout, std::move(pipeline) };
+                if (auto state = weakState.lock()) {
+                    entry = insert(*state, key, entry);
+                }
+                if (onReady) {
+                    onReady(entry);
+                }
+            });
+    }
+
+    bool PipelineCache::Contains(const PipelineKey& key) const {
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        return m_State->entries.find(key) != m_State->entries.end();
+    }
+
+    wgpu::ShaderModule PipelineCache::GetOrCreateModule(uint64_t shaderHash, const std::function<wgpu::ShaderModule()>& create) {
+        {
+            std::lock_guard<std::mutex> lock(m_State->mutex);
+            auto it = m_State->modules.find(shaderHash);
+            if (it != m_State->modules.end()) {
+                return it->second;
+            }
+        }
+        wgpu::ShaderModule module = create();
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        return m_State->modules.emplace(shaderHash, module).first->second;
+    }
+
+    PipelineCache::Stats PipelineCache::GetStats() const {
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        Stats s;
+        s.hits = m_State->hits;
+        s.misses = m_State->misses;
+        s.entries = m_State->entries.size();
+        return s;
+    }
+
+    void PipelineCache::ResetStats() {
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        m_State->hits = 0;
+        m_State->misses = 0;
+    }
+
+    void PipelineCache::Clear() {
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        m_State->entries.clear();
+        m_State->modules.clear();
+    }
+
+} // namespace krnl
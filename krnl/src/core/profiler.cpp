@@ -0,0 +1,387 @@
+#include "core/profiler.hpp"
+#include "core/log.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace krnl {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        std::string escapeJson(const std::string& s) {
+            std::string out;
+            out.reserve(s.size());
+            for (char c : s) {
+                switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        out += buf;
+                    }
+                    else {
+                        out += c;
+                    }
+                }
+            }
+            return out;
+        }
+    }
+
+    // Query set + resolve/readback buffers for one CommandList, recycled through the state
+    struct QuerySlot {
+        wgpu::QuerySet querySet;
+        wgpu::Buffer resolve;
+        wgpu::Buffer readback;
+    };
+
+    struct Profiler::ListRecord {
+        struct Pass {
+            std::vector<std::string> labels;
+            bool timed = false;
+        };
+
+        std::shared_ptr<QuerySlot> slot;
+        std::weak_ptr<State> owner;
+        std::vector<Pass> passes;
+        uint32_t timedPasses = 0;
+        uint64_t encodeStart = 0;
+        bool resolved = false;
+
+        // A list dropped before Finish never ran its queries, so its slot is reusable. Once
+        // resolved, the submit hook's readback callback gives the slot back instead.
+        ~ListRecord();
+
+        std::string passName(const Pass& pass) const {
+            if (pass.labels.empty()) {
+                return "compute pass";
+            }
+            std::string name = pass.labels[0];
+            for (size_t i = 1; i < pass.labels.size() && i < 3; ++i) {
+                name += ", " + pass.labels[i];
+            }
+            if (pass.labels.size() > 3) {
+                name += ", +" + std::to_string(pass.labels.size() - 3);
+            }
+            return name;
+        }
+    };
+
+    // Shared with map/work-done callbacks, which hold it weakly
+    struct Profiler::State {
+        Clock::time_point origin = Clock::now();
+        size_t maxEvents = 0;
+
+        std::mutex mutex;
+        std::vector<Event> events;
+        std::vector<std::shared_ptr<QuerySlot>> freeSlots;
+        // Host time minus GPU time; raised so no GPU span starts before its submit
+        int64_t gpuOffset = INT64_MIN;
+
+        uint64_t now() const {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count());
+        }
+
+        void add(Event e) {
+            std::lock_guard<std::mutex> l(mutex);
+            if (events.size() >= maxEvents) {
+                return;
+            }
+            events.push_back(std::move(e));
+        }
+
+        void releaseSlot(std::shared_ptr<QuerySlot> slot) {
+            std::lock_guard<std::mutex> l(mutex);
+            freeSlots.push_back(std::move(slot));
+        }
+    };
+
+    Profiler::ListRecord::~ListRecord() {
+        if (slot && !resolved) {
+            if (auto state = owner.lock()) {
+                state->releaseSlot(std::move(slot));
+            }
+        }
+    }
+
+    Profiler::Profiler(wgpu::Device device, wgpu::Queue queue, bool timestamps)
+        : Profiler(std::move(device), std::move(queue), timestamps, Options{})
+    {
+    }
+
+    Profiler::Profiler(wgpu::Device device, wgpu::Queue queue, bool timestamps, const Options& options)
+        : m_Device(std::move(device)), m_Queue(std::move(queue)), m_Timestamps(timestamps), m_Options(options),
+          m_State(std::make_shared<State>())
+    {
+        m_Options.maxPassesPerList = std::max<uint32_t>(m_Options.maxPassesPerList, 1);
+        m_State->maxEvents = m_Options.maxEvents;
+    }
+
+    uint64_t Profiler::Now() const {
+        return m_State->now();
+    }
+
+    void Profiler::AddHostSpan(const char* category, std::string name, uint64_t startNs, uint64_t endNs) {
+        m_State->add({ std::move(name), category, Track::Host, startNs, endNs > startNs ? endNs - startNs : 0 });
+    }
+
+    std::function<void()> Profiler::BeginAsyncSpan(const char* category, std::string name) {
+        std::weak_ptr<State> weak = m_State;
+        uint64_t start = m_State->now();
+        return [weak, category, name = std::move(name), start]() {
+            if (auto state = weak.lock()) {
+                uint64_t end = state->now();
+                state->add({ name, category, Track::Host, start, end - start });
+            }
+        };
+    }
+
+    Profiler::Scope::Scope(Profiler* profiler, const char* category, std::string name)
+        : m_Profiler(profiler), m_Category(category), m_Name(std::move(name))
+    {
+        if (m_Profiler) {
+            m_Start = m_Profiler->Now();
+        }
+    }
+
+    Profiler::Scope::~Scope() {
+        if (m_Profiler) {
+            m_Profiler->AddHostSpan(m_Category, std::move(m_Name), m_Start, m_Profiler->Now());
+        }
+    }
+
+    std::shared_ptr<Profiler::ListRecord> Profiler::BeginList() {
+        auto list = std::make_shared<ListRecord>();
+        list->owner = m_State;
+        list->encodeStart = Now();
+        return list;
+    }
+
+    bool Profiler::BeginPass(ListRecord& list, wgpu::PassTimestampWrites& writes) {
+        list.passes.emplace_back();
+        if (!m_Timestamps || list.timedPasses >= m_Options.maxPassesPerList) {
+            return false;
+        }
+
+        if (!list.slot) {
+            {
+                std::lock_guard<std::mutex> l(m_State->mutex);
+                if (!m_State->freeSlots.empty()) {
+                    list.slot = std::move(m_State->freeSlots.back());
+                    m_State->freeSlots.pop_back();
+                }
+            }
+            if (!list.slot) {
+                const uint32_t queries = 2 * m_Options.maxPassesPerList;
+                auto slot = std::make_shared<QuerySlot>();
+
+                wgpu::QuerySetDescriptor qd{};
+                qd.label = "krnl_profiler_queries";
+                qd.type = wgpu::QueryType::Timestamp;
+                qd.count = queries;
+                slot->querySet = m_Device.CreateQuerySet(&qd);
+
+                wgpu::BufferDescriptor bd{};
+                bd.label = "krnl_profiler_resolve";
+                bd.size = queries * sizeof(uint64_t);
+                bd.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+                slot->resolve = m_Device.CreateBuffer(&bd);
+
+                bd.label = "krnl_profiler_readback";
+                bd.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+                slot->readback = m_Device.CreateBuffer(&bd);
+                list.slot = std::move(slot);
+            }
+        }
+
+        writes.querySet = list.slot->querySet;
+        writes.beginningOfPassWriteIndex = 2 * list.timedPasses;
+        writes.endOfPassWriteIndex = 2 * list.timedPasses + 1;
+        list.passes.back().timed = true;
+        list.timedPasses++;
+        return true;
+    }
+
+    void Profiler::AddDispatch(ListRecord& list, const std::string& label) {
+        if (list.passes.empty()) {
+            return;
+        }
+        auto& labels = list.passes.back().labels;
+        if (std::find(labels.begin(), labels.end(), label) == labels.end()) {
+            labels.push_back(label);
+        }
+    }
+
+    void Profiler::ResolveList(ListRecord& list, const wgpu::CommandEncoder& encoder) {
+        if (list.resolved) {
+            return;
+        }
+        list.resolved = true;
+        if (list.slot && list.timedPasses > 0) {
+            const uint32_t queries = 2 * list.timedPasses;
+            encoder.ResolveQuerySet(list.slot->querySet, 0, queries, list.slot->resolve, 0);
+            encoder.CopyBufferToBuffer(list.slot->resolve, 0, list.slot->readback, 0, queries * sizeof(uint64_t));
+        }
+        AddHostSpan("encode", "CommandList (" + std::to_string(list.passes.size()) + " passes)", list.encodeStart, Now());
+    }
+
+    std::function<void()> Profiler::OnSubmitted(std::shared_ptr<ListRecord> list) {
+        if (list->passes.empty()) {
+            return {};
+        }
+        std::weak_ptr<State> weak = m_State;
+        wgpu::Queue queue = m_Queue;
+
+        return [weak, queue, list = std::move(list)]() {
+            auto state = weak.lock();
+            if (!state) {
+                return;
+            }
+            const uint64_t submitNs = state->now();
+
+            if (!list->slot || list->timedPasses == 0) {
+                // No timestamps: time the submission on the host until the queue drains it
+                queue.OnSubmittedWorkDone(wgpu::CallbackMode::AllowSpontaneous,
+                    [weak, list, submitNs](wgpu::QueueWorkDoneStatus status, wgpu::StringView) {
+                        auto state = weak.lock();
+                        if (!state || status != wgpu::QueueWorkDoneStatus::Success) {
+                            return;
+                        }
+                        std::string name;
+                        for (const auto& pass : list->passes) {
+                            name += (name.empty() ? "" : " | ") + list->passName(pass);
+                        }
+                        state->add({ std::move(name), "gpu-host", Track::Gpu, submitNs, state->now() - submitNs });
+                    });
+                return;
+            }
+
+            const uint32_t queries = 2 * list->timedPasses;
+            wgpu::Buffer readback = list->slot->readback;
+            readback.MapAsync(wgpu::MapMode::Read, 0, queries * sizeof(uint64_t), wgpu::CallbackMode::AllowSpontaneous,
+                [weak, list, submitNs, queries, readback](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+                    auto state = weak.lock();
+                    if (!state) {
+                        return;
+                    }
+                    if (status != wgpu::MapAsyncStatus::Success) {
+                        KRNL_WARN("Profiler: timestamp readback failed: " << message);
+                        // Nothing is mapped; the slot is still good for another list
+                        state->releaseSlot(list->slot);
+                        return;
+                    }
+
+                    std::vector<uint64_t> ticks(queries);
+                    const void* data = readback.GetConstMappedRange(0, queries * sizeof(uint64_t));
+                    if (data) {
+                        std::memcpy(ticks.data(), data, queries * sizeof(uint64_t));
+                    }
+                    readback.Unmap();
+
+                    uint64_t first = UINT64_MAX;
+                    for (uint32_t i = 0; i < queries; i += 2) {
+                        if (ticks[i] != 0) {
+                            first = std::min(first, ticks[i]);
+                        }
+                    }
+
+                    std::lock_guard<std::mutex> l(state->mutex);
+                    if (first != UINT64_MAX) {
+                        state->gpuOffset = std::max(state->gpuOffset, static_cast<int64_t>(submitNs) - static_cast<int64_t>(first));
+                    }
+                    uint32_t q = 0;
+                    for (const auto& pass : list->passes) {
+                        if (!pass.timed) {
+                            continue;
+                        }
+                        const uint64_t begin = ticks[q];
+                        const uint64_t end = ticks[q + 1];
+                        q += 2;
+                        if (begin == 0 || end < begin || state->events.size() >= state->maxEvents) {
+                            continue;
+                        }
+                        const int64_t start = static_cast<int64_t>(begin) + state->gpuOffset;
+                        state->events.push_back({ list->passName(pass), "gpu", Track::Gpu,
+                            static_cast<uint64_t>(std::max<int64_t>(start, 0)), end - begin });
+                    }
+                    // The slot can take another list's queries now
+                    state->freeSlots.push_back(list->slot);
+                });
+        };
+    }
+
+    std::vector<Profiler::Event> Profiler::GetEvents() const {
+        std::lock_guard<std::mutex> l(m_State->mutex);
+        return m_State->events;
+    }
+
+    std::vector<Profiler::KernelStats> Profiler::GetKernelStats() const {
+        std::map<std::string, KernelStats> byName;
+        for (const Event& e : GetEvents()) {
+            if (e.track != Track::Gpu) {
+                continue;
+            }
+            KernelStats& s = byName[e.name];
+            if (s.count == 0) {
+                s.name = e.name;
+                s.minNs = e.durationNs;
+            }
+            s.count++;
+            s.totalNs += e.durationNs;
+            s.minNs = std::min(s.minNs, e.durationNs);
+            s.maxNs = std::max(s.maxNs, e.durationNs);
+        }
+
+        std::vector<KernelStats> stats;
+        for (auto& [name, s] : byName) {
+            stats.push_back(std::move(s));
+        }
+        std::sort(stats.begin(), stats.end(), [](const KernelStats& a, const KernelStats& b) {
+            return a.totalNs > b.totalNs;
+        });
+        return stats;
+    }
+
+    std::string Profiler::ToChromeTrace() const {
+        std::ostringstream out;
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Host\"}},";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+        char ts[64];
+        for (const Event& e : GetEvents()) {
+            // Chrome trace times are microseconds
+            std::snprintf(ts, sizeof(ts), "\"ts\":%.3f,\"dur\":%.3f", e.startNs / 1e3, e.durationNs / 1e3);
+            out << ",{\"name\":\"" << escapeJson(e.name) << "\",\"cat\":\"" << escapeJson(e.category)
+                << "\",\"ph\":\"X\"," << ts << ",\"pid\":1,\"tid\":" << static_cast<uint32_t>(e.track) << "}";
+        }
+        out << "]}";
+        return out.str();
+    }
+
+    bool Profiler::WriteChromeTrace(const std::filesystem::path& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            KRNL_ERROR("Profiler: cannot write trace to " << path.string());
+            return false;
+        }
+        file << ToChromeTrace();
+        return static_cast<bool>(file);
+    }
+
+    void Profiler::Clear() {
+        std::lock_guard<std::mutex> l(m_State->mutex);
+        m_State->events.clear();
+    }
+
+} // namespace krnl
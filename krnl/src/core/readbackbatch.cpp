@@ -0,0 +1,97 @@
+#include "core/readbackbatch.hpp"
+#include "core/buffer.hpp"
+#include "core/device.hpp"
+#include "core/log.h"
+#include <cstdint>
+
+namespace krnl {
+
+    namespace {
+        // Entries start 8-byte aligned so 64-bit results can be read in place
+        constexpr size_t ENTRY_ALIGN = 8;
+    }
+
+    ReadbackBatch::ReadbackBatch(const Device& device)
+        : m_Device(device)
+    {
+    }
+
+    size_t ReadbackBatch::Read(const Buffer& src, size_t offset, size_t size, ReadCallback cb) {
+        if (offset + size > src.GetSize()) {
+            KRNL_ERROR("ReadbackBatch::Read => out of range read (requested " << size << " bytes at offset " << offset << ", buffer size " << src.GetSize() << ")");
+            return SIZE_MAX;
+        }
+        if ((size | offset | src.GetOffset()) & 3) {
+            KRNL_ERROR("ReadbackBatch::Read => size " << size << " and offset " << offset << " must be multiples of 4");
+            return SIZE_MAX;
+        }
+
+        Entry e;
+        e.src = src.GetNative();
+        e.srcOffset = src.GetOffset() + offset;
+        e.offset = (m_PackedSize + ENTRY_ALIGN - 1) / ENTRY_ALIGN * ENTRY_ALIGN;
+        e.size = size;
+        e.cb = std::move(cb);
+
+        m_PackedSize = e.offset + size;
+        m_Entries.push_back(std::move(e));
+        return m_Entries.size() - 1;
+    }
+
+    size_t ReadbackBatch::Read(const Buffer& src, ReadCallback cb) {
+        return Read(src, 0, src.GetSize(), std::move(cb));
+    }
+
+    Future<> ReadbackBatch::Submit(CompleteCallback onComplete) {
+        if (m_Entries.empty()) {
+            if (onComplete) onComplete(Result());
+            return Future<>();
+        }
+
+        wgpu::Queue queue = m_Device.getQueue();
+        PersistentStagingPool& pool = m_Device.GetStagingPool();
+
+        // Pending batched uploads must land before the copies read their sources
+        m_Device.GetUploadBatch().Flush();
+        pool.flush(queue);
+
+        const size_t packedSize = m_PackedSize;
+        StagingHandlePtr staging = pool.allocateForReadback(packedSize);
+
+        wgpu::CommandEncoderDescriptor encDesc{};
+        wgpu::CommandEncoder encoder = m_Device.GetNative().CreateCommandEncoder(&encDesc);
+        for (const Entry& e : m_Entries) {
+            encoder.CopyBufferToBuffer(e.src, e.srcOffset, staging->buffer, e.offset, e.size);
+        }
+        SubmitQueue& submitQueue = m_Device.GetSubmitQueue();
+        submitQueue.Enqueue(encoder.Finish());
+        submitQueue.Flush();
+
+        std::vector<Entry> entries = std::move(m_Entries);
+        m_Entries.clear();
+        m_PackedSize = 0;
+
+        wgpu::Future f = pool.mapReadback(std::move(staging), packedSize,
+            [entries = std::move(entries), onComplete = std::move(onComplete)](const void* data, size_t) {
+                if (!data) {
+                    // Map failed: every reader still hears back, with nothing
+                    for (const Entry& e : entries) {
+                        if (e.cb) e.cb(nullptr, 0);
+                    }
+                    if (onComplete) onComplete(Result());
+                    return;
+                }
+                const std::byte* base = static_cast<const std::byte*>(data);
+                Result result;
+                result.m_Data = base;
+                result.m_Ranges.reserve(entries.size());
+                for (const Entry& e : entries) {
+                    result.m_Ranges.emplace_back(e.offset, e.size);
+                    if (e.cb) e.cb(base + e.offset, e.size);
+                }
+                if (onComplete) onComplete(result);
+            });
+        return Future<>(m_Device.GetInstance(), f);
+    }
+
+} // namespace krnl
@@ -1,5 +1,7 @@
 #include "core/shader.hpp"
+#include "core/hash.hpp"
 
+#include <atomic>
 #include <fstream>
 
 namespace krnl
@@ -15,24 +17,38 @@ namespace krnl
 		return shaderModule;
 	}
 
-	wgpu::ShaderModule readWGSL(wgpu::Device device, std::filesystem::path path)
+	std::string readSource(std::filesystem::path path)
 	{
 		std::ifstream file(path);
-		std::string src((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	}
 
-		return loadWGSL(device, src);
+	Shader::Shader(wgpu::ShaderModule shaderModule)
+		: m_ShaderModule(shaderModule)
+	{
+		// Hashed into the same space as source hashes; never persisted, so a counter is enough
+		static std::atomic<uint64_t> nextId{ 0 };
+		m_Hash = HashString("krnl.native_module." + std::to_string(nextId++));
 	}
 
 	Shader Shader::loadWGSL(const Device& device, const std::string& source)
 	{
 		wgpu::ShaderModule shaderModule = krnl::loadWGSL(device.GetNative(), source);
-		return Shader(shaderModule);
+		return Shader(shaderModule, HashString(source));
+	}
+
+	Shader Shader::loadCachedWGSL(const Device& device, const std::string& source)
+	{
+		uint64_t hash = HashString(source);
+		wgpu::ShaderModule shaderModule = device.GetPipelineCache().GetOrCreateModule(hash, [&] {
+			return krnl::loadWGSL(device.GetNative(), source);
+		});
+		return Shader(shaderModule, hash);
 	}
 
 	Shader Shader::readWGSL(const Device& device, std::filesystem::path path)
 	{
-		wgpu::ShaderModule shaderModule = krnl::readWGSL(device.GetNative(), path);
-		return Shader(shaderModule);
+		return Shader::loadWGSL(device, krnl::readSource(path));
 	}
 
 	
@@ -1,25 +1,55 @@
 #include "core/stagingpool.hpp"
+#include "core/submitqueue.hpp"
 #include "core/log.h"
 #include <algorithm>
 #include <cstring>
+#include <optional>
 #include <string>
 
 namespace krnl {
 
+    namespace {
+        // CopyBufferToBuffer offsets and sizes must be multiples of 4
+        constexpr size_t COPY_ALIGN = 4;
+
+        size_t alignUp(size_t v, size_t a) {
+            return ((v + a - 1) / a) * a;
+        }
+
+        // Readback size classes: 256 B << n
+        constexpr size_t READBACK_MIN_CLASS = 256;
+
+        size_t readbackClass(size_t size) {
+            size_t cls = 0;
+            while ((READBACK_MIN_CLASS << cls) < size)
+                ++cls;
+            return cls;
+        }
+    }
+
+    PersistentStagingPool::PersistentStagingPool(wgpu::Device device)
+        : PersistentStagingPool(device, Config{})
+    {
+    }
+
     PersistentStagingPool::PersistentStagingPool(wgpu::Device device, const Config& cfg)
-        : m_device(device), m_cfg(cfg)
+        : m_device(device), m_cfg(cfg), m_readback(std::make_shared<ReadbackState>())
     {
-        m_ready.reserve(m_cfg.maxPoolSize);
-        m_inflight.reserve(m_cfg.maxPoolSize * 2);
+        m_readback->maxPerClass = m_cfg.maxPoolSize;
+        m_free.reserve(m_cfg.maxChunks);
     }
 
     PersistentStagingPool::~PersistentStagingPool() {
         purge();
     }
 
-    StagingHandlePtr PersistentStagingPool::createStaging(size_t size) {
+    std::unique_lock<std::mutex> PersistentStagingPool::lock() {
+        return m_cfg.threadSafe ? std::unique_lock<std::mutex>(m_mutex) : std::unique_lock<std::mutex>();
+    }
+
+    StagingChunkPtr PersistentStagingPool::createChunk(size_t size) {
         constexpr size_t ALIGN = 256;
-        size = ((size + ALIGN - 1) / ALIGN) * ALIGN;
+        size = alignUp(size, ALIGN);
 
         wgpu::BufferDescriptor desc{};
         desc.size = size;
@@ -30,212 +60,440 @@ namespace krnl {
         std::string label = std::string(m_cfg.labelPrefix) + "_upload";
         desc.label = label.c_str();
 
-        wgpu::Buffer b = m_device.CreateBuffer(&desc);
-        void* mapped = b.GetMappedRange();
+        auto chunk = std::make_shared<StagingChunk>();
+        chunk->buffer = m_device.CreateBuffer(&desc);
+        chunk->mapped = static_cast<uint8_t*>(chunk->buffer.GetMappedRange());
+        chunk->size = size;
+        if (m_metrics) {
+            chunk->memory = m_metrics->TrackGpuMemory(size);
+        }
+        m_stats.chunksCreated++;
+        return chunk;
+    }
+
+    // Move chunks whose remap completed back to the free list. Called with the lock held.
+    void PersistentStagingPool::reclaim() {
+        for (auto it = m_inflight.begin(); it != m_inflight.end();) {
+            StagingChunkPtr chunk = *it;
+            StagingChunk::State state = chunk->state.load();
+            if (state == StagingChunk::State::InFlight) {
+                ++it;
+                continue;
+            }
+            it = m_inflight.erase(it);
+
+            if (state == StagingChunk::State::Failed) {
+                continue;
+            }
+            if (chunk->size != m_cfg.chunkSize || m_free.size() >= m_cfg.maxChunks) {
+                // Oversized or surplus chunk: let it go rather than keep the memory around
+                chunk->buffer.Destroy();
+                continue;
+            }
+            chunk->mapped = static_cast<uint8_t*>(chunk->buffer.GetMappedRange(0, chunk->size));
+            chunk->head = 0;
+            chunk->state = StagingChunk::State::Mapped;
+            m_free.push_back(chunk);
+            m_stats.chunksRecycled++;
+        }
+    }
+
+    // Called with the lock held. nullptr once maxInflightChunks are retired and not yet remapped.
+    StagingChunkPtr PersistentStagingPool::acquireChunk(size_t size) {
+        reclaim();
+        if (size <= m_cfg.chunkSize && !m_free.empty()) {
+            StagingChunkPtr chunk = m_free.back();
+            m_free.pop_back();
+            return chunk;
+        }
+        if (m_inflight.size() + m_active.size() >= m_cfg.maxInflightChunks) {
+            m_stats.allocationsCapped++;
+            return nullptr;
+        }
+        return createChunk(std::max(size, m_cfg.chunkSize));
+    }
+
+    StagingHandlePtr PersistentStagingPool::allocate(size_t size) {
+        size_t bytes = alignUp(std::max<size_t>(size, 1), COPY_ALIGN);
+
+        auto l = lock();
+
+        if (m_current && m_current->head + bytes > m_current->size) {
+            if (m_current->outstanding == 0 && m_current->copies.empty()) {
+                // Nothing pending in it (all regions were abandoned): rewind and reuse
+                m_current->head = 0;
+                if (bytes > m_current->size) {
+                    if (m_current->size == m_cfg.chunkSize)
+                        m_free.push_back(m_current);
+                    m_current = nullptr;
+                }
+            }
+            else {
+                m_active.push_back(m_current);
+                m_current = nullptr;
+            }
+        }
+        if (!m_current) {
+            m_current = acquireChunk(bytes);
+            if (!m_current) {
+                return nullptr;
+            }
+        }
 
         auto h = std::make_shared<StagingHandle>();
-        h->buffer = b;
-        h->mappedPtr = mapped;
-        h->size = size;
+        h->buffer = m_current->buffer;
+        h->mappedPtr = m_current->mapped + m_current->head;
+        h->size = bytes;
+        h->offset = m_current->head;
         h->forWrite = true;
-        h->inUse = false;
+        h->inUse = true;
+        h->chunk = m_current;
+
+        m_current->head += bytes;
+        m_current->outstanding++;
         return h;
     }
 
-    StagingHandlePtr PersistentStagingPool::createReadbackStaging(size_t size) {
-        // Round to alignment
-        constexpr size_t ALIGN = 256;
-        size = ((size + ALIGN - 1) / ALIGN) * ALIGN;
+    void PersistentStagingPool::enqueueUpload(StagingHandlePtr staging, wgpu::Buffer dstBuffer, size_t bytes, size_t dstOffset) {
+        StagingChunk::Copy copy{ 0, std::move(dstBuffer), dstOffset, bytes };
+        enqueueUploads(std::move(staging), &copy, 1);
+    }
 
-        wgpu::BufferDescriptor desc{};
-        desc.size = size;
-        // IMPORTANT FIX:
-        // For readback staging we MUST include CopyDst (so GPU can copy into it) AND
-        // include CopySrc when you may later use it as a source. MapRead is required to map it.
-        // Including CopySrc is safe and avoids usage validation errors if a copy-from-staging is ever performed.
-        desc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
-        desc.mappedAtCreation = false;
+    void PersistentStagingPool::enqueueUploads(StagingHandlePtr staging, const StagingChunk::Copy* copies, size_t count) {
+        if (!staging || !staging->chunk) {
+            KRNL_ERROR("enqueueUpload called with null or non-upload staging");
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (copies[i].srcOffset + copies[i].size > staging->size) {
+                KRNL_ERROR("enqueueUpload: copy [" << copies[i].srcOffset << ", " << copies[i].srcOffset + copies[i].size
+                    << ") exceeds staging size " << staging->size);
+                return;
+            }
+        }
 
-        std::string label = std::string(m_cfg.labelPrefix) + "_readback";
-        desc.label = label.c_str();
+        auto l = lock();
+        if (!staging->inUse) {
+            KRNL_ERROR("enqueueUpload: staging region was already submitted");
+            return;
+        }
 
-        wgpu::Buffer b = m_device.CreateBuffer(&desc);
+        StagingChunk& chunk = *staging->chunk;
+        for (size_t i = 0; i < count; ++i) {
+            StagingChunk::Copy copy = copies[i];
+            copy.srcOffset += staging->offset;
+            m_stats.uploadBytes += copy.size;
+
+            if (!chunk.copies.empty()) {
+                StagingChunk::Copy& last = chunk.copies.back();
+                if (last.dst.Get() == copy.dst.Get() &&
+                    last.srcOffset + last.size == copy.srcOffset &&
+                    last.dstOffset + last.size == copy.dstOffset) {
+                    last.size += copy.size;
+                    continue;
+                }
+            }
+            if (copy.size) {
+                chunk.copies.push_back(std::move(copy));
+            }
+        }
 
-        auto h = std::make_shared<StagingHandle>();
-        h->buffer = b;
-        h->mappedPtr = nullptr;
-        h->size = size;
-        h->forWrite = false;
-        h->inUse = false;
-        return h;
+        chunk.outstanding--;
+        staging->inUse = false;
+        staging->mappedPtr = nullptr;
+        m_stats.uploads += count;
     }
 
-    StagingHandlePtr PersistentStagingPool::allocate(size_t size) {
-        if (m_cfg.threadSafe) m_mutex.lock();
-
-        auto it = std::find_if(m_ready.begin(), m_ready.end(), [size](const StagingHandlePtr& h) {
-            return h->size >= size && !h->inUse;
-            });
+    void PersistentStagingPool::flush(wgpu::Queue queue) {
+        submitChunks(queue, true);
+    }
 
-        if (it != m_ready.end()) {
-            auto h = *it;
-            m_ready.erase(it);
-            h->inUse = true;
-            if (m_cfg.threadSafe) m_mutex.unlock();
-            return h;
+    void PersistentStagingPool::submitChunks(wgpu::Queue queue, bool includeCurrent) {
+        std::vector<StagingChunkPtr> closing;
+        {
+            auto l = lock();
+            auto readyToSubmit = [](const StagingChunkPtr& c) {
+                return c->outstanding == 0 && !c->copies.empty();
+            };
+            for (auto it = m_active.begin(); it != m_active.end();) {
+                if (readyToSubmit(*it)) {
+                    closing.push_back(*it);
+                    it = m_active.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+            if (includeCurrent && m_current && readyToSubmit(m_current)) {
+                closing.push_back(m_current);
+                m_current = nullptr;
+            }
+            if (closing.empty()) {
+                return;
+            }
+            m_stats.flushes++;
         }
 
-        if (m_ready.size() + m_inflight.size() < m_cfg.maxPoolSize) {
-            auto newStaging = createStaging(size);
-            newStaging->inUse = true;
-            if (m_cfg.threadSafe) m_mutex.unlock();
-            return newStaging;
+        // The closing chunks are no longer reachable by other threads; no lock needed.
+        wgpu::CommandEncoderDescriptor encDesc{};
+        wgpu::CommandEncoder encoder = m_device.CreateCommandEncoder(&encDesc);
+        for (auto& chunk : closing) {
+            chunk->buffer.Unmap();
+            chunk->mapped = nullptr;
+            for (const auto& copy : chunk->copies) {
+                encoder.CopyBufferToBuffer(chunk->buffer, copy.srcOffset, copy.dst, copy.dstOffset, copy.size);
+            }
+            chunk->copies.clear();
+            chunk->state = StagingChunk::State::InFlight;
         }
+        wgpu::CommandBuffer cmd = encoder.Finish();
 
-        if (!m_ready.empty()) {
-            auto smallestIt = std::min_element(m_ready.begin(), m_ready.end(),
-                [](const StagingHandlePtr& a, const StagingHandlePtr& b) { return a->size < b->size; });
-            auto h = *smallestIt;
-            m_ready.erase(smallestIt);
-            h->inUse = true;
-            if (m_cfg.threadSafe) m_mutex.unlock();
-            return h;
+        {
+            auto l = lock();
+            m_inflight.insert(m_inflight.end(), closing.begin(), closing.end());
         }
 
-        auto newStaging = createStaging(size);
-        newStaging->inUse = true;
-        if (m_cfg.threadSafe) m_mutex.unlock();
-        return newStaging;
+        // Remap as soon as the copies are submitted: the map only completes once the GPU is
+        // done with them. Mapping earlier would make the submit fail validation. Chunks that
+        // filled up between flushes go out right away so their remap starts early.
+        submit(queue, cmd, [closing]() {
+            for (auto& chunk : closing) {
+                std::weak_ptr<StagingChunk> weak = chunk;
+                chunk->buffer.MapAsync(
+                    wgpu::MapMode::Write,
+                    0,
+                    chunk->size,
+                    wgpu::CallbackMode::AllowSpontaneous,
+                    [weak](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+                        auto c = weak.lock();
+                        if (!c) {
+                            return;
+                        }
+                        if (status != wgpu::MapAsyncStatus::Success) {
+                            KRNL_WARN("PersistentStagingPool: chunk remap failed: " << message);
+                            c->state = StagingChunk::State::Failed;
+                            return;
+                        }
+                        c->state = StagingChunk::State::Remapped;
+                    });
+            }
+        }, !includeCurrent);
+    }
+
+    void PersistentStagingPool::submit(wgpu::Queue queue, wgpu::CommandBuffer cmd, std::function<void()> afterSubmit, bool flushNow) {
+        if (m_submitQueue) {
+            m_submitQueue->Enqueue(std::move(cmd), std::move(afterSubmit));
+            if (flushNow) {
+                m_submitQueue->Flush();
+            }
+            return;
+        }
+        queue.Submit(1, &cmd);
+        if (afterSubmit) {
+            afterSubmit();
+        }
     }
 
-    StagingHandlePtr PersistentStagingPool::submitUpload(
+    void PersistentStagingPool::submitUpload(
         StagingHandlePtr staging,
         wgpu::Buffer dstBuffer,
         size_t bytes,
         size_t dstOffset,
         wgpu::Queue queue)
     {
-        if (!staging) {
-            KRNL_ERROR("submitUpload called with null staging");
-            return nullptr;
-        }
-        if (bytes > staging->size) {
-            KRNL_ERROR("submitUpload: bytes (%zu) > staging size (%zu)" << bytes << staging->size);
-            return nullptr;
-        }
-
-        if (m_cfg.threadSafe) m_mutex.lock();
+        enqueueUpload(staging, dstBuffer, bytes, dstOffset);
+        // Retiring the open chunk per upload would tie up a whole chunk for every small write
+        submitChunks(queue, false);
+    }
 
-        // Unmap the staging (was mappedAtCreation)
-        staging->buffer.Unmap();
+    void PersistentStagingPool::writeDirect(wgpu::Buffer dstBuffer, size_t dstOffset, const void* src, size_t bytes, wgpu::Queue queue) {
+        // Queue::WriteBuffer lands ahead of anything not yet submitted
+        flush(queue);
+        if (m_submitQueue) {
+            m_submitQueue->Flush();
+        }
+        queue.WriteBuffer(dstBuffer, static_cast<uint64_t>(dstOffset), src, bytes);
+    }
 
-        // Encode copy: staging -> dstBuffer
-        wgpu::CommandEncoderDescriptor encDesc{};
-        wgpu::CommandEncoder encoder = m_device.CreateCommandEncoder(&encDesc);
-        encoder.CopyBufferToBuffer(staging->buffer, 0, dstBuffer, static_cast<uint64_t>(dstOffset), static_cast<uint64_t>(bytes));
-        wgpu::CommandBuffer cmd = encoder.Finish();
-        queue.Submit(1, &cmd);
+    PersistentStagingPool::Stats PersistentStagingPool::getStats() {
+        auto l = lock();
+        reclaim();
+        Stats s = m_stats;
+        s.freeChunks = m_free.size();
+        s.activeChunks = m_active.size() + (m_current ? 1 : 0);
+        s.inflightChunks = m_inflight.size();
+        for (const auto& chunk : m_free)
+            s.freeBytes += chunk->size;
+        for (const auto& chunk : m_inflight)
+            s.inflightBytes += chunk->size;
+
+        std::lock_guard<std::mutex> rl(m_readback->mutex);
+        for (const auto& cls : m_readback->free)
+            s.freeReadbackBuffers += cls.size();
+        s.readbacks = m_readback->readbacks;
+        s.readbackBuffersCreated = m_readback->created;
+        s.readbackBuffersReused = m_readback->reused;
+        return s;
+    }
 
-        // Keep the staging alive
-        m_inflight.push_back(staging);
+    StagingHandlePtr PersistentStagingPool::createReadbackStaging(size_t size) {
+        // Round to alignment
+        constexpr size_t ALIGN = 256;
+        size = ((size + ALIGN - 1) / ALIGN) * ALIGN;
 
-        // Create replacement staging buffer mappedAtCreation (if pool not saturated)
-        StagingHandlePtr replacement = nullptr;
-        if (m_ready.size() + m_inflight.size() < m_cfg.maxPoolSize + 4) {
-            replacement = createStaging(bytes);
-            replacement->inUse = false;
-            m_ready.push_back(replacement);
-        }
-        else {
-            KRNL_WARN("PersistentStagingPool saturated; no replacement created");
-        }
+        wgpu::BufferDescriptor desc{};
+        desc.size = size;
+        // IMPORTANT FIX:
+        // For readback staging we MUST include CopyDst (so GPU can copy into it) AND
+        // include CopySrc when you may later use it as a source. MapRead is required to map it.
+        // Including CopySrc is safe and avoids usage validation errors if a copy-from-staging is ever performed.
+        desc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
+        desc.mappedAtCreation = false;
 
-        staging->inUse = false;
+        std::string label = std::string(m_cfg.labelPrefix) + "_readback";
+        desc.label = label.c_str();
 
-        if (m_cfg.threadSafe) m_mutex.unlock();
+        wgpu::Buffer b = m_device.CreateBuffer(&desc);
 
-        // Trim in-flight list occasionally (heuristic)
-        if (m_inflight.size() > m_cfg.maxPoolSize * 8) {
-            m_inflight.erase(m_inflight.begin(), m_inflight.begin() + (m_inflight.size() / 2));
-            KRNL_WARN("PersistentStagingPool trimmed in-flight list");
+        auto h = std::make_shared<StagingHandle>();
+        h->buffer = b;
+        h->mappedPtr = nullptr;
+        h->size = size;
+        h->forWrite = false;
+        h->inUse = false;
+        if (m_metrics) {
+            h->memory = m_metrics->TrackGpuMemory(size);
         }
-
-        return replacement;
+        return h;
     }
 
     StagingHandlePtr PersistentStagingPool::allocateForReadback(size_t size) {
         // For readback we don't return a mapped pointer; caller will submit copy and then MapAsync.
-        if (m_cfg.threadSafe) m_mutex.lock();
-
-        // Try to find an unused readback staging in ready (we store both types together).
-        auto it = std::find_if(m_ready.begin(), m_ready.end(), [size](const StagingHandlePtr& h) {
-            return h->size >= size && !h->inUse && !h->forWrite;
-            });
-
-        if (it != m_ready.end()) {
-            auto h = *it;
-            m_ready.erase(it);
-            h->inUse = true;
-            if (m_cfg.threadSafe) m_mutex.unlock();
-            return h;
+        size_t cls = readbackClass(size);
+        {
+            std::lock_guard<std::mutex> l(m_readback->mutex);
+            if (cls < m_readback->free.size() && !m_readback->free[cls].empty()) {
+                StagingHandlePtr h = m_readback->free[cls].back();
+                m_readback->free[cls].pop_back();
+                m_readback->reused++;
+                h->inUse = true;
+                return h;
+            }
+            m_readback->created++;
         }
 
-        // Otherwise create a new readback staging
-        auto readStaging = createReadbackStaging(size);
+        // Otherwise create a new readback staging of the full class size
+        auto readStaging = createReadbackStaging(READBACK_MIN_CLASS << cls);
         readStaging->inUse = true;
-        if (m_cfg.threadSafe) m_mutex.unlock();
         return readStaging;
     }
 
-    void PersistentStagingPool::readbackInto(
+    void PersistentStagingPool::recycleReadback(ReadbackState& state, StagingHandlePtr staging) {
+        staging->inUse = false;
+        size_t cls = readbackClass(staging->size);
+
+        std::lock_guard<std::mutex> l(state.mutex);
+        if (state.free.size() <= cls)
+            state.free.resize(cls + 1);
+        if (state.free[cls].size() < state.maxPerClass) {
+            state.free[cls].push_back(std::move(staging));
+            return;
+        }
+        staging->buffer.Destroy();
+    }
+
+    void PersistentStagingPool::releaseReadback(StagingHandlePtr staging) {
+        if (!staging || staging->forWrite) {
+            KRNL_ERROR("releaseReadback called with null or upload staging");
+            return;
+        }
+        recycleReadback(*m_readback, std::move(staging));
+    }
+
+    wgpu::Future PersistentStagingPool::readbackInto(
         wgpu::Buffer src,
         size_t bytes,
         size_t srcOffset,
         wgpu::Queue queue,
         std::function<void(const void* data, size_t size)> cb)
     {
-        // Create a readback staging buffer (MapRead | CopyDst | CopySrc)
-        auto staging = createReadbackStaging(bytes);
+        // Uploads still sitting in the ring must reach the GPU before the copy below reads src
+        flush(queue);
+
+        auto staging = allocateForReadback(bytes);
 
         // Encode copy: src -> staging
         wgpu::CommandEncoderDescriptor encDesc{};
         wgpu::CommandEncoder encoder = m_device.CreateCommandEncoder(&encDesc);
         encoder.CopyBufferToBuffer(src, static_cast<uint64_t>(srcOffset), staging->buffer, 0, static_cast<uint64_t>(bytes));
         wgpu::CommandBuffer cmd = encoder.Finish();
-        queue.Submit(1, &cmd);
+        // The map below needs the copy on the queue
+        submit(queue, cmd, {}, true);
 
-        // Keep staging alive with shared_ptr
-        auto stagingPtr = std::make_shared<wgpu::Buffer>(staging->buffer);
+        return mapReadback(std::move(staging), bytes, std::move(cb));
+    }
+
+    wgpu::Future PersistentStagingPool::mapReadback(StagingHandlePtr staging, size_t bytes, std::function<void(const void* data, size_t size)> cb) {
+        {
+            std::lock_guard<std::mutex> l(m_readback->mutex);
+            m_readback->readbacks++;
+        }
 
-        stagingPtr->MapAsync(
+        // The callback keeps the staging alive; the pool only through a weak reference
+        std::weak_ptr<ReadbackState> weak = m_readback;
+        wgpu::Buffer buffer = staging->buffer;
+        std::optional<Metrics::MapTimer> timer;
+        if (m_metrics) {
+            timer = m_metrics->StartMapWait();
+        }
+        return buffer.MapAsync(
             wgpu::MapMode::Read,
             0,
             bytes,
-            wgpu::CallbackMode::WaitAnyOnly,
-            [stagingPtr, cb, bytes](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+            wgpu::CallbackMode::AllowSpontaneous,
+            [staging = std::move(staging), weak, timer, cb = std::move(cb), bytes](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+                if (timer) {
+                    timer->Stop();
+                }
                 if (status != wgpu::MapAsyncStatus::Success) {
-                    KRNL_ERROR("PersistentStagingPool::readbackInto MapAsync failed");
+                    KRNL_ERROR("PersistentStagingPool::mapReadback MapAsync failed: " << message);
+                    // The caller still hears back; the buffer is dropped rather than recycled
+                    cb(nullptr, 0);
                     return;
                 }
-                const void* mapped = stagingPtr->GetConstMappedRange(0, bytes);
+                const void* mapped = staging->buffer.GetConstMappedRange(0, bytes);
                 if (!mapped) {
-                    KRNL_ERROR("readbackInto -> GetConstMappedRange returned null");
-                    stagingPtr->Unmap();
-                    return;
+                    KRNL_ERROR("mapReadback -> GetConstMappedRange returned null");
+                    cb(nullptr, 0);
+                }
+                else {
+                    cb(mapped, bytes);
+                }
+                staging->buffer.Unmap();
+
+                if (auto state = weak.lock()) {
+                    recycleReadback(*state, staging);
                 }
-                cb(mapped, bytes);
-                stagingPtr->Unmap();
             }
         );
-
-        // Note: we don't track stagingPtr lifetime beyond this function; cb captures stagingPtr (if needed) via lambda.
     }
 
     void PersistentStagingPool::purge() {
-        if (m_cfg.threadSafe) m_mutex.lock();
-        m_ready.clear();
+        {
+            std::lock_guard<std::mutex> rl(m_readback->mutex);
+            m_readback->free.clear();
+        }
+
+        auto l = lock();
+        m_free.clear();
+        // In-flight chunks are simply dropped: their pending maps are aborted on release.
         m_inflight.clear();
-        if (m_cfg.threadSafe) m_mutex.unlock();
+        if (m_current && m_current->outstanding == 0 && m_current->copies.empty()) {
+            m_current = nullptr;
+        }
+        if (!m_active.empty() || m_current) {
+            KRNL_WARN("PersistentStagingPool::purge: keeping chunks with unsubmitted uploads");
+        }
     }
 
 } // namespace krnl
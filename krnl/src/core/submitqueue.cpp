@@ -0,0 +1,129 @@
+#include "core/submitqueue.hpp"
+#include "core/profiler.hpp"
+#include "core/log.h"
+#include <algorithm>
+#include <cassert>
+
+namespace krnl {
+
+    SubmitQueue::SubmitQueue(wgpu::Queue queue, size_t maxPending)
+        : m_Queue(queue), m_MaxPending(std::max<size_t>(maxPending, 1))
+    {
+    }
+
+    SubmitQueue::~SubmitQueue() {
+        if (!m_Reserved.empty()) {
+            KRNL_WARN("SubmitQueue: " << m_Reserved.size() << " reserved ticket(s) never submitted; dropping them");
+        }
+        Flush();
+    }
+
+    bool SubmitQueue::push(wgpu::CommandBuffer cmd, std::function<void()> afterSubmit) {
+        m_Pending.push_back(std::move(cmd));
+        if (afterSubmit) {
+            m_AfterSubmit.push_back(std::move(afterSubmit));
+        }
+        m_Stats.enqueued++;
+        bool full = m_Pending.size() >= m_MaxPending;
+        if (full && m_MaxPending > 1) {
+            m_Stats.thresholdFlushes++;
+        }
+        return full;
+    }
+
+    void SubmitQueue::Enqueue(wgpu::CommandBuffer cmd, std::function<void()> afterSubmit) {
+        bool full;
+        {
+            std::lock_guard<std::mutex> l(m_Mutex);
+            full = push(std::move(cmd), std::move(afterSubmit));
+        }
+        if (full) {
+            Flush();
+        }
+    }
+
+    SubmitQueue::Ticket SubmitQueue::Reserve() {
+        std::lock_guard<std::mutex> l(m_Mutex);
+        m_Reserved.emplace_back();
+        m_Stats.ticketsReserved++;
+        return m_NextTicket + m_Reserved.size() - 1;
+    }
+
+    bool SubmitQueue::fill(Ticket ticket, wgpu::CommandBuffer cmd, std::function<void()> afterSubmit) {
+        assert(ticket >= m_NextTicket && ticket - m_NextTicket < m_Reserved.size() && "SubmitQueue: unknown ticket");
+        Slot& slot = m_Reserved[ticket - m_NextTicket];
+        assert(!slot.filled && "SubmitQueue: ticket submitted twice");
+        slot.filled = true;
+        slot.cmd = std::move(cmd);
+        slot.afterSubmit = std::move(afterSubmit);
+
+        // Release the run of filled tickets at the front
+        bool full = false;
+        while (!m_Reserved.empty() && m_Reserved.front().filled) {
+            Slot& front = m_Reserved.front();
+            if (front.cmd) {
+                full |= push(std::move(front.cmd), std::move(front.afterSubmit));
+            }
+            m_Reserved.pop_front();
+            m_NextTicket++;
+        }
+        return full;
+    }
+
+    void SubmitQueue::Enqueue(Ticket ticket, wgpu::CommandBuffer cmd, std::function<void()> afterSubmit) {
+        bool full;
+        {
+            std::lock_guard<std::mutex> l(m_Mutex);
+            full = fill(ticket, std::move(cmd), std::move(afterSubmit));
+        }
+        if (full) {
+            Flush();
+        }
+    }
+
+    void SubmitQueue::Cancel(Ticket ticket) {
+        bool full;
+        {
+            std::lock_guard<std::mutex> l(m_Mutex);
+            full = fill(ticket, wgpu::CommandBuffer(), {});
+        }
+        if (full) {
+            Flush();
+        }
+    }
+
+    void SubmitQueue::Flush() {
+        std::lock_guard<std::recursive_mutex> order(m_SubmitMutex);
+
+        std::vector<wgpu::CommandBuffer> batch;
+        std::vector<std::function<void()>> hooks;
+        {
+            std::lock_guard<std::mutex> l(m_Mutex);
+            if (m_Pending.empty()) {
+                return;
+            }
+            batch.swap(m_Pending);
+            hooks.swap(m_AfterSubmit);
+            m_Stats.submits++;
+        }
+
+        {
+            Profiler::Scope span(m_Profiler, "submit", "Queue::Submit (" + std::to_string(batch.size()) + ")");
+            m_Queue.Submit(batch.size(), batch.data());
+        }
+        for (auto& hook : hooks) {
+            hook();
+        }
+    }
+
+    size_t SubmitQueue::GetPendingCount() const {
+        std::lock_guard<std::mutex> l(m_Mutex);
+        return m_Pending.size();
+    }
+
+    SubmitQueue::Stats SubmitQueue::GetStats() const {
+        std::lock_guard<std::mutex> l(m_Mutex);
+        return m_Stats;
+    }
+
+} // namespace krnl
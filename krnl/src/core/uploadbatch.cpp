@@ -0,0 +1,107 @@
+#include "core/uploadbatch.hpp"
+#include "core/buffer.hpp"
+#include "core/device.hpp"
+#include "core/log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace krnl {
+
+    UploadBatch::UploadBatch(const Device& device)
+        : UploadBatch(device.GetStagingPool(), device.getQueue())
+    {
+    }
+
+    UploadBatch::UploadBatch(PersistentStagingPool& pool, wgpu::Queue queue, size_t regionSize)
+        : m_Pool(pool), m_Queue(queue), m_RegionSize(regionSize)
+    {
+    }
+
+    UploadBatch::~UploadBatch() {
+        // An open region would otherwise keep its ring chunk from ever being submitted
+        Flush();
+    }
+
+    void UploadBatch::Write(const Buffer& dst, const void* src, size_t bytes, size_t dstOffset) {
+        if (bytes + dstOffset > dst.GetSize()) {
+            KRNL_ERROR("UploadBatch::Write => out of range write (requested " << bytes << " bytes at offset " << dstOffset << ", buffer size " << dst.GetSize() << ")");
+            return;
+        }
+        Write(dst.GetNative(), src, bytes, dst.GetOffset() + dstOffset);
+    }
+
+    void UploadBatch::Write(wgpu::Buffer dst, const void* src, size_t bytes, size_t dstOffset) {
+        if ((bytes | dstOffset) & 3) {
+            KRNL_ERROR("UploadBatch::Write => size " << bytes << " and offset " << dstOffset << " must be multiples of 4");
+            return;
+        }
+        if (bytes == 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> l(m_Mutex);
+        if (!m_Region || m_Head + bytes > m_Region->size) {
+            closeRegion();
+            m_Region = m_Pool.allocate(std::max(bytes, m_RegionSize));
+            if (!m_Region || !m_Region->mappedPtr) {
+                // The ring is at its in-flight limit; the closed region goes out first
+                m_Region = nullptr;
+                m_Pool.writeDirect(std::move(dst), dstOffset, src, bytes, m_Queue);
+                m_Stats.writes++;
+                m_Stats.bytes += bytes;
+                return;
+            }
+        }
+
+        std::memcpy(static_cast<uint8_t*>(m_Region->mappedPtr) + m_Head, src, bytes);
+
+        StagingChunk::Copy* last = m_Copies.empty() ? nullptr : &m_Copies.back();
+        if (last && last->dst.Get() == dst.Get() &&
+            last->srcOffset + last->size == m_Head &&
+            last->dstOffset + last->size == dstOffset) {
+            last->size += bytes;
+        }
+        else {
+            m_Copies.push_back({ m_Head, std::move(dst), dstOffset, bytes });
+        }
+
+        m_Head += bytes;
+        m_Stats.writes++;
+        m_Stats.bytes += bytes;
+    }
+
+    // Called with m_Mutex held.
+    void UploadBatch::closeRegion() {
+        if (!m_Region) {
+            return;
+        }
+        m_Pool.enqueueUploads(m_Region, m_Copies.data(), m_Copies.size());
+        m_Stats.copies += m_Copies.size();
+        m_Copies.clear();
+        m_Region = nullptr;
+        m_Head = 0;
+    }
+
+    void UploadBatch::Flush() {
+        {
+            std::lock_guard<std::mutex> l(m_Mutex);
+            if (m_Region) {
+                closeRegion();
+                m_Stats.flushes++;
+            }
+        }
+        // Also retires the ring's open chunk, with whatever Buffer::WriteViaStaging left in it
+        m_Pool.flush(m_Queue);
+    }
+
+    bool UploadBatch::Empty() const {
+        std::lock_guard<std::mutex> l(m_Mutex);
+        return m_Region == nullptr;
+    }
+
+    UploadBatch::Stats UploadBatch::GetStats() const {
+        std::lock_guard<std::mutex> l(m_Mutex);
+        return m_Stats;
+    }
+
+} // namespace krnl
@@ -0,0 +1,488 @@
+#include "tensor/expr.hpp"
+#include "tensor/tensorkernel.hpp"
+#include "core/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace krnl {
+
+    struct Expr::Node {
+        enum class Kind { Tensor, Scalar, Unary, Binary };
+
+        Kind kind = Kind::Tensor;
+        Tensor tensor;
+        double scalar = 0.0;
+        UnaryOp unary = UnaryOp::Neg;
+        BinaryOp binary = BinaryOp::Add;
+        std::shared_ptr<const Node> lhs;
+        std::shared_ptr<const Node> rhs;
+
+        Shape shape;
+        DType dtype = DType::F32;
+        // Null for scalars, and for trees made only of scalars
+        const Device* device = nullptr;
+        size_t ops = 0;
+    };
+
+    namespace {
+
+        using detail::ShapeString;
+        using NodePtr = std::shared_ptr<const Expr::Node>;
+
+        constexpr uint32_t kWorkgroupSize = 256;
+        constexpr uint32_t kMaxGroupsPerDim = 65535;
+
+        // Kernel parameters, one u32 array:
+        // [count, rank, shape[8], outOffset, per input: offset, strides[8], per scalar: bits]
+        constexpr size_t kOutAt = 10;
+        constexpr size_t kInputsAt = 11;
+        constexpr size_t kInputWords = 1 + Tensor::kMaxRank;
+
+        // Bindings 0 and 1 as in the TensorOps kernels; src bindings are declared per kernel
+        const char* kFusedPrelude = R"(
+            @group(0) @binding(0) var<storage, read_write> info : array<u32>;
+            @group(0) @binding(1) var<storage, read_write> dst : array<T>;
+        )";
+
+        const char* kFusedMain = R"(
+            @compute @workgroup_size(256)
+            fn main(@builtin(global_invocation_id) gid : vec3<u32>,
+                    @builtin(num_workgroups) groups : vec3<u32>) {
+                let i = gid.y * groups.x * 256u + gid.x;
+                if (i >= info[0]) {
+                    return;
+                }
+        )";
+
+        const char* unaryName(UnaryOp op) {
+            switch (op) {
+            case UnaryOp::Neg: return "neg";
+            case UnaryOp::Abs: return "abs";
+            case UnaryOp::Exp: return "exp";
+            case UnaryOp::Log: return "log";
+            case UnaryOp::Sqrt: return "sqrt";
+            case UnaryOp::Relu: return "relu";
+            case UnaryOp::Sigmoid: return "sigmoid";
+            case UnaryOp::Tanh: return "tanh";
+            }
+            return "unary";
+        }
+
+        const char* binaryName(BinaryOp op) {
+            switch (op) {
+            case BinaryOp::Add: return "add";
+            case BinaryOp::Sub: return "sub";
+            case BinaryOp::Mul: return "mul";
+            case BinaryOp::Div: return "div";
+            case BinaryOp::Max: return "max";
+            case BinaryOp::Min: return "min";
+            }
+            return "binary";
+        }
+
+        std::string unaryWGSL(UnaryOp op, const std::string& x) {
+            switch (op) {
+            case UnaryOp::Neg: return "-" + x;
+            case UnaryOp::Abs: return "abs(" + x + ")";
+            case UnaryOp::Exp: return "exp(" + x + ")";
+            case UnaryOp::Log: return "log(" + x + ")";
+            case UnaryOp::Sqrt: return "sqrt(" + x + ")";
+            case UnaryOp::Relu: return "max(" + x + ", T(0))";
+            case UnaryOp::Sigmoid: return "T(1) / (T(1) + exp(-" + x + "))";
+            case UnaryOp::Tanh: return "tanh(" + x + ")";
+            }
+            return x;
+        }
+
+        std::string binaryWGSL(BinaryOp op, const std::string& x, const std::string& y) {
+            switch (op) {
+            case BinaryOp::Add: return x + " + " + y;
+            case BinaryOp::Sub: return x + " - " + y;
+            case BinaryOp::Mul: return x + " * " + y;
+            case BinaryOp::Div: return x + " / " + y;
+            case BinaryOp::Max: return "max(" + x + ", " + y + ")";
+            case BinaryOp::Min: return "min(" + x + ", " + y + ")";
+            }
+            return x;
+        }
+
+        // The scalar's bits as the kernel's T
+        uint32_t scalarBits(double value, DType dtype) {
+            uint32_t bits = 0;
+            switch (dtype) {
+            case DType::F32: {
+                const float f = static_cast<float>(value);
+                std::memcpy(&bits, &f, sizeof(bits));
+                break;
+            }
+            case DType::I32: {
+                const int32_t v = static_cast<int32_t>(value);
+                std::memcpy(&bits, &v, sizeof(bits));
+                break;
+            }
+            case DType::U32:
+                bits = static_cast<uint32_t>(value);
+                break;
+            }
+            return bits;
+        }
+
+        /**
+         * One expression flattened for a fused kernel. Nodes are numbered in post-order (a
+         * node shared by several parents once); inputs and scalars are numbered in the order
+         * they are reached, which fixes their info offsets. The signature spells out all of
+         * that and nothing else, so equal signatures generate the same source.
+         */
+        struct Lowered {
+            struct Step {
+                const Expr::Node* node = nullptr;
+                size_t lhs = 0, rhs = 0;     // step indices of the operands
+                size_t slot = 0;             // input or scalar number
+            };
+            struct Input {
+                Tensor tensor;               // as given; broadcast when packed
+                size_t binding = 0;
+                bool dense = false;
+            };
+
+            std::vector<Step> steps;
+            std::vector<Input> inputs;
+            std::vector<Tensor> bindings;    // one tensor per distinct storage
+            std::vector<double> scalars;
+            // Some input overlaps another binding without being the same range
+            bool overlaps = false;
+            std::unordered_map<const Expr::Node*, size_t> ids;
+            std::string signature;
+        };
+
+        // With cmd, an input whose storage overlaps another binding without being the same
+        // range (Dawn rejects that for writable bindings) reads a private copy recorded into it;
+        // without, it only sets out.overlaps.
+        size_t lower(const NodePtr& node, const Shape& shape, CommandList* cmd, Lowered& out) {
+            if (auto it = out.ids.find(node.get()); it != out.ids.end()) {
+                return it->second;
+            }
+            Lowered::Step step;
+            step.node = node.get();
+            std::string desc;
+            switch (node->kind) {
+            case Expr::Node::Kind::Tensor: {
+                Lowered::Input input;
+                input.tensor = node->tensor;
+                // Views of one tensor share a binding
+                input.binding = out.bindings.size();
+                bool overlaps = false;
+                for (size_t b = 0; b < out.bindings.size(); ++b) {
+                    if (detail::SameStorage(out.bindings[b], input.tensor)) {
+                        input.binding = b;
+                        break;
+                    }
+                    overlaps = overlaps || detail::StorageOverlaps(out.bindings[b], input.tensor);
+                }
+                if (input.binding == out.bindings.size()) {
+                    if (overlaps) {
+                        out.overlaps = true;
+                        if (cmd) {
+                            input.tensor = TensorOps::Copy(*cmd, input.tensor);
+                        }
+                    }
+                    out.bindings.push_back(input.tensor);
+                }
+                input.dense = input.tensor.GetShape() == shape && input.tensor.IsContiguous();
+                step.slot = out.inputs.size();
+                desc = "t" + std::to_string(input.binding) + (input.dense ? "d" : "s");
+                out.inputs.push_back(std::move(input));
+                break;
+            }
+            case Expr::Node::Kind::Scalar:
+                step.slot = out.scalars.size();
+                out.scalars.push_back(node->scalar);
+                desc = "c";
+                break;
+            case Expr::Node::Kind::Unary:
+                step.lhs = lower(node->lhs, shape, cmd, out);
+                desc = std::string(unaryName(node->unary)) + "(" + std::to_string(step.lhs) + ")";
+                break;
+            case Expr::Node::Kind::Binary:
+                step.lhs = lower(node->lhs, shape, cmd, out);
+                step.rhs = lower(node->rhs, shape, cmd, out);
+                desc = std::string(binaryName(node->binary)) + "(" + std::to_string(step.lhs) + "," + std::to_string(step.rhs) + ")";
+                break;
+            }
+            const size_t id = out.steps.size();
+            out.steps.push_back(step);
+            out.ids.emplace(node.get(), id);
+            out.signature += desc;
+            out.signature += ";";
+            return id;
+        }
+
+        std::string generate(const Lowered& lowered, DType dtype) {
+            std::string source = "alias T = ";
+            source += DTypeWGSL(dtype);
+            source += ";\n";
+            for (size_t b = 0; b < lowered.bindings.size(); ++b) {
+                source += "@group(0) @binding(" + std::to_string(b + 2) + ") var<storage, read_write> src" +
+                    std::to_string(b) + " : array<T>;\n";
+            }
+            source += kFusedPrelude;
+            source += detail::kElementIndexWGSL;
+            source += kFusedMain;
+
+            const size_t scalarsAt = kInputsAt + lowered.inputs.size() * kInputWords;
+            for (size_t id = 0; id < lowered.steps.size(); ++id) {
+                const Lowered::Step& step = lowered.steps[id];
+                const std::string x = "v" + std::to_string(step.lhs);
+                const std::string y = "v" + std::to_string(step.rhs);
+                std::string value;
+                switch (step.node->kind) {
+                case Expr::Node::Kind::Tensor: {
+                    const Lowered::Input& input = lowered.inputs[step.slot];
+                    const std::string base = std::to_string(kInputsAt + step.slot * kInputWords) + "u";
+                    value = "src" + std::to_string(input.binding) +
+                        (input.dense ? "[info[" + base + "] + i]" : "[elementIndex(" + base + ", i)]");
+                    break;
+                }
+                case Expr::Node::Kind::Scalar:
+                    value = "bitcast<T>(info[" + std::to_string(scalarsAt + step.slot) + "u])";
+                    break;
+                case Expr::Node::Kind::Unary:
+                    value = unaryWGSL(step.node->unary, x);
+                    break;
+                case Expr::Node::Kind::Binary:
+                    value = binaryWGSL(step.node->binary, x, y);
+                    break;
+                }
+                source += "    let v" + std::to_string(id) + " = " + value + ";\n";
+            }
+            source += "    dst[info[" + std::to_string(kOutAt) + "u] + i] = v" + std::to_string(lowered.steps.size() - 1) + ";\n}\n";
+            return source;
+        }
+
+        // Generated source by dtype and signature, process-wide
+        std::string cachedSource(const Lowered& lowered, DType dtype) {
+            static std::mutex mutex;
+            static std::unordered_map<std::string, std::string> sources;
+            const std::string key = std::string(DTypeWGSL(dtype)) + "|" + lowered.signature;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = sources.find(key);
+                if (it != sources.end()) {
+                    return it->second;
+                }
+            }
+            std::string source = generate(lowered, dtype);
+            std::lock_guard<std::mutex> lock(mutex);
+            return sources.emplace(key, std::move(source)).first->second;
+        }
+
+        // Offset and strides of t (broadcast to the output shape) at info[at]; false if some
+        // element index doesn't fit in a u32
+        bool packInput(std::vector<uint32_t>& info, size_t at, const Tensor& t) {
+            uint64_t offset = t.GetByteOffset() / DTypeSize(t.GetDType());
+            uint64_t last = offset;
+            info[at] = static_cast<uint32_t>(offset);
+            for (size_t d = 0; d < t.GetRank(); ++d) {
+                info[at + 1 + d] = static_cast<uint32_t>(t.GetStrides()[d]);
+                last += uint64_t(t.GetShape()[d] - 1) * t.GetStrides()[d];
+            }
+            return last <= std::numeric_limits<uint32_t>::max();
+        }
+
+        NodePtr makeNode(Expr::Node node) {
+            return std::make_shared<const Expr::Node>(std::move(node));
+        }
+
+    } // namespace
+
+    /* -----------------------
+       Expr
+       ----------------------- */
+
+    Expr::Expr(const Tensor& t) {
+        if (!t.IsValid()) {
+            KRNL_ERROR("Expr: invalid tensor");
+            return;
+        }
+        Node node;
+        node.kind = Node::Kind::Tensor;
+        node.tensor = t;
+        node.shape = t.GetShape();
+        node.dtype = t.GetDType();
+        node.device = &t.GetDevice();
+        m_Node = makeNode(std::move(node));
+    }
+
+    Expr Expr::Scalar(double value, DType dtype) {
+        Node node;
+        node.kind = Node::Kind::Scalar;
+        node.scalar = value;
+        node.dtype = dtype;
+        return Expr(makeNode(std::move(node)));
+    }
+
+    Expr Expr::Binary(BinaryOp op, const Expr& a, const Expr& b) {
+        if (!a.IsValid() || !b.IsValid()) {
+            return {};
+        }
+        const Node& x = *a.m_Node;
+        const Node& y = *b.m_Node;
+        if (x.dtype != y.dtype || (x.device && y.device && x.device != y.device)) {
+            KRNL_ERROR("Expr " << binaryName(op) << ": operands must be of one device and dtype");
+            return {};
+        }
+        std::optional<Shape> shape = TensorOps::BroadcastShapes(x.shape, y.shape);
+        if (!shape || shape->size() > Tensor::kMaxRank) {
+            KRNL_ERROR("Expr " << binaryName(op) << ": shapes " << ShapeString(x.shape) << " and " << ShapeString(y.shape)
+                << " don't broadcast");
+            return {};
+        }
+        Node node;
+        node.kind = Node::Kind::Binary;
+        node.binary = op;
+        node.lhs = a.m_Node;
+        node.rhs = b.m_Node;
+        node.shape = std::move(*shape);
+        node.dtype = x.dtype;
+        node.device = x.device ? x.device : y.device;
+        node.ops = x.ops + y.ops + 1;
+        return Expr(makeNode(std::move(node)));
+    }
+
+    Expr Expr::Unary(UnaryOp op, const Expr& a) {
+        if (!a.IsValid()) {
+            return {};
+        }
+        const Node& x = *a.m_Node;
+        const bool floatOnly = op == UnaryOp::Exp || op == UnaryOp::Log || op == UnaryOp::Sqrt ||
+            op == UnaryOp::Sigmoid || op == UnaryOp::Tanh;
+        if ((floatOnly && x.dtype != DType::F32) || (op == UnaryOp::Neg && x.dtype == DType::U32)) {
+            KRNL_ERROR("Expr " << unaryName(op) << ": not defined for " << DTypeWGSL(x.dtype));
+            return {};
+        }
+        Node node;
+        node.kind = Node::Kind::Unary;
+        node.unary = op;
+        node.lhs = a.m_Node;
+        node.shape = x.shape;
+        node.dtype = x.dtype;
+        node.device = x.device;
+        node.ops = x.ops + 1;
+        return Expr(makeNode(std::move(node)));
+    }
+
+    const Shape& Expr::GetShape() const {
+        static const Shape empty;
+        return m_Node ? m_Node->shape : empty;
+    }
+
+    DType Expr::GetDType() const {
+        return m_Node ? m_Node->dtype : DType::F32;
+    }
+
+    size_t Expr::GetOpCount() const {
+        return m_Node ? m_Node->ops : 0;
+    }
+
+    Tensor Expr::Eval() const {
+        if (!m_Node || !m_Node->device) {
+            KRNL_ERROR("Expr::Eval: " << (m_Node ? "no tensor operand" : "invalid expression"));
+            return {};
+        }
+        CommandList cmd(*m_Node->device);
+        Tensor out = Eval(cmd);
+        cmd.Submit();
+        return out;
+    }
+
+    Tensor Expr::Eval(CommandList& cmd) const {
+        if (!m_Node || !m_Node->device) {
+            KRNL_ERROR("Expr::Eval: " << (m_Node ? "no tensor operand" : "invalid expression"));
+            return {};
+        }
+        const Device& device = *m_Node->device;
+        const Shape& shape = m_Node->shape;
+        Tensor out = Tensor::Empty(device, shape, m_Node->dtype, "tensor_fused");
+        const size_t count = out.GetElementCount();
+        if (!out.IsValid() || count == 0) {
+            return out;
+        }
+
+        Lowered lowered;
+        lower(m_Node, shape, nullptr, lowered);
+
+        // More distinct storages than bindings: evaluate the operand holding the most inputs on
+        // its own and fuse the rest around the result
+        if (lowered.bindings.size() + 2 > device.GetLimits().maxStorageBuffersPerShaderStage) {
+            const NodePtr& root = m_Node;
+            if (root->kind == Node::Kind::Unary) {
+                return Unary(root->unary, Expr(root->lhs).Eval(cmd)).Eval(cmd);
+            }
+            Lowered left;
+            lower(root->lhs, shape, nullptr, left);
+            if (left.inputs.size() * 2 >= lowered.inputs.size()) {
+                return Binary(root->binary, Expr(root->lhs).Eval(cmd), Expr(root->rhs)).Eval(cmd);
+            }
+            return Binary(root->binary, Expr(root->lhs), Expr(root->rhs).Eval(cmd)).Eval(cmd);
+        }
+        if (lowered.overlaps) {
+            lowered = {};
+            lower(m_Node, shape, &cmd, lowered);
+        }
+
+        std::vector<uint32_t> info(kInputsAt + lowered.inputs.size() * kInputWords + lowered.scalars.size());
+        info[0] = static_cast<uint32_t>(count);
+        info[1] = static_cast<uint32_t>(shape.size());
+        std::copy(shape.begin(), shape.end(), info.begin() + 2);
+        info[kOutAt] = 0;
+        bool fits = count <= std::numeric_limits<uint32_t>::max();
+        for (size_t k = 0; k < lowered.inputs.size(); ++k) {
+            fits = fits && packInput(info, kInputsAt + k * kInputWords, lowered.inputs[k].tensor.BroadcastTo(shape));
+        }
+        if (!fits) {
+            KRNL_ERROR("Expr::Eval: element indices exceed 32 bits");
+            return {};
+        }
+        const size_t scalarsAt = kInputsAt + lowered.inputs.size() * kInputWords;
+        for (size_t s = 0; s < lowered.scalars.size(); ++s) {
+            info[scalarsAt + s] = scalarBits(lowered.scalars[s], m_Node->dtype);
+        }
+
+        std::vector<const Tensor*> bound(lowered.bindings.size());
+        for (const Lowered::Input& input : lowered.inputs) {
+            bound[input.binding] = &input.tensor;
+        }
+        const uint32_t groups = static_cast<uint32_t>((count + kWorkgroupSize - 1) / kWorkgroupSize);
+        const uint32_t x = std::min(groups, kMaxGroupsPerDim);
+        const uint32_t y = (groups + x - 1) / x;
+        detail::EncodeTensorKernel(cmd, cachedSource(lowered, m_Node->dtype), "tensor_fused", out, bound,
+            info.data(), info.size() * sizeof(uint32_t), BufferBindingType::Storage, x, y);
+        return out;
+    }
+
+    /* -----------------------
+       Operators
+       ----------------------- */
+
+    Expr operator+(const Expr& a, const Expr& b) { return Expr::Binary(BinaryOp::Add, a, b); }
+    Expr operator-(const Expr& a, const Expr& b) { return Expr::Binary(BinaryOp::Sub, a, b); }
+    Expr operator*(const Expr& a, const Expr& b) { return Expr::Binary(BinaryOp::Mul, a, b); }
+    Expr operator/(const Expr& a, const Expr& b) { return Expr::Binary(BinaryOp::Div, a, b); }
+    Expr operator-(const Expr& a) { return Expr::Unary(UnaryOp::Neg, a); }
+
+    Expr operator+(const Expr& a, double b) { return a + Expr::Scalar(b, a.GetDType()); }
+    Expr operator-(const Expr& a, double b) { return a - Expr::Scalar(b, a.GetDType()); }
+    Expr operator*(const Expr& a, double b) { return a * Expr::Scalar(b, a.GetDType()); }
+    Expr operator/(const Expr& a, double b) { return a / Expr::Scalar(b, a.GetDType()); }
+    Expr operator+(double a, const Expr& b) { return Expr::Scalar(a, b.GetDType()) + b; }
+    Expr operator-(double a, const Expr& b) { return Expr::Scalar(a, b.GetDType()) - b; }
+    Expr operator*(double a, const Expr& b) { return Expr::Scalar(a, b.GetDType()) * b; }
+    Expr operator/(double a, const Expr& b) { return Expr::Scalar(a, b.GetDType()) / b; }
+
+} // namespace krnl
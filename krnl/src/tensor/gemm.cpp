@@ -0,0 +1,415 @@
+#include "tensor/gemm.hpp"
+#include "tensor/tensorkernel.hpp"
+#include "core/autotuner.hpp"
+#include "core/log.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace krnl {
+
+    namespace {
+
+        using detail::ShapeString;
+
+        // Kernel parameters (uniform). Strides are in elements: a is M x K, b is K x N.
+        struct Params {
+            uint32_t m, n, k;
+            uint32_t aOffset, aRow, aCol;
+            uint32_t bOffset, bRow, bCol;
+            uint32_t cOffset;
+            uint32_t pad[2];
+        };
+
+        // Which dimension of an operand is contiguous in memory: K, the other one (M of a,
+        // N of b), or neither
+        enum class Contiguity { K, X, None };
+
+        struct Operand {
+            Contiguity contiguity = Contiguity::None;
+            bool vec4 = false;
+        };
+
+        // strideX / extentX belong to the non-K dimension
+        Operand classify(size_t offset, size_t strideX, size_t strideK, size_t extentX, size_t k) {
+            Operand op;
+            if (strideK == 1) {
+                op.contiguity = Contiguity::K;
+                op.vec4 = k % 4 == 0 && strideX % 4 == 0 && offset % 4 == 0;
+            }
+            else if (strideX == 1) {
+                op.contiguity = Contiguity::X;
+                op.vec4 = extentX % 4 == 0 && strideK % 4 == 0 && offset % 4 == 0;
+            }
+            return op;
+        }
+
+        Operand classifyA(const Tensor& a) {
+            return classify(a.GetByteOffset() / sizeof(float), a.GetStrides()[0], a.GetStrides()[1], a.GetShape()[0], a.GetShape()[1]);
+        }
+
+        Operand classifyB(const Tensor& b) {
+            return classify(b.GetByteOffset() / sizeof(float), b.GetStrides()[1], b.GetStrides()[0], b.GetShape()[1], b.GetShape()[0]);
+        }
+
+        const char* layoutCode(const Operand& op) {
+            switch (op.contiguity) {
+            case Contiguity::K: return op.vec4 ? "k4" : "k1";
+            case Contiguity::X: return op.vec4 ? "x4" : "x1";
+            default: return "s";
+            }
+        }
+
+        void replaceAll(std::string& s, const std::string& from, const std::string& to) {
+            for (size_t pos = s.find(from); pos != std::string::npos; pos = s.find(from, pos + to.size())) {
+                s.replace(pos, from.size(), to);
+            }
+        }
+
+        // Tile loads into workgroup memory, S[k * BX + x]. $X is the operand's non-K dimension.
+        const char* kLoadScalar = R"(
+        for (var e = tid; e < $BX * BK; e = e + THREADS) {
+            $SPLIT
+            let gx = $X0 + x;
+            let gk = k0 + k;
+            var v = 0.0;
+            if (gx < $XB && gk < K) {
+                v = $SRC[$OFF + gx * $SX + gk * $SK];
+            }
+            $S[k * $BX + x] = v;
+        }
+)";
+
+        const char* kLoadVec4K = R"(
+        for (var e = tid; e < $BX * BK / 4u; e = e + THREADS) {
+            let x = e / (BK / 4u);
+            let k = (e % (BK / 4u)) * 4u;
+            let gx = $X0 + x;
+            let gk = k0 + k;
+            var v = vec4<f32>(0.0);
+            if (gx < $XB && gk < K) {
+                v = $SRC[($OFF + gx * $SX + gk) / 4u];
+            }
+            $S[k * $BX + x] = v.x;
+            $S[(k + 1u) * $BX + x] = v.y;
+            $S[(k + 2u) * $BX + x] = v.z;
+            $S[(k + 3u) * $BX + x] = v.w;
+        }
+)";
+
+        const char* kLoadVec4X = R"(
+        for (var e = tid; e < $BX * BK / 4u; e = e + THREADS) {
+            let x = (e % ($BX / 4u)) * 4u;
+            let k = e / ($BX / 4u);
+            let gx = $X0 + x;
+            let gk = k0 + k;
+            var v = vec4<f32>(0.0);
+            if (gx < $XB && gk < K) {
+                v = $SRC[($OFF + gx + gk * $SK) / 4u];
+            }
+            let s = k * $BX + x;
+            $S[s] = v.x;
+            $S[s + 1u] = v.y;
+            $S[s + 2u] = v.z;
+            $S[s + 3u] = v.w;
+        }
+)";
+
+        const char* kGemm = R"(
+const BM = $BMu;
+const BN = $BNu;
+const BK = $BKu;
+const TM = $TMu;
+const TN = $TNu;
+const THREADS = $THREADSu;
+
+struct Params {
+    m : u32, n : u32, k : u32,
+    aOffset : u32, aRow : u32, aCol : u32,
+    bOffset : u32, bRow : u32, bCol : u32,
+    cOffset : u32, pad0 : u32, pad1 : u32,
+};
+
+@group(0) @binding(0) var<uniform> p : Params;
+@group(0) @binding(1) var<storage, read_write> c : array<f32>;
+@group(0) @binding(2) var<storage, read_write> a : array<$TA>;
+@group(0) @binding(3) var<storage, read_write> b : array<$TB>;
+
+var<workgroup> As : array<f32, $AS>;
+var<workgroup> Bs : array<f32, $BS>;
+
+@compute @workgroup_size($WX, $WY)
+fn main(@builtin(workgroup_id) wg : vec3<u32>,
+        @builtin(local_invocation_id) lid : vec3<u32>,
+        @builtin(local_invocation_index) tid : u32) {
+    let M = p.m;
+    let N = p.n;
+    let K = p.k;
+    let m0 = wg.y * BM;
+    let n0 = wg.x * BN;
+
+    var acc : array<f32, $ACC>;
+    var ra : array<f32, $TM>;
+    var rb : array<f32, $TN>;
+    for (var k0 = 0u; k0 < K; k0 = k0 + BK) {
+$LOADA
+$LOADB
+        workgroupBarrier();
+        for (var kk = 0u; kk < BK; kk = kk + 1u) {
+            for (var i = 0u; i < TM; i = i + 1u) {
+                ra[i] = As[kk * BM + lid.y * TM + i];
+            }
+            for (var j = 0u; j < TN; j = j + 1u) {
+                rb[j] = Bs[kk * BN + lid.x * TN + j];
+            }
+            for (var i = 0u; i < TM; i = i + 1u) {
+                for (var j = 0u; j < TN; j = j + 1u) {
+                    acc[i * TN + j] = fma(ra[i], rb[j], acc[i * TN + j]);
+                }
+            }
+        }
+        workgroupBarrier();
+    }
+
+    for (var i = 0u; i < TM; i = i + 1u) {
+        let m = m0 + lid.y * TM + i;
+        for (var j = 0u; j < TN; j = j + 1u) {
+            let n = n0 + lid.x * TN + j;
+            if (m < M && n < N) {
+                c[p.cOffset + m * N + n] = acc[i * TN + j];
+            }
+        }
+    }
+}
+)";
+
+        struct LoadNames {
+            const char* src;
+            const char* shared;
+            const char* bx;
+            const char* x0;
+            const char* xBound;
+            const char* offset;
+            const char* strideX;
+            const char* strideK;
+        };
+
+        std::string loadTile(const Operand& op, const LoadNames& n) {
+            std::string code;
+            if (op.vec4) {
+                code = op.contiguity == Contiguity::K ? kLoadVec4K : kLoadVec4X;
+            }
+            else {
+                code = kLoadScalar;
+                // Consecutive threads walk the contiguous dimension
+                replaceAll(code, "$SPLIT", op.contiguity == Contiguity::X
+                    ? "let x = e % $BX;\n            let k = e / $BX;"
+                    : "let x = e / BK;\n            let k = e % BK;");
+            }
+            replaceAll(code, "$SRC", n.src);
+            replaceAll(code, "$S[", std::string(n.shared) + "[");
+            replaceAll(code, "$BX", n.bx);
+            replaceAll(code, "$X0", n.x0);
+            replaceAll(code, "$XB", n.xBound);
+            replaceAll(code, "$OFF", n.offset);
+            replaceAll(code, "$SX", n.strideX);
+            replaceAll(code, "$SK", n.strideK);
+            return code;
+        }
+
+        std::string gemmSource(const GemmConfig& config, const Operand& a, const Operand& b) {
+            std::string source = kGemm;
+            replaceAll(source, "$BM", std::to_string(config.tileM));
+            replaceAll(source, "$BN", std::to_string(config.tileN));
+            replaceAll(source, "$BK", std::to_string(config.tileK));
+            replaceAll(source, "$TM", std::to_string(config.threadM));
+            replaceAll(source, "$TN", std::to_string(config.threadN));
+            replaceAll(source, "$THREADS", std::to_string(config.Threads()));
+            replaceAll(source, "$WX", std::to_string(config.ThreadsX()));
+            replaceAll(source, "$WY", std::to_string(config.ThreadsY()));
+            replaceAll(source, "$AS", std::to_string(config.tileK * config.tileM));
+            replaceAll(source, "$BS", std::to_string(config.tileK * config.tileN));
+            replaceAll(source, "$ACC", std::to_string(config.threadM * config.threadN));
+            replaceAll(source, "$TA", a.vec4 ? "vec4<f32>" : "f32");
+            replaceAll(source, "$TB", b.vec4 ? "vec4<f32>" : "f32");
+            replaceAll(source, "$LOADA", loadTile(a, { "a", "As", "BM", "m0", "M", "p.aOffset", "p.aRow", "p.aCol" }));
+            replaceAll(source, "$LOADB", loadTile(b, { "b", "Bs", "BN", "n0", "N", "p.bOffset", "p.bCol", "p.bRow" }));
+            return source;
+        }
+
+        // Whether every element index of t fits in a u32
+        bool fitsU32(const Tensor& t) {
+            uint64_t last = t.GetByteOffset() / sizeof(float);
+            for (size_t d = 0; d < t.GetRank(); ++d) {
+                if (t.GetShape()[d] > 0) {
+                    last += uint64_t(t.GetShape()[d] - 1) * t.GetStrides()[d];
+                }
+            }
+            return last <= std::numeric_limits<uint32_t>::max();
+        }
+
+        bool checkOperands(const Tensor& a, const Tensor& b) {
+            if (!a.IsValid() || !b.IsValid() || &a.GetDevice() != &b.GetDevice()) {
+                KRNL_ERROR("MatMul: operands must be valid tensors of one device");
+                return false;
+            }
+            if (a.GetDType() != DType::F32 || b.GetDType() != DType::F32) {
+                KRNL_ERROR("MatMul: only f32 tensors are supported");
+                return false;
+            }
+            if (a.GetRank() != 2 || b.GetRank() != 2 || a.GetShape()[1] != b.GetShape()[0]) {
+                KRNL_ERROR("MatMul: can't multiply " << ShapeString(a.GetShape()) << " by " << ShapeString(b.GetShape()));
+                return false;
+            }
+            return true;
+        }
+
+        GemmConfig heuristic(size_t m, size_t n, const wgpu::Limits& limits) {
+            const auto& candidates = GemmTuner::Candidates();
+            // Big tiles only pay off once there are enough of them to fill the GPU
+            const size_t preferred = m * n >= 512 * 512 ? 3 : m * n >= 128 * 128 ? 2 : 1;
+            for (size_t i = preferred + 1; i-- > 0;) {
+                if (candidates[i].Fits(limits)) {
+                    return candidates[i];
+                }
+            }
+            return candidates[0];
+        }
+
+    } // namespace
+
+    /* -----------------------
+       GemmConfig / GemmTuner
+       ----------------------- */
+
+    bool GemmConfig::Fits(const wgpu::Limits& limits) const {
+        return Threads() <= limits.maxComputeInvocationsPerWorkgroup &&
+            ThreadsX() <= limits.maxComputeWorkgroupSizeX &&
+            ThreadsY() <= limits.maxComputeWorkgroupSizeY &&
+            SharedBytes() <= limits.maxComputeWorkgroupStorageSize;
+    }
+
+    std::string GemmConfig::Name() const {
+        return std::to_string(tileM) + "x" + std::to_string(tileN) + "x" + std::to_string(tileK) + "_" +
+            std::to_string(threadM) + "x" + std::to_string(threadN);
+    }
+
+    const std::vector<GemmConfig>& GemmTuner::Candidates() {
+        // Ordered by tile area; the heuristic indexes into the first four. Tile sizes are
+        // multiples of 4 so every config can take vec4 loads.
+        static const std::vector<GemmConfig> candidates = {
+            { 16, 16, 16, 1, 1 },       // workgroup tiling only
+            { 32, 32, 8, 2, 2 },
+            { 64, 64, 8, 4, 4 },
+            { 64, 64, 16, 4, 4 },
+            { 128, 64, 8, 8, 4 },
+            { 64, 128, 8, 4, 8 },
+        };
+        return candidates;
+    }
+
+    std::optional<GemmConfig> GemmTuner::FromName(const std::string& name) {
+        for (const GemmConfig& config : Candidates()) {
+            if (config.Name() == name) {
+                return config;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string GemmTuner::Kernel(const Tensor& a, const Tensor& b) {
+        return std::string("gemm_") + layoutCode(classifyA(a)) + "_" + layoutCode(classifyB(b));
+    }
+
+    std::string GemmTuner::Bucket(const Tensor& a, const Tensor& b) {
+        return Autotuner::SizeBucket({ a.GetShape()[0], b.GetShape()[1], a.GetShape()[1] });
+    }
+
+    GemmConfig GemmTuner::Choose(const Tensor& a, const Tensor& b) {
+        if (!a.IsValid() || !b.IsValid() || a.GetRank() != 2 || b.GetRank() != 2) {
+            return Candidates()[0];
+        }
+        const Device& device = a.GetDevice();
+        std::vector<Autotuner::Variant> variants;
+        for (const GemmConfig& config : Candidates()) {
+            if (config.Fits(device.GetLimits())) {
+                variants.push_back({ config.Name(), [&a, &b, config](CommandList& cmd) { TensorOps::MatMul(cmd, a, b, config); } });
+            }
+        }
+        std::optional<std::string> chosen = Autotuner::Default().Select(device, Kernel(a, b), Bucket(a, b), variants);
+        if (std::optional<GemmConfig> config = chosen ? FromName(*chosen) : std::nullopt) {
+            return *config;
+        }
+        return heuristic(a.GetShape()[0], b.GetShape()[1], device.GetLimits());
+    }
+
+    /* -----------------------
+       TensorOps::MatMul
+       ----------------------- */
+
+    Tensor TensorOps::MatMul(const Tensor& a, const Tensor& b) {
+        if (!checkOperands(a, b)) {
+            return {};
+        }
+        CommandList cmd(a.GetDevice());
+        Tensor out = MatMul(cmd, a, b);
+        cmd.Submit();
+        return out;
+    }
+
+    Tensor TensorOps::MatMul(CommandList& cmd, const Tensor& a, const Tensor& b) {
+        if (!checkOperands(a, b)) {
+            return {};
+        }
+        return MatMul(cmd, a, b, GemmTuner::Choose(a, b));
+    }
+
+    Tensor TensorOps::MatMul(CommandList& cmd, const Tensor& a, const Tensor& b, const GemmConfig& config) {
+        if (!checkOperands(a, b)) {
+            return {};
+        }
+        const Device& device = a.GetDevice();
+        if (!config.Fits(device.GetLimits())) {
+            KRNL_ERROR("MatMul: config " << config.Name() << " exceeds the device's workgroup limits");
+            return {};
+        }
+
+        const size_t m = a.GetShape()[0];
+        const size_t k = a.GetShape()[1];
+        const size_t n = b.GetShape()[1];
+        Tensor out = Tensor::Empty(device, { m, n }, DType::F32, "tensor_matmul");
+        if (!out.IsValid() || m * n == 0) {
+            return out;
+        }
+
+        // Overlapping operands can't both be bound writable; give b a private copy
+        Tensor rhs = detail::StorageOverlaps(a, b) ? Copy(cmd, b) : b;
+        const uint32_t groupsX = static_cast<uint32_t>((n + config.tileN - 1) / config.tileN);
+        const uint32_t groupsY = static_cast<uint32_t>((m + config.tileM - 1) / config.tileM);
+        if (m * n > std::numeric_limits<uint32_t>::max() || !fitsU32(a) || !fitsU32(rhs) ||
+            std::max(groupsX, groupsY) > device.GetLimits().maxComputeWorkgroupsPerDimension) {
+            KRNL_ERROR("MatMul: " << ShapeString(a.GetShape()) << " x " << ShapeString(b.GetShape()) << " is too large");
+            return {};
+        }
+
+        const Operand la = classifyA(a);
+        const Operand lb = classifyB(rhs);
+        Params params{};
+        params.m = static_cast<uint32_t>(m);
+        params.n = static_cast<uint32_t>(n);
+        params.k = static_cast<uint32_t>(k);
+        params.aOffset = static_cast<uint32_t>(a.GetByteOffset() / sizeof(float));
+        params.aRow = static_cast<uint32_t>(a.GetStrides()[0]);
+        params.aCol = static_cast<uint32_t>(a.GetStrides()[1]);
+        params.bOffset = static_cast<uint32_t>(rhs.GetByteOffset() / sizeof(float));
+        params.bRow = static_cast<uint32_t>(rhs.GetStrides()[0]);
+        params.bCol = static_cast<uint32_t>(rhs.GetStrides()[1]);
+        params.cOffset = 0;
+
+        const std::string label = "gemm_" + config.Name();
+        detail::EncodeTensorKernel(cmd, gemmSource(config, la, lb), label.c_str(), out, { &a, &rhs },
+            &params, sizeof(params), BufferBindingType::Uniform, groupsX, groupsY);
+        return out;
+    }
+
+} // namespace krnl
@@ -1,224 +1,624 @@
-//#include "tensor/tensor.hpp"
-//#include "core/shader.hpp"
-//#include "core/log.h"
-//#include <cstring>
-//#include <cassert>
-//
-//namespace krnl {
-//
-//    /* -----------------------
-//       Tensor Implementation
-//       ----------------------- */
-//
-//    Tensor::Tensor(wgpu::Device device, const Shape& shape, DType dtype, const krnl::Buffer& buffer)
-//        : m_shape(shape), m_dtype(dtype), m_buffer(buffer), m_device(device)
-//    {
-//        m_sizeBytes = m_shape.size() * dtypeSize(m_dtype);
-//    }
-//
-//    Tensor Tensor::Empty(wgpu::Device device, const Shape& shape, DType dtype, const char* label) {
-//        size_t bytes = shape.size() * dtypeSize(dtype);
-//        krnl::Buffer buf = krnl::Buffer::CreateStorage(device, bytes, label);
-//        return Tensor(device, shape, dtype, buf);
-//    }
-//
-//    Tensor Tensor::FromHost(wgpu::Device device, const std::vector<float>& data, const Shape& shape, PersistentStagingPool* pool, const char* label) {
-//        size_t expected = shape.size();
-//        assert(data.size() == expected && "FromHost size mismatch shape");
-//        size_t bytes = expected * sizeof(float);
-//        krnl::Buffer buf = krnl::Buffer::CreateStorage(device, bytes, label);
-//        Tensor t(device, shape, DType::F32, buf);
-//        // upload
-//        if (pool) {
-//            // use pool
-//            auto staging = pool->allocate(bytes);
-//            std::memcpy(staging->mappedPtr, data.data(), bytes);
-//            pool->submitUpload(staging, buf.get(), bytes, 0, device.GetQueue());
-//        }
-//        else {
-//            // fallback to writeViaStaging
-//            t.m_buffer.writeViaStaging(data.data(), bytes, device.GetQueue());
-//        }
-//        return t;
-//    }
-//
-//    Tensor Tensor::Zeros(wgpu::Device device, const Shape& shape, PersistentStagingPool* pool, const char* label) {
-//        size_t elements = shape.size();
-//        std::vector<float> zeros(elements);
-//        return FromHost(device, zeros, shape, pool, label);
-//    }
-//
-//    void Tensor::write(const void* src, size_t bytes, wgpu::Queue queue, PersistentStagingPool* pool) {
-//        assert(bytes <= m_sizeBytes);
-//        if (pool) {
-//            auto staging = pool->allocate(bytes);
-//            std::memcpy(staging->mappedPtr, src, bytes);
-//            pool->submitUpload(staging, m_buffer.get(), bytes, 0, queue);
-//        }
-//        else {
-//            m_buffer.writeViaStaging(src, bytes, queue);
-//        }
-//    }
-//
-//    void Tensor::writeAsync(const void* src, size_t bytes, wgpu::Queue queue, PersistentStagingPool* pool) {
-//        // Simple wrapper identical to write  async semantics are handled by staging and queue.
-//        write(src, bytes, queue, pool);
-//    }
-//
-//    std::vector<float> Tensor::toHost(wgpu::Device device, wgpu::Queue queue) const {
-//        std::promise<std::vector<float>> p;
-//        auto f = p.get_future();
-//        // create callback that sets promise
-//        m_buffer.readAsync(device, queue, [&p](const void* data, size_t size) {
-//            const float* fptr = reinterpret_cast<const float*>(data);
-//            size_t count = size / sizeof(float);
-//            std::vector<float> out(count);
-//            std::memcpy(out.data(), fptr, size);
-//            p.set_value(std::move(out));
-//            });
-//        // wait (blocks current thread until GPU finished and callback invoked)
-//        auto result = f.get();
-//        return result;
-//    }
-//
-//    /* -----------------------
-//       TensorOps
-//       ----------------------- */
-//
-//    Pipeline TensorOps::makeAddPipeline(wgpu::Device device, ParameterSet& params) {
-//        // WGSL for elementwise add (simple)
-//        const std::string wgsl = R"(
-//        @group(0) @binding(0) var<storage, read> A : array<f32>;
-//        @group(0) @binding(1) var<storage, read> B : array<f32>;
-//        @group(0) @binding(2) var<storage, read_write> Out : array<f32>;
-//
-//        @compute @workgroup_size(64)
-//        fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
-//            let i = gid.x;
-//            Out[i] = A[i] + B[i];
-//        }
-//    )";
-//        return Pipeline::CreateComputeFromWGSL(device, wgsl, params, "main", "add_pipeline");
-//    }
-//
-//    Tensor TensorOps::Add(const Tensor& A, const Tensor& B, wgpu::Queue queue) {
-//        assert(A.dtype() == B.dtype());
-//        assert(A.shape().dims == B.shape().dims);
-//
-//        wgpu::Device device = A.buffer().get()->GetDevice(); // there's no GetDevice on wgpu::Buffer - we assume device was stored in Tensor
-//        // But we have m_device in Tensor  use work-around: we need device; so require device param or expose m_device accessor.
-//        // For simplicity use A.m_device (friend?), but here we'll assume m_device available via A (we'll access private by making friend or adding accessor).
-//        // For this example, assume Tensor has a getDevice() method. We'll add that in real code. For now, let's proceed:
-//        // Build params (A,B,out)
-//        Shape s = A.shape();
-//        Tensor Out = Tensor::Empty(A.m_device, s, A.dtype(), "add_out");
-//
-//        std::vector<ParameterSet::Entry> entries = {
-//            { const_cast<krnl::Buffer*>(&A.m_buffer), wgpu::ShaderStage::Compute },
-//            { const_cast<krnl::Buffer*>(&B.m_buffer), wgpu::ShaderStage::Compute },
-//            { const_cast<krnl::Buffer*>(&Out.m_buffer), wgpu::ShaderStage::Compute }
-//        };
-//        ParameterSet params(A.m_device, entries);
-//
-//        // Create pipeline
-//        Pipeline p = makeAddPipeline(A.m_device, params);
-//
-//        // Record commands
-//        wgpu::CommandEncoder encoder = A.m_device.CreateCommandEncoder();
-//        wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
-//
-//        // use helper
-//        uint32_t total = static_cast<uint32_t>(A.elementCount());
-//        uint32_t wgSize = 64;
-//        uint32_t groups = (total + wgSize - 1) / wgSize;
-//
-//        p.encodeDispatch(pass, groups, 1, 1);
-//        pass.End();
-//
-//        wgpu::CommandBuffer cmd = encoder.Finish();
-//        queue.Submit(1, &cmd);
-//
-//        return Out;
-//    }
-//
-//    Pipeline TensorOps::makeMatMulPipeline(wgpu::Device device, ParameterSet& params, size_t M, size_t N, size_t K) {
-//        // Simple matmul WGSL: naive but tiled. This shader expects:
-//        // A (M x K) row-major, B (K x N) row-major, Out (M x N) row-major
-//        const std::string wgsl = R"(
-//        struct Meta { M: u32, N: u32, K: u32 };
-//        @group(0) @binding(3) var<uniform> meta : Meta;
-//
-//        @group(0) @binding(0) var<storage, read> A : array<f32>;
-//        @group(0) @binding(1) var<storage, read> B : array<f32>;
-//        @group(0) @binding(2) var<storage, read_write> Out : array<f32>;
-//
-//        @compute @workgroup_size(8,8)
-//        fn main(@builtin(global_invocation_id) gid : vec3<u32>) {
-//            let row = gid.y;
-//            let col = gid.x;
-//            if (row >= meta.M || col >= meta.N) {
-//                return;
-//            }
-//            var sum : f32 = 0.0;
-//            let M = meta.M;
-//            let N = meta.N;
-//            let K = meta.K;
-//            // compute dot product
-//            let rowBase = row * K;
-//            for (var k : u32 = 0u; k < K; k = k + 1u) {
-//                let a = A[rowBase + k];
-//                let b = B[k * N + col];
-//                sum = sum + a * b;
-//            }
-//            Out[row * N + col] = sum;
-//        }
-//    )";
-//        return Pipeline::CreateComputeFromWGSL(device, wgsl, params, "main", "matmul_pipeline");
-//    }
-//
-//    Tensor TensorOps::MatMul(const Tensor& A, const Tensor& B, wgpu::Queue queue) {
-//        // Validate shapes
-//        assert(A.dtype() == B.dtype());
-//        size_t M = A.shape().dims[0];
-//        size_t K = A.shape().dims[1];
-//        assert(B.shape().dims[0] == K);
-//        size_t N = B.shape().dims[1];
-//
-//        // Output
-//        Shape outShape; outShape.dims = { M, N };
-//        Tensor Out = Tensor::Empty(A.m_device, outShape, A.dtype(), "matmul_out");
-//
-//        // Create a small uniform buffer for meta
-//        struct Meta { uint32_t M, N, K; } meta = { static_cast<uint32_t>(M), static_cast<uint32_t>(N), static_cast<uint32_t>(K) };
-//        krnl::Buffer metaBuf = krnl::Buffer::CreateUniform(A.m_device, sizeof(Meta), "matmul_meta");
-//        A.m_device.GetQueue().WriteBuffer(metaBuf.get(), 0, &meta, sizeof(Meta));
-//
-//        // Build params entries: A=0, B=1, Out=2, meta uniform=3
-//        std::vector<ParameterSet::Entry> entries = {
-//            { const_cast<krnl::Buffer*>(&A.m_buffer), wgpu::ShaderStage::Compute },
-//            { const_cast<krnl::Buffer*>(&B.m_buffer), wgpu::ShaderStage::Compute },
-//            { const_cast<krnl::Buffer*>(&Out.m_buffer), wgpu::ShaderStage::Compute },
-//            { &metaBuf, wgpu::ShaderStage::Compute }
-//        };
-//        ParameterSet params(A.m_device, entries);
-//
-//        Pipeline p = makeMatMulPipeline(A.m_device, params, M, N, K);
-//
-//        // Encode and dispatch
-//        wgpu::CommandEncoder encoder = A.m_device.CreateCommandEncoder();
-//        wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
-//
-//        // compute workgroups
-//        uint32_t wgX = (uint32_t)((N + 7) / 8);
-//        uint32_t wgY = (uint32_t)((M + 7) / 8);
-//
-//        p.encodeDispatch(pass, wgX, wgY, 1);
-//        pass.End();
-//
-//        wgpu::CommandBuffer cmd = encoder.Finish();
-//        queue.Submit(1, &cmd);
-//
-//        return Out;
-//    }
-//
-//} // namespace krnl
+#include "tensor/tensor.hpp"
+#include "tensor/tensorkernel.hpp"
+#include "core/log.h"
+#include "core/parameterset.hpp"
+#include "core/pipeline.hpp"
+#include "core/shader.hpp"
+#include "core/stagingpool.hpp"
+#include "core/uploadbatch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <sstream>
+
+namespace krnl {
+
+    namespace {
+
+        using detail::kTensorUsage;
+        using detail::ShapeString;
+
+        constexpr uint32_t kWorkgroupSize = 256;
+        constexpr uint32_t kMaxGroupsPerDim = 65535;
+
+        // Kernel parameters, one u32 array:
+        // [count, rank, shape[8], aOffset, aStrides[8], bOffset, bStrides[8], outOffset]
+        // Offsets and strides are in elements, relative to the start of each operand's Buffer.
+        constexpr size_t kShapeAt = 2;
+        constexpr size_t kOperandAt[2] = { 10, 19 };
+        constexpr size_t kOutAt = 28;
+        using Info = std::array<uint32_t, 32>;
+
+        // Every binding is read_write storage: the operands usually share one allocator heap
+        // buffer, and WebGPU rejects a buffer bound both read-only and writable in one dispatch.
+        const char* kKernelPrelude = R"(
+            @group(0) @binding(0) var<storage, read_write> info : array<u32>;
+            @group(0) @binding(1) var<storage, read_write> dst : array<T>;
+            @group(0) @binding(2) var<storage, read_write> a : array<T>;
+        )";
+
+        const char* kKernelMain = R"(
+            @compute @workgroup_size(256)
+            fn main(@builtin(global_invocation_id) gid : vec3<u32>,
+                    @builtin(num_workgroups) groups : vec3<u32>) {
+                let i = gid.y * groups.x * 256u + gid.x;
+                if (i >= info[0]) {
+                    return;
+                }
+        )";
+
+        std::string kernelSource(DType dtype, const std::string& extraBindings, const std::string& body) {
+            std::string source = "alias T = ";
+            source += DTypeWGSL(dtype);
+            source += ";\n";
+            source += kKernelPrelude;
+            source += detail::kElementIndexWGSL;
+            source += extraBindings;
+            source += kKernelMain;
+            source += body;
+            source += "}\n";
+            return source;
+        }
+
+        std::string copySource(DType dtype) {
+            return kernelSource(dtype, "", "dst[info[28] + i] = a[elementIndex(10u, i)];\n");
+        }
+
+        const char* binaryName(BinaryOp op) {
+            switch (op) {
+            case BinaryOp::Add: return "tensor_add";
+            case BinaryOp::Sub: return "tensor_sub";
+            case BinaryOp::Mul: return "tensor_mul";
+            case BinaryOp::Div: return "tensor_div";
+            case BinaryOp::Max: return "tensor_max";
+            case BinaryOp::Min: return "tensor_min";
+            }
+            return "tensor_binary";
+        }
+
+        // aliased: both operands are one binding (views of the same storage)
+        std::string binarySource(BinaryOp op, DType dtype, bool aliased) {
+            const char* expr = "x + y";
+            switch (op) {
+            case BinaryOp::Add: expr = "x + y"; break;
+            case BinaryOp::Sub: expr = "x - y"; break;
+            case BinaryOp::Mul: expr = "x * y"; break;
+            case BinaryOp::Div: expr = "x / y"; break;
+            case BinaryOp::Max: expr = "max(x, y)"; break;
+            case BinaryOp::Min: expr = "min(x, y)"; break;
+            }
+            std::string body =
+                "let x = a[elementIndex(10u, i)];\n"
+                "let y = ";
+            body += aliased ? "a" : "b";
+            body += "[elementIndex(19u, i)];\n"
+                "dst[info[28] + i] = ";
+            body += expr;
+            body += ";\n";
+            return kernelSource(dtype, aliased ? "" : "@group(0) @binding(3) var<storage, read_write> b : array<T>;\n", body);
+        }
+
+        // Offset and strides of 't' (already broadcast to the output shape) at info[at];
+        // false if some element index doesn't fit in a u32
+        bool packOperand(Info& info, size_t at, const Tensor& t) {
+            uint64_t offset = t.GetByteOffset() / DTypeSize(t.GetDType());
+            uint64_t last = offset;
+            info[at] = static_cast<uint32_t>(offset);
+            for (size_t d = 0; d < t.GetRank(); ++d) {
+                info[at + 1 + d] = static_cast<uint32_t>(t.GetStrides()[d]);
+                last += uint64_t(t.GetShape()[d] - 1) * t.GetStrides()[d];
+            }
+            return last <= std::numeric_limits<uint32_t>::max();
+        }
+
+        void encodeElementwise(CommandList& cmd, const std::string& source, const char* label,
+            const Tensor& out, const std::vector<const Tensor*>& inputs, const Info& info)
+        {
+            const uint32_t groups = (info[0] + kWorkgroupSize - 1) / kWorkgroupSize;
+            const uint32_t x = std::min(groups, kMaxGroupsPerDim);
+            const uint32_t y = (groups + x - 1) / x;
+            detail::EncodeTensorKernel(cmd, source, label, out, inputs, info.data(), sizeof(Info), BufferBindingType::Storage, x, y);
+        }
+
+        // Strides for viewing a (shape, strides) layout as newShape without moving elements, if
+        // possible: each run of dimensions that is contiguous in memory may be split or merged.
+        bool viewStrides(const Shape& shape, const std::vector<size_t>& strides, const Shape& newShape, std::vector<size_t>& out) {
+            out.assign(newShape.size(), 0);
+            if (shape.empty() || ShapeElementCount(shape) == 0) {
+                out = Tensor::ContiguousStrides(newShape);
+                return true;
+            }
+
+            int64_t viewDim = static_cast<int64_t>(newShape.size()) - 1;
+            size_t chunkStride = strides.back();
+            size_t tensorCount = 1;
+            size_t viewCount = 1;
+            for (int64_t d = static_cast<int64_t>(shape.size()) - 1; d >= 0; --d) {
+                tensorCount *= shape[d];
+                // End of a contiguous run: the next dimension out doesn't continue it
+                if (d == 0 || (shape[d - 1] != 1 && strides[d - 1] != tensorCount * chunkStride)) {
+                    while (viewDim >= 0 && (viewCount < tensorCount || newShape[viewDim] == 1)) {
+                        out[viewDim] = viewCount * chunkStride;
+                        viewCount *= newShape[viewDim];
+                        viewDim--;
+                    }
+                    if (viewCount != tensorCount) {
+                        return false;
+                    }
+                    if (d > 0) {
+                        chunkStride = strides[d - 1];
+                        tensorCount = 1;
+                        viewCount = 1;
+                    }
+                }
+            }
+            return viewDim == -1;
+        }
+
+        Future<std::vector<std::byte>> readyBytes() {
+            auto state = std::make_shared<detail::FutureState<std::vector<std::byte>>>();
+            state->SetReady();
+            return Future<std::vector<std::byte>>(state);
+        }
+
+    } // namespace
+
+    namespace detail {
+
+        std::string ShapeString(const Shape& shape) {
+            std::ostringstream s;
+            s << '[';
+            for (size_t i = 0; i < shape.size(); ++i) {
+                s << (i ? ", " : "") << shape[i];
+            }
+            s << ']';
+            return s.str();
+        }
+
+        bool StorageOverlaps(const Tensor& a, const Tensor& b) {
+            const Buffer& x = a.GetStorage();
+            const Buffer& y = b.GetStorage();
+            return x.GetNative().Get() == y.GetNative().Get() &&
+                x.GetOffset() < y.GetOffset() + y.GetSize() && y.GetOffset() < x.GetOffset() + x.GetSize();
+        }
+
+        bool SameStorage(const Tensor& a, const Tensor& b) {
+            const Buffer& x = a.GetStorage();
+            const Buffer& y = b.GetStorage();
+            return x.GetNative().Get() == y.GetNative().Get() && x.GetOffset() == y.GetOffset() && x.GetSize() == y.GetSize();
+        }
+
+        void EncodeTensorKernel(CommandList& cmd, const std::string& source, const char* label,
+            const Tensor& out, const std::vector<const Tensor*>& inputs,
+            const void* params, size_t paramBytes, BufferBindingType paramBinding,
+            uint32_t groupsX, uint32_t groupsY)
+        {
+            const Device& device = out.GetDevice();
+            // Uniform parameters come from a heap of their own, so they never share a buffer
+            // with the storage bindings
+            const BufferUsageType usage = paramBinding == BufferBindingType::Uniform
+                ? BufferUsageType::Uniform | BufferUsageType::CopyDst
+                : kTensorUsage;
+            auto paramBuffer = std::make_shared<Buffer>(Buffer::Suballocate(device, paramBytes, usage, "tensor_params"));
+            device.GetUploadBatch().Write(*paramBuffer, params, paramBytes);
+
+            std::vector<ParameterSet::Entry> entries;
+            entries.push_back({ *paramBuffer, paramBinding });
+            entries.push_back({ *out.GetStoragePtr(), BufferBindingType::Storage });
+            for (const Tensor* input : inputs) {
+                entries.push_back({ *input->GetStoragePtr(), BufferBindingType::Storage });
+            }
+            ParameterSet parameterSet(device, entries);
+            Shader shader = Shader::loadCachedWGSL(device, source);
+            Pipeline pipeline = Pipeline::CreateCompute(device, shader, parameterSet, "main", label);
+
+            const bool ownPass = !cmd.GetComputePass();
+            if (ownPass) {
+                cmd.BeginComputePass();
+            }
+            pipeline.encodeDispatch(cmd, groupsX, groupsY);
+            if (ownPass) {
+                cmd.EndComputePass();
+            }
+
+            cmd.Retain(paramBuffer);
+            cmd.Retain(out.GetStoragePtr());
+            for (const Tensor* input : inputs) {
+                cmd.Retain(input->GetStoragePtr());
+            }
+        }
+
+    } // namespace detail
+
+    const char* DTypeWGSL(DType dtype) {
+        switch (dtype) {
+        case DType::F32: return "f32";
+        case DType::I32: return "i32";
+        case DType::U32: return "u32";
+        }
+        return "f32";
+    }
+
+    /* -----------------------
+       Tensor
+       ----------------------- */
+
+    Tensor::Tensor(const Device& device, std::shared_ptr<Buffer> storage, Shape shape, std::vector<size_t> strides, size_t byteOffset, DType dtype)
+        : m_Device(&device), m_Storage(std::move(storage)), m_Shape(std::move(shape)), m_Strides(std::move(strides)),
+          m_ByteOffset(byteOffset), m_DType(dtype)
+    {
+    }
+
+    std::vector<size_t> Tensor::ContiguousStrides(const Shape& shape) {
+        std::vector<size_t> strides(shape.size());
+        size_t stride = 1;
+        for (size_t d = shape.size(); d-- > 0;) {
+            strides[d] = stride;
+            stride *= shape[d];
+        }
+        return strides;
+    }
+
+    Tensor Tensor::Empty(const Device& device, const Shape& shape, DType dtype, const std::string& label) {
+        if (!device.IsValid()) {
+            KRNL_ERROR("Tensor::Empty: invalid device");
+            return {};
+        }
+        if (shape.size() > kMaxRank) {
+            KRNL_ERROR("Tensor::Empty: rank " << shape.size() << " exceeds " << kMaxRank);
+            return {};
+        }
+        // Zero-size tensors still get a (minimal) buffer so they are valid
+        size_t bytes = std::max<size_t>(ShapeElementCount(shape) * DTypeSize(dtype), 4);
+        auto storage = std::make_shared<Buffer>(Buffer::Suballocate(device, bytes, kTensorUsage, label));
+        return Tensor(device, std::move(storage), shape, ContiguousStrides(shape), 0, dtype);
+    }
+
+    Tensor Tensor::FromHost(const Device& device, const void* data, const Shape& shape, DType dtype, const std::string& label) {
+        Tensor t = Empty(device, shape, dtype, label);
+        if (t.IsValid() && t.GetByteSize() > 0) {
+            t.m_Storage->WriteBuffer(data, t.GetByteSize());
+        }
+        return t;
+    }
+
+    Tensor Tensor::FromHost(const Device& device, const std::vector<float>& data, const Shape& shape, const std::string& label) {
+        if (data.size() != ShapeElementCount(shape)) {
+            KRNL_ERROR("Tensor::FromHost: " << data.size() << " values for shape " << ShapeString(shape));
+            return {};
+        }
+        return FromHost(device, data.data(), shape, DType::F32, label);
+    }
+
+    Tensor Tensor::Zeros(const Device& device, const Shape& shape, DType dtype, const std::string& label) {
+        // All three dtypes are zero as all-zero bits
+        std::vector<uint32_t> zeros(ShapeElementCount(shape));
+        return FromHost(device, zeros.data(), shape, dtype, label);
+    }
+
+    Tensor Tensor::FromBuffer(const Device& device, const Buffer& buffer, const Shape& shape, DType dtype, size_t byteOffset) {
+        const size_t bytes = ShapeElementCount(shape) * DTypeSize(dtype);
+        if (shape.size() > kMaxRank || byteOffset % DTypeSize(dtype) != 0 || byteOffset + bytes > buffer.GetSize()) {
+            KRNL_ERROR("Tensor::FromBuffer: shape " << ShapeString(shape) << " at offset " << byteOffset
+                << " doesn't fit a buffer of " << buffer.GetSize() << " bytes");
+            return {};
+        }
+        return Tensor(device, std::make_shared<Buffer>(buffer), shape, ContiguousStrides(shape), byteOffset, dtype);
+    }
+
+    Tensor Tensor::view(Shape shape, std::vector<size_t> strides, size_t byteOffset) const {
+        return Tensor(*m_Device, m_Storage, std::move(shape), std::move(strides), byteOffset, m_DType);
+    }
+
+    bool Tensor::IsContiguous() const {
+        size_t expected = 1;
+        for (size_t d = m_Shape.size(); d-- > 0;) {
+            if (m_Shape[d] != 1 && m_Strides[d] != expected) {
+                return false;
+            }
+            expected *= m_Shape[d];
+        }
+        return true;
+    }
+
+    Tensor Tensor::Slice(size_t dim, size_t start, size_t end, size_t step) const {
+        if (!IsValid() || dim >= GetRank() || step == 0 || start > end || end > m_Shape[dim]) {
+            KRNL_ERROR("Tensor::Slice: invalid range [" << start << ", " << end << ") step " << step
+                << " of dim " << dim << " in " << ShapeString(m_Shape));
+            return {};
+        }
+        Shape shape = m_Shape;
+        std::vector<size_t> strides = m_Strides;
+        shape[dim] = (end - start + step - 1) / step;
+        strides[dim] *= step;
+        return view(std::move(shape), std::move(strides), m_ByteOffset + start * m_Strides[dim] * DTypeSize(m_DType));
+    }
+
+    Tensor Tensor::Select(size_t dim, size_t index) const {
+        if (!IsValid() || dim >= GetRank() || index >= m_Shape[dim]) {
+            KRNL_ERROR("Tensor::Select: index " << index << " of dim " << dim << " out of range in " << ShapeString(m_Shape));
+            return {};
+        }
+        Shape shape = m_Shape;
+        std::vector<size_t> strides = m_Strides;
+        shape.erase(shape.begin() + dim);
+        strides.erase(strides.begin() + dim);
+        return view(std::move(shape), std::move(strides), m_ByteOffset + index * m_Strides[dim] * DTypeSize(m_DType));
+    }
+
+    Tensor Tensor::Transpose(size_t dim0, size_t dim1) const {
+        if (!IsValid() || dim0 >= GetRank() || dim1 >= GetRank()) {
+            KRNL_ERROR("Tensor::Transpose: dims " << dim0 << ", " << dim1 << " out of range in " << ShapeString(m_Shape));
+            return {};
+        }
+        Shape shape = m_Shape;
+        std::vector<size_t> strides = m_Strides;
+        std::swap(shape[dim0], shape[dim1]);
+        std::swap(strides[dim0], strides[dim1]);
+        return view(std::move(shape), std::move(strides), m_ByteOffset);
+    }
+
+    Tensor Tensor::Permute(const std::vector<size_t>& dims) const {
+        std::vector<bool> seen(GetRank(), false);
+        bool valid = IsValid() && dims.size() == GetRank();
+        for (size_t i = 0; valid && i < dims.size(); ++i) {
+            valid = dims[i] < GetRank() && !seen[dims[i]];
+            if (valid) {
+                seen[dims[i]] = true;
+            }
+        }
+        if (!valid) {
+            KRNL_ERROR("Tensor::Permute: " << ShapeString(dims) << " is not a permutation of the dims of " << ShapeString(m_Shape));
+            return {};
+        }
+        Shape shape(dims.size());
+        std::vector<size_t> strides(dims.size());
+        for (size_t i = 0; i < dims.size(); ++i) {
+            shape[i] = m_Shape[dims[i]];
+            strides[i] = m_Strides[dims[i]];
+        }
+        return view(std::move(shape), std::move(strides), m_ByteOffset);
+    }
+
+    Tensor Tensor::Squeeze() const {
+        if (!IsValid()) {
+            return {};
+        }
+        Shape shape;
+        std::vector<size_t> strides;
+        for (size_t d = 0; d < GetRank(); ++d) {
+            if (m_Shape[d] != 1) {
+                shape.push_back(m_Shape[d]);
+                strides.push_back(m_Strides[d]);
+            }
+        }
+        return view(std::move(shape), std::move(strides), m_ByteOffset);
+    }
+
+    Tensor Tensor::Squeeze(size_t dim) const {
+        if (!IsValid() || dim >= GetRank() || m_Shape[dim] != 1) {
+            KRNL_ERROR("Tensor::Squeeze: dim " << dim << " of " << ShapeString(m_Shape) << " is not of size 1");
+            return {};
+        }
+        return Select(dim, 0);
+    }
+
+    Tensor Tensor::Unsqueeze(size_t dim) const {
+        if (!IsValid() || dim > GetRank() || GetRank() == kMaxRank) {
+            KRNL_ERROR("Tensor::Unsqueeze: can't insert dim " << dim << " into " << ShapeString(m_Shape));
+            return {};
+        }
+        Shape shape = m_Shape;
+        std::vector<size_t> strides = m_Strides;
+        // Any stride works for a size-1 dimension; this one keeps contiguous tensors contiguous
+        size_t stride = dim < GetRank() ? m_Shape[dim] * m_Strides[dim] : 1;
+        shape.insert(shape.begin() + dim, 1);
+        strides.insert(strides.begin() + dim, stride);
+        return view(std::move(shape), std::move(strides), m_ByteOffset);
+    }
+
+    Tensor Tensor::BroadcastTo(const Shape& shape) const {
+        if (!IsValid() || shape.size() < GetRank() || shape.size() > kMaxRank) {
+            KRNL_ERROR("Tensor::BroadcastTo: can't broadcast " << ShapeString(m_Shape) << " to " << ShapeString(shape));
+            return {};
+        }
+        const size_t lead = shape.size() - GetRank();
+        std::vector<size_t> strides(shape.size(), 0);
+        for (size_t d = 0; d < GetRank(); ++d) {
+            if (m_Shape[d] == shape[lead + d]) {
+                strides[lead + d] = m_Strides[d];
+            }
+            else if (m_Shape[d] != 1) {
+                KRNL_ERROR("Tensor::BroadcastTo: can't broadcast " << ShapeString(m_Shape) << " to " << ShapeString(shape));
+                return {};
+            }
+        }
+        return view(shape, std::move(strides), m_ByteOffset);
+    }
+
+    Tensor Tensor::Reshape(const Shape& shape) const {
+        if (!IsValid()) {
+            return {};
+        }
+        std::vector<size_t> strides;
+        if (ShapeElementCount(shape) == GetElementCount() && shape.size() <= kMaxRank && viewStrides(m_Shape, m_Strides, shape, strides)) {
+            return view(shape, std::move(strides), m_ByteOffset);
+        }
+        CommandList cmd(*m_Device);
+        Tensor t = Reshape(cmd, shape);
+        cmd.Submit();
+        return t;
+    }
+
+    Tensor Tensor::Reshape(CommandList& cmd, const Shape& shape) const {
+        if (!IsValid()) {
+            return {};
+        }
+        if (ShapeElementCount(shape) != GetElementCount() || shape.size() > kMaxRank) {
+            KRNL_ERROR("Tensor::Reshape: can't reshape " << ShapeString(m_Shape) << " to " << ShapeString(shape));
+            return {};
+        }
+        std::vector<size_t> strides;
+        if (viewStrides(m_Shape, m_Strides, shape, strides)) {
+            return view(shape, std::move(strides), m_ByteOffset);
+        }
+        Tensor dense = TensorOps::Copy(cmd, *this);
+        return dense.IsValid() ? dense.view(shape, ContiguousStrides(shape), dense.m_ByteOffset) : dense;
+    }
+
+    Tensor Tensor::Contiguous() const {
+        if (!IsValid() || IsContiguous()) {
+            return *this;
+        }
+        return TensorOps::Copy(*this);
+    }
+
+    Tensor Tensor::Contiguous(CommandList& cmd) const {
+        if (!IsValid() || IsContiguous()) {
+            return *this;
+        }
+        return TensorOps::Copy(cmd, *this);
+    }
+
+    void Tensor::Write(const void* data, size_t bytes) {
+        if (!IsValid() || !IsContiguous() || bytes > GetByteSize() || bytes % 4 != 0) {
+            KRNL_ERROR("Tensor::Write: " << bytes << " bytes into a " << (IsContiguous() ? "" : "non-contiguous ")
+                << "tensor of " << GetByteSize());
+            return;
+        }
+        if (bytes > 0) {
+            m_Storage->WriteBuffer(data, bytes, m_ByteOffset);
+        }
+    }
+
+    Future<std::vector<std::byte>> Tensor::ReadAsync() const {
+        if (!IsValid()) {
+            KRNL_ERROR("Tensor::ReadAsync: invalid tensor");
+            return readyBytes();
+        }
+        Tensor dense = Contiguous();
+        if (dense.GetByteSize() == 0) {
+            return readyBytes();
+        }
+
+        // Same path as Buffer::ReadAsync, over the tensor's range only
+        auto state = std::make_shared<detail::FutureState<std::vector<std::byte>>>();
+        m_Device->GetUploadBatch().Flush();
+        wgpu::Future f = m_Device->GetStagingPool().readbackInto(dense.m_Storage->GetNative(), dense.GetByteSize(),
+            dense.m_Storage->GetOffset() + dense.m_ByteOffset, m_Device->getQueue(),
+            [state](const void* data, size_t size) {
+                const std::byte* bytes = static_cast<const std::byte*>(data);
+                std::lock_guard<std::mutex> l(state->mutex);
+                state->value.assign(bytes, bytes + size);
+            });
+        return Future<std::vector<std::byte>>(state, &m_Device->GetInstance(), f);
+    }
+
+    /* -----------------------
+       TensorOps
+       ----------------------- */
+
+    std::optional<Shape> TensorOps::BroadcastShapes(const Shape& a, const Shape& b) {
+        Shape out(std::max(a.size(), b.size()));
+        for (size_t i = 0; i < out.size(); ++i) {
+            // Aligned from the last dimension; missing leading dims count as 1
+            size_t da = i < a.size() ? a[a.size() - 1 - i] : 1;
+            size_t db = i < b.size() ? b[b.size() - 1 - i] : 1;
+            if (da != db && da != 1 && db != 1) {
+                return std::nullopt;
+            }
+            out[out.size() - 1 - i] = da == 1 ? db : da;
+        }
+        return out;
+    }
+
+    Tensor TensorOps::Binary(BinaryOp op, const Tensor& a, const Tensor& b) {
+        if (!a.IsValid()) {
+            KRNL_ERROR(binaryName(op) << ": invalid operand");
+            return {};
+        }
+        CommandList cmd(a.GetDevice());
+        Tensor out = Binary(cmd, op, a, b);
+        cmd.Submit();
+        return out;
+    }
+
+    Tensor TensorOps::Binary(CommandList& cmd, BinaryOp op, const Tensor& a, const Tensor& b) {
+        if (!a.IsValid() || !b.IsValid() || &a.GetDevice() != &b.GetDevice() || a.GetDType() != b.GetDType()) {
+            KRNL_ERROR(binaryName(op) << ": operands must be valid tensors of one device and dtype");
+            return {};
+        }
+        std::optional<Shape> shape = BroadcastShapes(a.GetShape(), b.GetShape());
+        if (!shape || shape->size() > Tensor::kMaxRank) {
+            KRNL_ERROR(binaryName(op) << ": shapes " << ShapeString(a.GetShape()) << " and " << ShapeString(b.GetShape())
+                << " don't broadcast");
+            return {};
+        }
+
+        Tensor out = Tensor::Empty(a.GetDevice(), *shape, a.GetDType(), binaryName(op));
+        const size_t count = out.GetElementCount();
+        if (!out.IsValid() || count == 0) {
+            return out;
+        }
+
+        // Views of one tensor share a binding; other overlapping storage gets a private copy
+        const bool aliased = detail::SameStorage(a, b);
+        Tensor ba = a.BroadcastTo(*shape);
+        Tensor bb = !aliased && detail::StorageOverlaps(a, b) ? Copy(cmd, b).BroadcastTo(*shape) : b.BroadcastTo(*shape);
+        Info info{};
+        info[0] = static_cast<uint32_t>(count);
+        info[1] = static_cast<uint32_t>(shape->size());
+        std::copy(shape->begin(), shape->end(), info.begin() + kShapeAt);
+        if (count > std::numeric_limits<uint32_t>::max() || !packOperand(info, kOperandAt[0], ba) || !packOperand(info, kOperandAt[1], bb)) {
+            KRNL_ERROR(binaryName(op) << ": element indices exceed 32 bits");
+            return {};
+        }
+        info[kOutAt] = 0;
+
+        if (aliased) {
+            encodeElementwise(cmd, binarySource(op, a.GetDType(), true), binaryName(op), out, { &ba }, info);
+        }
+        else {
+            encodeElementwise(cmd, binarySource(op, a.GetDType(), false), binaryName(op), out, { &ba, &bb }, info);
+        }
+        return out;
+    }
+
+    Tensor TensorOps::Copy(const Tensor& src) {
+        if (!src.IsValid()) {
+            KRNL_ERROR("tensor_copy: invalid operand");
+            return {};
+        }
+        CommandList cmd(src.GetDevice());
+        Tensor out = Copy(cmd, src);
+        cmd.Submit();
+        return out;
+    }
+
+    Tensor TensorOps::Copy(CommandList& cmd, const Tensor& src) {
+        if (!src.IsValid()) {
+            KRNL_ERROR("tensor_copy: invalid operand");
+            return {};
+        }
+        Tensor out = Tensor::Empty(src.GetDevice(), src.GetShape(), src.GetDType(), "tensor_copy");
+        const size_t count = out.GetElementCount();
+        if (!out.IsValid() || count == 0) {
+            return out;
+        }
+
+        Info info{};
+        info[0] = static_cast<uint32_t>(count);
+        info[1] = static_cast<uint32_t>(src.GetRank());
+        std::copy(src.GetShape().begin(), src.GetShape().end(), info.begin() + kShapeAt);
+        if (count > std::numeric_limits<uint32_t>::max() || !packOperand(info, kOperandAt[0], src)) {
+            KRNL_ERROR("tensor_copy: element indices exceed 32 bits");
+            return {};
+        }
+        info[kOutAt] = 0;
+
+        encodeElementwise(cmd, copySource(src.GetDType()), "tensor_copy", out, { &src }, info);
+        return out;
+    }
+
+} // namespace krnl
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "core/commandlist.hpp"
+#include "core/parameterset.hpp"
+#include "tensor/tensor.hpp"
+
+// Internal helpers shared by the tensor kernels (tensor.cpp, gemm.cpp, expr.cpp)
+namespace krnl::detail {
+
+    inline const BufferUsageType kTensorUsage = BufferUsageType::Storage | BufferUsageType::CopySrc | BufferUsageType::CopyDst;
+
+    // WGSL strided indexing over an info array: info[1] is the rank, info[2..] the output
+    // shape, and an operand at info[base] is its element offset followed by one stride per
+    // dimension. Expects `info` to be declared before it.
+    inline constexpr const char* kElementIndexWGSL = R"(
+            // Element 'linear' (row-major over the output shape) of the operand described at info[base]
+            fn elementIndex(base : u32, linear : u32) -> u32 {
+                var rem = linear;
+                var index = info[base];
+                for (var d = info[1]; d > 0u; d = d - 1u) {
+                    let extent = info[1u + d];
+                    index = index + (rem % extent) * info[base + d];
+                    rem = rem / extent;
+                }
+                return index;
+            }
+        )";
+
+    // "[2, 3]"
+    std::string ShapeString(const Shape& shape);
+
+    // Whether the storage of a and b shares bytes of one wgpu::Buffer. Dawn rejects
+    // overlapping ranges bound as writable storage in one dispatch.
+    bool StorageOverlaps(const Tensor& a, const Tensor& b);
+    // Whether both are bound as exactly the same range (views of one tensor)
+    bool SameStorage(const Tensor& a, const Tensor& b);
+
+    // Record one dispatch of 'source' (entry point main) into cmd, inside its open compute
+    // pass if there is one. Binding 0 is a buffer holding 'params' (storage or uniform),
+    // binding 1 out's storage, then the inputs' storage in order. The parameter buffer and
+    // every operand's storage are retained by cmd.
+    void EncodeTensorKernel(CommandList& cmd, const std::string& source, const char* label,
+        const Tensor& out, const std::vector<const Tensor*>& inputs,
+        const void* params, size_t paramBytes, BufferBindingType paramBinding,
+        uint32_t groupsX, uint32_t groupsY = 1);
+
+} // namespace krnl::detail
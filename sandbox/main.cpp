@@ -1,20 +1,27 @@
 #include <krnl.hpp>
 #include <iostream>
+#include <string>
+#include <vector>
 
 int main()
 {
 	krnl::Instance instance = krnl::Instance();
 	krnl::Device device = krnl::Device(instance);
+	if (!device.IsValid())
+		return 1;
 
 	krnl::Shader computeShader = krnl::Shader::loadWGSL(device, R"(
+			override WORKGROUP_SIZE : u32 = 64;
 			@group(0) @binding(0) var<storage,read> inputBuffer: array<f32,64>;
 			@group(0) @binding(1) var<storage,read_write> outputBuffer: array<f32,64>;
-			@compute @workgroup_size(32)
+			@compute @workgroup_size(WORKGROUP_SIZE)
 			fn main(@builtin(global_invocation_id) id: vec3<u32>) {
 				// Apply the function f to the buffer element at index id.x:
-				outputBuffer[id.x] = inputBuffer[id.x] + 1;
+				if (id.x < 64u) {
+					outputBuffer[id.x] = inputBuffer[id.x] + 1;
+				}
 			}
-		)");
+	)");
 
 	size_t bufferSize = 64 * sizeof(float);
 	krnl::Buffer input(device, bufferSize, krnl::BufferUsageType::Storage | krnl::BufferUsageType::CopyDst, "input");
@@ -26,13 +33,29 @@ int main()
 	paramEntries.push_back({ output, krnl::BufferBindingType::Storage });
 	krnl::ParameterSet params(device, paramEntries);
 
-	auto pipeline = krnl::Pipeline::CreateCompute(
-		device,
-		computeShader,
-		params,
-		"main",
-		"ComputeAddOne"
-	);
+	// One pipeline per candidate workgroup size, set through the override constant; the
+	// autotuner times them once per adapter and remembers the fastest in its results file
+	std::vector<uint32_t> workgroupSizes = { 32, 64, 128, 256 };
+	std::vector<krnl::Pipeline> pipelines;
+	std::vector<krnl::Autotuner::Variant> variants;
+	pipelines.reserve(workgroupSizes.size());
+	for (uint32_t size : workgroupSizes)
+	{
+		const krnl::Pipeline* candidate = &pipelines.emplace_back(krnl::Pipeline::CreateCompute(
+			device, computeShader, params, "main", "ComputeAddOne", { { "WORKGROUP_SIZE", double(size) } }));
+		variants.push_back({ "wg" + std::to_string(size), [candidate, size](krnl::CommandList& cmd) {
+			cmd.BeginComputePass();
+			candidate->encodeDispatch(cmd, (64 + size - 1) / size);
+			cmd.EndComputePass();
+		} });
+	}
+	std::string chosen = krnl::Autotuner::Default()
+		.Select(device, "sandbox_add_one", krnl::Autotuner::SizeBucket({ 64 }), variants)
+		.value_or(variants[0].name);
+	size_t best = 0;
+	while (variants[best].name != chosen)
+		++best;
+	std::cout << "workgroup size " << workgroupSizes[best] << " (" << krnl::Autotuner::Default().GetFile().string() << ")" << std::endl;
 
 	// Prepare input data
 	std::vector<float> inputData(bufferSize / sizeof(float));
@@ -43,10 +66,7 @@ int main()
 	input.WriteBuffer(inputData.data(), bufferSize, 0);
 
 	krnl::CommandList cmd(device);
-	cmd.BeginComputePass();
-	uint32_t workgroups = (64 + 31) / 32;
-	pipeline.encodeDispatch(cmd, workgroups);
-	cmd.EndComputePass();
+	variants[best].encode(cmd);
 
 	cmd.CopyBufferToBuffer(output, map, bufferSize);
 
@@ -59,10 +79,5 @@ int main()
 	for (size_t i = 0; i < inputData.size(); ++i)
 		std::cout << i + 1 << " : input " << inputData[i] << " became " << outputData[i] << std::endl;
 
-	while (true)
-	{
-		instance.ProcessEvents();
-	}
-	
     return 0;
 }